@@ -14,14 +14,17 @@
 #include "application.h"
 #include <msg/imu.h>
 #include <msg/stamped.h>
+#include <msg/registration_stats.h>
+#include <msg/preprocessing_stats.h>
 #include <util/config/config_manager.h>
 #include <util/logging/logger.h>
 #include <util/runner.h>
+#include <util/thread_pool.h>
 #include <registration/registration.h>
 #include <preprocessing/preprocessing.h>
 #include <callback/cloud_callback.h>
 #include <callback/map_thread.h>
-#include <map/local_map.h>
+#include <map/local_map_snapshots.h>
 #include <map/global_map.h>
 #include <comm/queue_bridge.h>
 #include <comm/buffered_receiver.h>
@@ -35,11 +38,52 @@ using namespace std::chrono_literals;
 
 using fastsense::callback::CloudCallback;
 using fastsense::callback::MapThread;
+using fastsense::callback::MapExport;
 using fastsense::map::GlobalMap;
 using fastsense::map::LocalMap;
+using fastsense::map::LocalMapSnapshots;
 using fastsense::registration::Registration;
+using fastsense::registration::RegistrationOptions;
 using fastsense::preprocessing::Preprocessing;
 
+/**
+ * @brief Thread settings from their configuration
+ *
+ * @param thread_config configuration of the thread
+ * @param suffix appended to the name, for threads that share a configuration
+ */
+static util::ThreadSettings thread_settings(ThreadConfig& thread_config, const std::string& suffix = "")
+{
+    return util::ThreadSettings::parse(thread_config.name() + suffix, thread_config.cpus(), thread_config.priority(), thread_config.pool_priority());
+}
+
+/**
+ * @brief Parameters of the registration from its configuration
+ */
+static RegistrationOptions registration_options(RegistrationConfig& registration_config)
+{
+    RegistrationOptions options;
+    options.max_iterations = registration_config.max_iterations();
+    options.it_weight_gradient = registration_config.it_weight_gradient();
+    options.epsilon = registration_config.epsilon();
+    options.point_budget = registration_config.point_budget();
+    options.solver = Registration::parse_solver_mode(registration_config.solver());
+    options.lm_damping = registration_config.lm_damping();
+    options.lm_translation_epsilon = registration_config.lm_translation_epsilon();
+    options.lm_rotation_epsilon = registration_config.lm_rotation_epsilon();
+    options.motion_history = registration_config.motion_history();
+    options.motion_imu_weight = registration_config.motion_imu_weight();
+    options.prior_weight = registration_config.prior_weight();
+    options.skip_translation = registration_config.skip_translation();
+    options.skip_rotation = registration_config.skip_rotation();
+    options.max_skipped = registration_config.max_skipped();
+    options.refine_iterations = registration_config.refine_iterations();
+    options.latency_budget = registration_config.latency_budget();
+    options.latency_min_iterations = registration_config.latency_min_iterations();
+    options.latency_min_points = registration_config.latency_min_points();
+    return options;
+}
+
 Application::Application()
     : config{ConfigManager::config()}
 {
@@ -47,8 +91,6 @@ Application::Application()
 
 std::unique_ptr<util::ProcessThread> Application::init_imu(msg::ImuStampedBuffer::Ptr imu_buffer)
 {
-    std::chrono::milliseconds recv_timeout(config.bridge.recv_timeout());
-
     if (config.bridge.use_from())
     {
         Logger::info("Launching BufferedImuReceiver");
@@ -61,7 +103,6 @@ std::unique_ptr<util::ProcessThread> Application::init_imu(msg::ImuStampedBuffer
         return std::make_unique<comm::BufferedImuStampedReceiver>(
                    config.bridge.host_from(),
                    config.bridge.imu_port_from(),
-                   recv_timeout,
                    imu_buffer);
     }
     else
@@ -73,21 +114,31 @@ std::unique_ptr<util::ProcessThread> Application::init_imu(msg::ImuStampedBuffer
 
 std::unique_ptr<util::ProcessThread> Application::init_lidar(msg::PointCloudPtrStampedBuffer::Ptr pcl_buffer)
 {
-    std::chrono::milliseconds recv_timeout(config.bridge.recv_timeout());
-
     if (config.bridge.use_from())
     {
         Logger::info("Launching BufferedPCLReceiver");
         return std::make_unique<comm::BufferedPclStampedReceiver>(
                    config.bridge.host_from(),
                    config.bridge.pcl_port_from(),
-                   recv_timeout,
                    pcl_buffer);
     }
-    else
+    else if (config.lidar.source() == "pcap")
+    {
+        Logger::info("Launching Velodyne Pcap Driver replaying ", config.lidar.pcap_file());
+        return std::make_unique<driver::VelodynePcapDriver>(config.lidar.pcap_file(), config.lidar.port(),
+                                                            config.lidar.replay_speed(), pcl_buffer);
+    }
+    else if (config.lidar.source() == "velodyne")
     {
         Logger::info("Launching Velodyne Driver");
-        return std::make_unique<driver::VelodyneDriver>(config.lidar.port(), pcl_buffer);
+        auto driver = std::make_unique<driver::VelodyneDriver>(config.lidar.port(), pcl_buffer,
+                                                               config.lidar.receive_buffer(), config.lidar.packet_ring_size());
+        driver->configure_decode(thread_settings(config.threads.lidar_decode));
+        return driver;
+    }
+    else
+    {
+        throw std::runtime_error("Unknown lidar source '" + config.lidar.source() + "', expected 'velodyne' or 'pcap'");
     }
 }
 
@@ -101,17 +152,23 @@ int Application::run()
     sigaddset(&signal_set, SIGTERM);
     sigprocmask(SIG_BLOCK, &signal_set, nullptr);
 
+    // before any stage is created, the voxel reduction sizes its partitions by the pool
+    util::ThreadPool::get_instance().configure(config.threads.pool_size(), thread_settings(config.threads.pool));
+
     auto imu_buffer = std::make_shared<msg::ImuStampedBuffer>(config.imu.bufferSize());
     auto imu_bridge_buffer = std::make_shared<msg::ImuStampedBuffer>(config.imu.bufferSize());
     auto pointcloud_buffer = std::make_shared<msg::PointCloudPtrStampedBuffer>(config.lidar.bufferSize());
-    auto pointcloud_bridge_buffer = std::make_shared<msg::PointCloudPtrStampedBuffer>(config.lidar.bufferSize());
+    // the registration has to see waiting scans to drop or refine them, instead of losing them to forced pushes
+    auto pointcloud_bridge_buffer = std::make_shared<buffer::ScanBufferStampedBuffer>(std::max<size_t>(config.registration.queue_size(), 1));
     auto pointcloud_send_buffer = std::make_shared<msg::PointCloudPtrStampedBuffer>(1);
 
     util::ProcessThread::UPtr imu_driver = init_imu(imu_buffer);
     util::ProcessThread::UPtr lidar_driver = init_lidar(pointcloud_buffer);
+    lidar_driver->configure(thread_settings(config.threads.lidar));
 
     bool send = config.bridge.use_to();
     comm::QueueBridge<msg::ImuStamped, true> imu_bridge{imu_buffer, imu_bridge_buffer, config.bridge.imu_port_to(), send};
+    imu_bridge.configure(thread_settings(config.threads.imu_bridge));
 
     bool send_original = config.bridge.send_original();
     bool send_preprocessed = config.bridge.send_preprocessed();
@@ -123,20 +180,29 @@ int Application::run()
 
     const float& point_scale = config.lidar.pointScale();
 
+    auto command_queue = fastsense::hw::FPGAManager::create_command_queue();
+
+    // device buffers of the preprocessed scans, shared by the registration and the map thread
+    auto scan_pool = std::make_shared<buffer::ScanBufferPool>(command_queue);
+
     Preprocessing preprocessing{pointcloud_buffer,
                                 pointcloud_bridge_buffer,
+                                scan_pool,
                                 pointcloud_send_buffer,
                                 send_original,
                                 send_preprocessed,
-                                point_scale};
-
-    auto command_queue = fastsense::hw::FPGAManager::create_command_queue();
-
-    Registration registration{command_queue,
-                              imu_bridge_buffer,
-                              config.registration.max_iterations(),
-                              config.registration.it_weight_gradient(),
-                              config.registration.epsilon()};
+                                point_scale,
+                                config.preprocessing.threads(),
+                                config.preprocessing.median_window(),
+                                config.preprocessing.outlier_distance(),
+                                config.preprocessing.outlier_neighbors(),
+                                config.preprocessing.column_step(),
+                                config.preprocessing.target_points(),
+                                config.preprocessing.target_tolerance(),
+                                config.preprocessing.max_voxel_size()};
+    preprocessing.configure(thread_settings(config.threads.preprocessing));
+
+    Registration registration{command_queue, imu_bridge_buffer, registration_options(config.registration)};
 
     int tau = config.slam.max_distance();
     int max_weight = config.slam.max_weight() * WEIGHT_RESOLUTION;
@@ -149,12 +215,20 @@ int Application::run()
     assert(initial_weight <= std::numeric_limits<TSDFEntry::WeightType>::max());
 
     auto transform_buffer = std::make_shared<util::ConcurrentRingBuffer<msg::TransformStamped>>(16);
+    auto registration_stats_buffer = std::make_shared<msg::RegistrationStatsStampedBuffer>(16);
+    registration.set_stats_buffer(registration_stats_buffer);
+    auto preprocessing_stats_buffer = std::make_shared<msg::PreprocessingStatsStampedBuffer>(16);
+    preprocessing.set_stats_buffer(preprocessing_stats_buffer);
     auto vis_buffer = std::make_shared<util::ConcurrentRingBuffer<Matrix4f>>(2);
 
-    std::mutex map_mutex;
-
     comm::QueueBridge<msg::TransformStamped, true> transform_bridge{transform_buffer, nullptr, config.bridge.transform_port_to()};
     comm::QueueBridge<msg::PointCloudPtrStamped, true> pointcloud_send_bridge{pointcloud_send_buffer, nullptr, config.bridge.pcl_port_to()};
+    comm::QueueBridge<msg::RegistrationStatsStamped, true> registration_stats_bridge{registration_stats_buffer, nullptr, config.bridge.registration_port_to(), send};
+    comm::QueueBridge<msg::PreprocessingStatsStamped, true> preprocessing_stats_bridge{preprocessing_stats_buffer, nullptr, config.bridge.preprocessing_port_to(), send};
+    transform_bridge.configure(thread_settings(config.threads.bridges, "_tf"));
+    pointcloud_send_bridge.configure(thread_settings(config.threads.bridges, "_pcl"));
+    registration_stats_bridge.configure(thread_settings(config.threads.bridges, "_reg"));
+    preprocessing_stats_bridge.configure(thread_settings(config.threads.bridges, "_pre"));
 
     gpiod::chip button_chip(config.gpio.button_chip());
     ui::Button button{button_chip.get_line(config.gpio.button_line())};
@@ -223,6 +297,8 @@ int Application::run()
         pointcloud_buffer->clear();
         pointcloud_bridge_buffer->clear();
         transform_buffer->clear();
+        registration_stats_buffer->clear();
+        preprocessing_stats_buffer->clear();
         vis_buffer->clear();
 
         std::ostringstream filename;
@@ -233,18 +309,21 @@ int Application::run()
                               std::filesystem::path(config.slam.map_path()) / filename.str(),
                               tau, initial_weight);
 
-        auto local_map = std::make_shared<LocalMap>(
-                             config.slam.map_size_x(),
-                             config.slam.map_size_y(),
-                             config.slam.map_size_z(),
-                             global_map, command_queue);
+        // the current copy, one for the update and one for an old version that is still pinned.
+        // The export pins the current version only while it copies it, so it needs no copy of its own
+        auto local_map = std::make_shared<LocalMapSnapshots>(
+                             std::make_unique<LocalMap>(
+                                 config.slam.map_size_x(),
+                                 config.slam.map_size_y(),
+                                 config.slam.map_size_z(),
+                                 global_map, command_queue));
 
+        MapExport map_export{local_map, config.bridge.tsdf_port_to(), point_scale};
         MapThread map_thread{local_map,
-                             map_mutex,
                              config.slam.map_update_period(),
                              config.slam.map_update_position_threshold(),
-                             config.bridge.tsdf_port_to(),
-                             point_scale,
+                             config.slam.map_update_max_batch(),
+                             map_export,
                              command_queue};
         CloudCallback cloud_callback{registration,
                                      pointcloud_bridge_buffer,
@@ -255,8 +334,10 @@ int Application::run()
                                      send_after_registration,
                                      command_queue,
                                      map_thread,
-                                     map_mutex,
                                      point_scale};
+        map_thread.configure(thread_settings(config.threads.map));
+        map_export.configure(thread_settings(config.threads.map_export));
+        cloud_callback.configure(thread_settings(config.threads.registration));
 
         {
             Runner run_lidar_driver(*lidar_driver);
@@ -265,6 +346,9 @@ int Application::run()
             Runner run_imu_bridge(imu_bridge);
             Runner run_transform_bridge(transform_bridge);
             Runner run_pointcloud_send_bridge(pointcloud_send_bridge);
+            Runner run_registration_stats_bridge(registration_stats_bridge);
+            Runner run_preprocessing_stats_bridge(preprocessing_stats_bridge);
+            Runner run_map_export(map_export);
             Runner run_map_thread(map_thread);
 
             // clear any remaining messages FIXME: WHY IS THIS NECESSARY???
@@ -274,9 +358,12 @@ int Application::run()
             pointcloud_buffer->clear();
             pointcloud_bridge_buffer->clear();
             transform_buffer->clear();
+            registration_stats_buffer->clear();
+            preprocessing_stats_buffer->clear();
             vis_buffer->clear();
 
             Runner run_cloud_callback{cloud_callback};
+            util::PipelineOccupancy::get_instance().reset();
 
             Logger::info("SLAM started! Running...");
             std::this_thread::sleep_for(2s);
@@ -285,10 +372,10 @@ int Application::run()
                 return 0;
             }
         }
-        Logger::info("SLAM stopped!");
+        Logger::info("SLAM stopped! Pipeline occupancy:\n", util::PipelineOccupancy::get_instance().to_string());
         Logger::info("Write local and global map...");
         // save Map to Disk
-        local_map->write_back();
+        local_map->pin()->write_back();
         Logger::info("Local and global map saved!");
         local_map.reset();
         global_map.reset();
@@ -6,6 +6,7 @@
  */
 
 #include <driver/lidar/velodyne.h>
+#include <driver/lidar/velodyne_pcap.h>
 #include <driver/imu/imu.h>
 #include <msg/imu.h>
 #include <msg/point_cloud.h>
@@ -17,15 +17,14 @@ using fastsense::util::logging::Logger;
 using fastsense::buffer::InputBuffer;
 
 CloudCallback::CloudCallback(Registration& registration,
-                             const std::shared_ptr<PointCloudBuffer>& cloud_buffer,
-                             const std::shared_ptr<LocalMap>& local_map,
+                             const ScanBufferStampedBuffer::Ptr& cloud_buffer,
+                             const LocalMapSnapshots::Ptr& local_map,
                              const std::shared_ptr<GlobalMap>& global_map,
                              const msg::TransformStampedBuffer::Ptr& transform_buffer,
                              const msg::PointCloudPtrStampedBuffer::Ptr& pointcloud_buffer,
                              bool send_after_registration,
                              const fastsense::CommandQueuePtr& q,
                              MapThread& map_thread,
-                             std::mutex& map_mutex,
                              float point_scale)
     : ProcessThread(),
       registration{registration},
@@ -39,8 +38,8 @@ CloudCallback::CloudCallback(Registration& registration,
       first_iteration{true},
       q{q},
       map_thread{map_thread},
-      map_mutex{map_mutex},
-      point_scale{point_scale}
+      point_scale{point_scale},
+      occupancy{"registration"}
 {
 
 }
@@ -50,72 +49,93 @@ void CloudCallback::set_global_map(const std::shared_ptr<GlobalMap>& global_map)
     this->global_map = global_map;
 }
 
-void CloudCallback::set_local_map(const std::shared_ptr<LocalMap>& local_map)
+void CloudCallback::set_local_map(const LocalMapSnapshots::Ptr& local_map)
 {
     this->local_map = local_map;
 }
 
 void CloudCallback::thread_run()
 {
+    fastsense::buffer::ScanBufferStamped scan;
     fastsense::msg::PointCloudPtrStamped point_cloud;
 
-    std::unique_ptr<InputBuffer<PointHW>> scan_point_buffer;
     auto& eval = RuntimeEvaluator::get_instance();
 #ifdef TIME_MEASUREMENT
     int cnt = 0;
 #endif
+    auto token = stop_token();
+    size_t overwritten = cloud_buffer->overwritten();
     while (running)
     {
-        if (!cloud_buffer->pop_nb(&point_cloud, DEFAULT_POP_TIMEOUT))
+        if (!cloud_buffer->pop(&scan, token))
         {
             continue;
         }
 
+        occupancy.begin();
         eval.start("total");
-        
-        point_cloud.data_->scaling_ = point_scale;
-        int num_points = point_cloud.data_->points_.size();
 
-        if (scan_point_buffer == nullptr || num_points > (int)scan_point_buffer->size())
+        // scans the preprocessing replaced in the buffer while the registration was busy
+        size_t now_overwritten = cloud_buffer->overwritten();
+        if (now_overwritten != overwritten)
         {
-            // IMPORTANT: Delete old buffer first
-            scan_point_buffer.reset();
-            scan_point_buffer.reset(new InputBuffer<PointHW>(q, num_points * 1.5));
+            registration.count_overwritten(now_overwritten - overwritten);
+            overwritten = now_overwritten;
         }
-        
-        for (int i = 0; i < num_points; i++)
+
+        // the points are written to the device buffer by the preprocessing and shared with the map thread
+        auto& scan_point_buffer = scan.data_->points_;
+        int num_points = scan.data_->num_points_;
+
+        if (send_after_registration)
         {
-            auto& point = point_cloud.data_->points_[i];
-            scan_point_buffer->operator[](i) = PointHW(point.x(), point.y(), point.z());
+            // the registration transforms the points in place
+            point_cloud.data_ = std::make_shared<msg::PointCloud>(point_scale);
+            scan.data_->copy_to(point_cloud.data_->points_);
         }
 
+        // the map thread publishes new versions of the map while this one is used
+        eval.start("map_wait");
+        auto map = local_map->pin();
+        eval.stop("map_wait");
+
         if (first_iteration)
         {
             first_iteration = false;
 
-            map_thread.get_tsdf_krnl().synchronized_run(*local_map, *scan_point_buffer, num_points);
+            // nothing is scheduled for the map thread yet, so the current version is written directly
+            map_thread.get_tsdf_krnl().synchronized_run(*map, scan_point_buffer, num_points);
         }
         else
         {
             Matrix4f old_pose = pose;
 
-            map_mutex.lock();
             eval.start("reg");
-            registration.register_cloud(*local_map, *scan_point_buffer, num_points, point_cloud.timestamp_, pose);
+            bool registered = registration.register_cloud(*map, scan_point_buffer, num_points, scan.timestamp_, pose, cloud_buffer->size(), scan.data_->arrival_);
             eval.stop("reg");
-            map_mutex.unlock();
+
+            if (!registered)
+            {
+                // the scan missed its deadline, the next one is already waiting
+                eval.stop("total");
+                occupancy.end(0);
+                continue;
+            }
 
             if (std::isnan(pose(0, 0)))
             {
                 Logger::error("Registration gave NaN");
                 pose = old_pose;
+                registration.reset_motion();
             }
         }
 
+        map.release();
+
         Vector3i pos((int)std::floor(pose(0, 3) / MAP_RESOLUTION),
                      (int)std::floor(pose(1, 3) / MAP_RESOLUTION),
                      (int)std::floor(pose(2, 3) / MAP_RESOLUTION));
-        map_thread.go(pos, pose, *scan_point_buffer, num_points);
+        map_thread.go(pos, pose, scan.data_, scan.data_->arrival_);
 
         Eigen::Quaternionf quat(pose.block<3, 3>(0, 0));
 
@@ -132,6 +152,7 @@ void CloudCallback::thread_run()
         }
 
         eval.stop("total");
+        occupancy.end();
 #ifdef TIME_MEASUREMENT
         if (cnt == 20)
         {
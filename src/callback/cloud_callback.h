@@ -7,9 +7,10 @@
 
 #include <util/point_hw.h>
 #include <msg/transform.h>
-#include <map/local_map.h>
+#include <map/local_map_snapshots.h>
 #include <eigen3/Eigen/Dense>
 #include <util/process_thread.h>
+#include <util/stage_occupancy.h>
 #include <msg/tsdf.h>
 #include <tsdf/krnl_tsdf.h>
 #include <registration/registration.h>
@@ -17,13 +18,17 @@
 #include <util/concurrent_ring_buffer.h>
 #include <msg/point_cloud.h>
 #include <callback/map_thread.h>
+#include <hw/buffer/scan_buffer.h>
 
 namespace fastsense::callback
 {
 
 using Registration = fastsense::registration::Registration;
 using PointCloudBuffer = fastsense::util::ConcurrentRingBuffer<fastsense::msg::PointCloudPtrStamped>;
+using ScanBuffer = fastsense::buffer::ScanBuffer;
+using ScanBufferStampedBuffer = fastsense::buffer::ScanBufferStampedBuffer;
 using fastsense::map::LocalMap;
+using fastsense::map::LocalMapSnapshots;
 using fastsense::map::GlobalMap;
 using Eigen::Matrix4f;
 using fastsense::util::config::ConfigManager;
@@ -33,15 +38,14 @@ class CloudCallback : public fastsense::util::ProcessThread
 {
 public:
     CloudCallback(Registration& registration,
-                  const std::shared_ptr<PointCloudBuffer>& cloud_buffer,
-                  const std::shared_ptr<LocalMap>& local_map,
+                  const ScanBufferStampedBuffer::Ptr& cloud_buffer,
+                  const LocalMapSnapshots::Ptr& local_map,
                   const std::shared_ptr<GlobalMap>& global_map,
                   const msg::TransformStampedBuffer::Ptr& transform_buffer,
                   const msg::PointCloudPtrStampedBuffer::Ptr& pointcloud_buffer,
                   bool send_after_registration,
                   const fastsense::CommandQueuePtr& q,
                   MapThread& map_thread,
-                  std::mutex& map_mutex,
                   float point_scale);
 
     /**
@@ -54,17 +58,17 @@ public:
     /**
      * @brief Set the local map
      * 
-     * @param local_map the new local map
+     * @param local_map the new local map snapshots
      */
-    void set_local_map(const std::shared_ptr<LocalMap>& local_map);
+    void set_local_map(const LocalMapSnapshots::Ptr& local_map);
 
 protected:
     void thread_run() override;
 
 private:
     Registration& registration;
-    std::shared_ptr<PointCloudBuffer> cloud_buffer;
-    std::shared_ptr<LocalMap> local_map;
+    ScanBufferStampedBuffer::Ptr cloud_buffer;
+    LocalMapSnapshots::Ptr local_map;
     std::shared_ptr<GlobalMap> global_map;
     Matrix4f pose;
     msg::TransformStampedBuffer::Ptr transform_buffer;
@@ -73,8 +77,9 @@ private:
     bool first_iteration;
     fastsense::CommandQueuePtr q;
     MapThread& map_thread;
-    std::mutex& map_mutex;
     float point_scale;
+    /// Busy time and throughput of the registration stage
+    util::StageOccupancy occupancy;
 };
 
 }
@@ -0,0 +1,64 @@
+/**
+ * @file map_export.cpp
+ */
+
+#include <callback/map_export.h>
+#include <util/config/config_manager.h>
+
+namespace fastsense::callback
+{
+
+using fastsense::util::config::ConfigManager;
+
+MapExport::MapExport(const map::LocalMapSnapshots::Ptr& local_map, uint16_t port, float scaling)
+    : ProcessThread(),
+      local_map_(local_map),
+      versions_(1),
+      tsdf_msg_(),
+      sender_(port),
+      scaling_(scaling),
+      occupancy_("export")
+{
+    tsdf_msg_.data_.tsdf_data_.resize(local_map->pin()->getBuffer().size());
+}
+
+void MapExport::notify(uint64_t version)
+{
+    versions_.push_nb(version, true);
+}
+
+void MapExport::set_local_map(const map::LocalMapSnapshots::Ptr& local_map)
+{
+    local_map_ = local_map;
+}
+
+void MapExport::thread_run()
+{
+    uint64_t version;
+    auto token = stop_token();
+    while (running)
+    {
+        if (!versions_.pop(&version, token))
+        {
+            continue;
+        }
+        occupancy_.begin();
+
+        {
+            // the pin keeps the version unchanged while it is copied, the map thread updates another copy
+            auto map = local_map_->pin();
+            tsdf_msg_.update_time();
+            tsdf_msg_.data_.tau_ = ConfigManager::config().slam.max_distance();
+            tsdf_msg_.data_.size_ = map->get_size();
+            tsdf_msg_.data_.pos_ = map->get_pos();
+            tsdf_msg_.data_.offset_ = map->get_offset();
+            tsdf_msg_.data_.scaling_ = scaling_;
+            std::copy(map->getBuffer().cbegin(), map->getBuffer().cend(), tsdf_msg_.data_.tsdf_data_.data());
+        }
+
+        sender_.send(tsdf_msg_);
+        occupancy_.end();
+    }
+}
+
+} // namespace fastsense::callback
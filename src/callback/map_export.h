@@ -0,0 +1,86 @@
+#pragma once
+
+/**
+ * @file map_export.h
+ */
+
+#include <map/local_map_snapshots.h>
+#include <msg/tsdf.h>
+#include <comm/sender.h>
+#include <util/concurrent_ring_buffer.h>
+#include <util/process_thread.h>
+#include <util/stage_occupancy.h>
+
+namespace fastsense::callback
+{
+
+/**
+ * @brief Last stage of the pipeline: sends the published versions of the local map to the visualization.
+ *
+ * The map thread only announces a new version. The export pins it, copies it into the message and sends it
+ * while the map thread already integrates the next scans. If the export is slower than the map updates,
+ * it skips to the latest version.
+ */
+class MapExport : public util::ProcessThread
+{
+public:
+    /**
+     * @brief Construct a new Map Export object
+     *
+     * @param local_map snapshots of the local map
+     * @param port port of the sender
+     * @param scaling point cloud scaling
+     */
+    MapExport(const map::LocalMapSnapshots::Ptr& local_map, uint16_t port, float scaling);
+
+    /// default destructor
+    ~MapExport() override = default;
+
+    /// delete copy assignment operator
+    MapExport& operator=(const MapExport& other) = delete;
+
+    /// delete move assignment operator
+    MapExport& operator=(MapExport&&) noexcept = delete;
+
+    /// delete copy constructor
+    MapExport(const MapExport&) = delete;
+
+    /// delete move constructor
+    MapExport(MapExport&&) = delete;
+
+    /**
+     * @brief Announce a new version of the map. Does not block
+     *
+     * @param version the published version
+     */
+    void notify(uint64_t version);
+
+    /**
+     * @brief Sets the local map
+     *
+     * @param local_map the new local map snapshots
+     */
+    void set_local_map(const map::LocalMapSnapshots::Ptr& local_map);
+
+protected:
+    /**
+     * @brief Send every announced version that is still current
+     */
+    void thread_run() override;
+
+private:
+    /// Snapshots of the local map
+    map::LocalMapSnapshots::Ptr local_map_;
+    /// Announced versions, only the latest is kept
+    util::ConcurrentRingBuffer<uint64_t> versions_;
+    /// Message to send with the tsdf values
+    msg::TSDFStamped tsdf_msg_;
+    /// Sends the message to the visualization
+    comm::Sender<msg::TSDFStamped> sender_;
+    /// point cloud scaling
+    float scaling_;
+    /// Busy time and throughput of the export stage
+    util::StageOccupancy occupancy_;
+};
+
+} // namespace fastsense::callback
@@ -11,134 +11,134 @@
 namespace fastsense::callback
 {
 
-using fastsense::util::config::ConfigManager;
 using fastsense::util::logging::Logger;
 
-MapThread::MapThread(const std::shared_ptr<fastsense::map::LocalMap>& local_map,
-                     std::mutex& map_mutex,
+MapThread::MapThread(const fastsense::map::LocalMapSnapshots::Ptr& local_map,
                      unsigned int period,
                      float position_threshold,
-                     uint16_t port,
-                     float scaling,
+                     size_t max_batch,
+                     MapExport& map_export,
                      fastsense::CommandQueuePtr& q)
     : ProcessThread(),
       local_map_(local_map),
-      tsdf_krnl_(q, local_map->getBuffer().size()),
-      map_mutex_(map_mutex),
-      active_(false),
+      tsdf_krnl_(q, local_map->pin()->getBuffer().size()),
+      scheduler_(max_batch),
+      batch_(),
       period_(period),
       position_threshold_(position_threshold),
       reg_cnt_(0),
-      tsdf_msg_(),
-      sender_(port),
-      scaling_(scaling)
+      map_export_(map_export),
+      occupancy_("integration"),
+      scan_age_("integration")
 {
-    /*
-    Use the mutex as a 1-semaphore.
-    wait = lock, signal = unlock.
-    The mutex starts in the wrong state.
-    */
-    start_mutex_.lock();
-
-    tsdf_msg_.data_.tsdf_data_.resize(local_map->getBuffer().size());
 }
 
-void MapThread::go(const Vector3i& pos, const Eigen::Matrix4f& pose, const fastsense::buffer::InputBuffer<PointHW>& points, int num_points)
+void MapThread::go(const Vector3i& pos, const Eigen::Matrix4f& pose, const fastsense::buffer::ScanBuffer::Ptr& scan, const util::SteadyTimePoint& arrival)
 {
     reg_cnt_++;
-    const Vector3i& old_pos = local_map_->get_pos();
+    Vector3i old_pos = local_map_->pin()->get_pos();
     float distance = ((pos.cast<float>() - old_pos.cast<float>()) * MAP_RESOLUTION).norm();
 
     bool position_condition = distance > position_threshold_;
     bool reg_cnt_condition = period_ > 0 && reg_cnt_ >= period_;
-    if (!active_ && (position_condition || reg_cnt_condition))
+    if (position_condition || reg_cnt_condition)
     {
-        pos_ = pos;
-        pose_ = pose;
-        if (points_ptr_ == nullptr || points_ptr_->size() != points.size())
+        if (scheduler_.submit(MapUpdate{pos, pose, scan, arrival}))
         {
-            points_ptr_.reset();
-            points_ptr_.reset(new fastsense::buffer::InputBuffer<PointHW>(points));
+            Logger::warning("Map update is too slow, dropped the oldest scheduled scan");
         }
-        else
-        {
-            points_ptr_->fill_from(points);
-        }
-        num_points_ = num_points;
-        active_ = true;
-        start_mutex_.unlock(); // signal
         reg_cnt_ = 0;
     }
 }
 
+/**
+ * @brief Up direction of the scanner for the TSDF kernel
+ *
+ * @param pose pose of the scanner
+ */
+static PointHW up_vector(const Eigen::Matrix4f& pose)
+{
+    Matrix4i rotation_mat = Matrix4i::Identity();
+    rotation_mat.block<3, 3>(0, 0) = ((pose * MATRIX_RESOLUTION).cast<int>()).block<3, 3>(0, 0);
+    Eigen::Vector4i v;
+    v << Vector3i(0, 0, MATRIX_RESOLUTION), 1;
+    Vector3i up = (rotation_mat * v).block<3, 1>(0, 0) / MATRIX_RESOLUTION;
+    return PointHW(up.x(), up.y(), up.z());
+}
+
 void MapThread::thread_run()
 {
     // Second runtime evaluator for measurements in this thread
     util::RuntimeEvaluator eval;
-    map::LocalMap tmp_map(*local_map_);
-
+    auto token = stop_token();
     while (running)
     {
-        start_mutex_.lock();
-        if (!running)
+        if (!scheduler_.take(batch_, token))
         {
             break;
         }
-        Logger::info("Starting SUV");
+        occupancy_.begin();
+        Logger::info("Starting SUV with ", batch_.size(), " scans");
+
+        // a copy of the current version without readers
+        eval.start("copy");
+        map::LocalMap& tmp_map = local_map_->begin_update();
+        eval.stop("copy");
 
-        // shift
+        // shift to the latest position, the scans of a batch are close to each other
         eval.start("shift");
-        tmp_map.shift(pos_);
+        tmp_map.shift(batch_.back().pos);
         eval.stop("shift");
 
-        // tsdf update
+        // tsdf update: while the kernel integrates one scan, the next one is prepared
+        // and the buffer of the previous one is returned to the pool
         eval.start("tsdf");
-        Matrix4i rotation_mat = Matrix4i::Identity();
-        rotation_mat.block<3, 3>(0, 0) = ((pose_ * MATRIX_RESOLUTION).cast<int>()).block<3, 3>(0, 0);
-        Eigen::Vector4i v;
-        v << Vector3i(0, 0, MATRIX_RESOLUTION), 1;
-        Vector3i up = (rotation_mat * v).block<3, 1>(0, 0) / MATRIX_RESOLUTION;
-        PointHW up_hw(up.x(), up.y(), up.z());
-
-        tsdf_krnl_.synchronized_run(tmp_map, *points_ptr_, num_points_, up_hw);
+        PointHW up_hw = up_vector(batch_[0].pose);
+        for (size_t i = 0; i < batch_.size(); i++)
+        {
+            auto kernel = tsdf_krnl_.start(tmp_map, batch_[i].scan->points_, batch_[i].scan->num_points_, up_hw);
+            if (i > 0)
+            {
+                batch_[i - 1].scan.reset();
+            }
+            if (i + 1 < batch_.size())
+            {
+                up_hw = up_vector(batch_[i + 1].pose);
+            }
+            kernel.wait();
+            scan_age_.add(batch_[i].arrival);
+        }
         eval.stop("tsdf");
 
-        map_mutex_.lock();
-        local_map_->swap(tmp_map);
-        map_mutex_.unlock();
-
-        eval.start("copy");
-        tmp_map.fill_from(*local_map_);
-        eval.stop("copy");
-
-        // visualize
-        eval.start("vis");
-        tsdf_msg_.update_time();
-        tsdf_msg_.data_.tau_ = ConfigManager::config().slam.max_distance();
-        tsdf_msg_.data_.size_ = local_map_->get_size();
-        tsdf_msg_.data_.pos_ = local_map_->get_pos();
-        tsdf_msg_.data_.offset_ = local_map_->get_offset();
-        tsdf_msg_.data_.scaling_ = scaling_;
-        std::copy(local_map_->getBuffer().cbegin(), local_map_->getBuffer().cend(), tsdf_msg_.data_.tsdf_data_.data());
-        sender_.send(tsdf_msg_);
-        eval.stop("vis");
-
-        Logger::info("Map Thread:\n", eval.to_string(), "\nStopping SUV");
-        active_ = false;
+        size_t integrated = batch_.size();
+        batch_.clear();
+
+        // readers keep the version they pinned, the next registration uses the new one
+        eval.start("map_wait");
+        uint64_t version = local_map_->publish();
+        eval.stop("map_wait");
+
+        // the export sends this version while the next scans are integrated
+        map_export_.notify(version);
+        occupancy_.end(integrated);
+
+        auto stats = scheduler_.stats();
+        Logger::info("Map Thread:\n", eval.to_string(),
+                     "\nPublished map version ", version, " (", local_map_->pin_retries(), " pin retries, ",
+                     local_map_->update_waits(), " update waits)",
+                     "\nIntegrated ", stats.integrated, " of ", stats.submitted, " scans in ", stats.batches,
+                     " updates, dropped ", stats.dropped,
+                     "\n", scan_age_.to_string(),
+                     "\nPipeline occupancy:\n", util::PipelineOccupancy::get_instance().to_string(), "Stopping SUV");
+        scan_age_.reset();
     }
-}
 
-void MapThread::stop()
-{
-    if (running && worker.joinable())
-    {
-        running = false;
-        start_mutex_.unlock();
-        worker.join();
-    }
+    // scans that were scheduled after the last update are not integrated anymore
+    batch_.clear();
+    scheduler_.clear();
 }
 
-void MapThread::set_local_map(const std::shared_ptr<fastsense::map::LocalMap>& local_map)
+void MapThread::set_local_map(const fastsense::map::LocalMapSnapshots::Ptr& local_map)
 {
     local_map_ = local_map;
 }
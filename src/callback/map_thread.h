@@ -7,17 +7,22 @@
 
 #include <eigen3/Eigen/Dense>
 #include <mutex>
-#include <atomic>
+#include <vector>
 
 #include <msg/transform.h>
 #include <msg/tsdf.h>
-#include <map/local_map.h>
+#include <map/local_map_snapshots.h>
 #include <tsdf/krnl_tsdf.h>
 #include <util/point_hw.h>
 #include <util/process_thread.h>
 #include <util/config/config_manager.h>
 #include <util/concurrent_ring_buffer.h>
 #include <comm/sender.h>
+#include <hw/buffer/scan_buffer.h>
+#include <callback/map_update_scheduler.h>
+#include <callback/map_export.h>
+#include <util/stage_occupancy.h>
+#include <util/scan_age.h>
 
 namespace fastsense::callback
 {
@@ -26,7 +31,7 @@ using Eigen::Vector3i;
 using TSDFBuffer = util::ConcurrentRingBuffer<msg::TSDF>;
 
 /**
- * @brief This class encapsulates the asynchronous map shift, tsdf update and visualization of the map.
+ * @brief This class encapsulates the asynchronous map shift and tsdf update of the map. The visualization is sent by the MapExport.
  */
 class MapThread : public fastsense::util::ProcessThread
 {
@@ -35,23 +40,22 @@ public:
     /**
      * @brief Construct a new MapThread object.
      * 
-     * @param local_map Local map pointer of the cloud callback.
-     *                  In this local map nothing is written, but it is copied into a "local" local map.
-     * @param map_mutex Mutex for synchronisation between the map thread and the cloud callback for access to the local map.
+     * @param local_map Snapshots of the local map that are shared with the cloud callback.
+     *                  The map thread updates a copy and publishes it as the new version, the cloud callback never waits for it.
      * @param period Parameter for the map thread.
      *               Maximum number of registration periods without a map shift and update. Ignored if lower than 1.
      * @param position_threshold Parameter for the map thread.
      *                           Distance from the current position to the last activated position at which the thread is activated (in mm).
-     * @param tsdf_buffer Buffer for communication to the visualization thread.
-     * @param scaling point cloud scaling
+     * @param max_batch Maximum number of scans that are integrated by one update.
+     *                  Scans that arrive during an update are coalesced into the next one, the oldest are dropped beyond this.
+     * @param map_export Stage that sends the published versions to the visualization.
      * @param q Program command queue.
      */
-    MapThread(const std::shared_ptr<fastsense::map::LocalMap>& local_map, 
-              std::mutex& map_mutex,
+    MapThread(const fastsense::map::LocalMapSnapshots::Ptr& local_map,
               unsigned int period,
               float position_threshold,
-              uint16_t port,
-              float scaling,
+              size_t max_batch,
+              MapExport& map_export,
               fastsense::CommandQueuePtr& q);
 
     /// Default destructor of the map thread.
@@ -70,75 +74,69 @@ public:
     MapThread& operator=(MapThread&&) = delete;
 
     /**
-     * @brief Starts the thread for shifting, updating and visualization the map
+     * @brief Schedules the scan for shifting, updating and visualization the map
      *        if a specific number of registartion periods were performed 
      *        or the position of the system has changed by a predefined threshold.
+     *        A scan that is scheduled during a running update is integrated by the next one.
      * 
      * @param pos Current position
-     * @param points Current scan points
+     * @param pose Current pose
+     * @param scan Current scan points, kept by the thread until the update is done
+     * @param arrival Time the scan entered the pipeline, for the scan age at the integration
      */
-    void go(const Vector3i& pos, const Eigen::Matrix4f& pose, const fastsense::buffer::InputBuffer<PointHW>& points, int num_points);
-
-    /**
-     * @brief Stop the map thread safely.
-     */
-    virtual void stop() override;
+    void go(const Vector3i& pos, const Eigen::Matrix4f& pose, const fastsense::buffer::ScanBuffer::Ptr& scan, const util::SteadyTimePoint& arrival);
 
     /**
      * @brief Sets the local map
      * 
-     * @param local_map the new local map
+     * @param local_map the new local map snapshots
      */
-    void set_local_map(const std::shared_ptr<fastsense::map::LocalMap>& local_map);
+    void set_local_map(const fastsense::map::LocalMapSnapshots::Ptr& local_map);
 
     tsdf::TSDFKernel& get_tsdf_krnl()
     {
         return tsdf_krnl_;
     }
 
+    /**
+     * @brief Number of scheduled, integrated and dropped scans
+     */
+    MapUpdateStats stats() const
+    {
+        return scheduler_.stats();
+    }
+
 protected:
 
     /**
-     * @brief Shift, update and visualize the local map based on the current position and scanner data.
+     * @brief Shift and update the local map based on the current position and scanner data.
      *        The thread runs in an infinite loop.
-     *        One iteration is started by the go function.
-     *        The communication is done by a mutex that functions as a semaphore.
+     *        One iteration integrates all scans that were scheduled by the go function since the last one.
      */
     void thread_run() override;
 
 private:
 
-    /// Pointer to the local map
-    std::shared_ptr<fastsense::map::LocalMap> local_map_;
+    /// Snapshots of the local map, the map thread is their only writer
+    fastsense::map::LocalMapSnapshots::Ptr local_map_;
     /// Kernel object to perform an map update on hardware
     tsdf::TSDFKernel tsdf_krnl_;
-    /// Mutex for synchronisation between the map thread and the cloud callback for access to the local map
-    std::mutex& map_mutex_;
-    /// Mutex functions as a semaphore to control the when the map thread starts
-    std::mutex start_mutex_;
-    /// Flag that indicates if the thread is active
-    std::atomic<bool> active_;
-    /// Position that is used for shifting
-    Vector3i pos_;
-    /// Pose that is used for updating
-    Eigen::Matrix4f pose_;
-
-    /// Scan points that are used for shifting, updating and visualization
-    std::unique_ptr<fastsense::buffer::InputBuffer<PointHW>> points_ptr_;
-    /// Number of Points in points_ptr_, because buffer size might be larger
-    int num_points_;
+    /// Coalesces the scheduled scans into batches for the map thread
+    MapUpdateScheduler scheduler_;
+    /// Scans of the current update. Their points are shared with the cloud callback instead of copied
+    std::vector<MapUpdate> batch_;
     /// Maximum number of registration periods without a map shift and update. Ignored if lower than 1
     unsigned int period_;
     /// Distance from the current position to the last activated position at which the thread is activated (in mm)
     float position_threshold_;
     /// Counter for the number of performed registrations after the last thread activation
     unsigned int reg_cnt_;
-    /// Message to send with the tsdf values
-    msg::TSDFStamped tsdf_msg_;
-    /// Buffer for starting the map visualization thread
-    comm::Sender<msg::TSDFStamped> sender_;
-    /// point cloud scaling
-    float scaling_;
+    /// Stage that sends the published versions to the visualization
+    MapExport& map_export_;
+    /// Busy time and throughput of the integration stage
+    util::StageOccupancy occupancy_;
+    /// Time from the arrival of the scans to their integration
+    util::ScanAge scan_age_;
 };
 
 } // namespace fastsense::callback
@@ -0,0 +1,189 @@
+#pragma once
+
+/**
+ * @file map_update_scheduler.h
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include <eigen3/Eigen/Dense>
+
+#include <hw/buffer/scan_buffer.h>
+#include <util/stop_token.h>
+#include <util/time.h>
+
+namespace fastsense::callback
+{
+
+/**
+ * @brief A registered scan that should be integrated into the map
+ */
+struct MapUpdate
+{
+    /// Position of the scanner in map cells, the map is shifted to it
+    Eigen::Vector3i pos;
+    /// Pose of the scanner
+    Eigen::Matrix4f pose;
+    /// Registered scan points
+    buffer::ScanBuffer::Ptr scan;
+    /// Time the scan entered the pipeline
+    util::SteadyTimePoint arrival;
+};
+
+/**
+ * @brief Number of scans that were handed to the scheduler, integrated into the map and dropped
+ */
+struct MapUpdateStats
+{
+    /// Scans that were submitted
+    size_t submitted = 0;
+    /// Scans that were taken for an update
+    size_t integrated = 0;
+    /// Scans that were dropped because the batch was full or the thread stopped
+    size_t dropped = 0;
+    /// Number of map updates
+    size_t batches = 0;
+};
+
+/**
+ * @brief Hands the scans for the map update from the registration to the map thread.
+ *
+ * Scans that are submitted while an update is running are not dropped but coalesced into the next batch,
+ * which the map thread takes as a whole once the current update is finished. A batch holds at most
+ * max_batch scans, a full batch drops its oldest scan, so the scan buffers held by the batch stay bounded.
+ */
+class MapUpdateScheduler
+{
+public:
+    /**
+     * @brief Construct a new Map Update Scheduler object
+     *
+     * @param max_batch maximum number of scans that are integrated by one update, at least 1
+     */
+    explicit MapUpdateScheduler(size_t max_batch)
+        : max_batch_{std::max<size_t>(max_batch, 1)},
+          mutex_{},
+          cv_{},
+          pending_{},
+          stats_{}
+    {
+        pending_.reserve(max_batch_);
+    }
+
+    /// default destructor
+    ~MapUpdateScheduler() = default;
+
+    /// delete copy assignment operator
+    MapUpdateScheduler& operator=(const MapUpdateScheduler& other) = delete;
+
+    /// delete move assignment operator
+    MapUpdateScheduler& operator=(MapUpdateScheduler&&) noexcept = delete;
+
+    /// delete copy constructor
+    MapUpdateScheduler(const MapUpdateScheduler&) = delete;
+
+    /// delete move constructor
+    MapUpdateScheduler(MapUpdateScheduler&&) = delete;
+
+    /**
+     * @brief Add a scan to the pending batch and wake up the map thread
+     *
+     * @param update the scan to integrate
+     * @return true if the batch was full and its oldest scan was dropped
+     */
+    bool submit(MapUpdate&& update)
+    {
+        bool dropped = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.submitted++;
+            if (pending_.size() == max_batch_)
+            {
+                pending_.erase(pending_.begin());
+                stats_.dropped++;
+                dropped = true;
+            }
+            pending_.push_back(std::move(update));
+        }
+        cv_.notify_one();
+        return dropped;
+    }
+
+    /**
+     * @brief Take all pending scans. Blocks until a scan is submitted or the stop is requested.
+     *
+     * @param batch cleared and filled with the pending scans, oldest first
+     * @param token stop token of the map thread
+     * @return false if the stop was requested, batch is empty then
+     */
+    bool take(std::vector<MapUpdate>& batch, const util::StopToken& token)
+    {
+        batch.clear();
+
+        // destroyed after the lock is released, a running invocation locks the mutex
+        util::StopCallback wake{token, [this]()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }};
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return !pending_.empty() || token.stop_requested(); });
+        if (token.stop_requested())
+        {
+            return false;
+        }
+
+        // the batch vector keeps its capacity for the next submits
+        pending_.swap(batch);
+        pending_.reserve(max_batch_);
+        stats_.integrated += batch.size();
+        stats_.batches++;
+        return true;
+    }
+
+    /**
+     * @brief Drop all pending scans, e.g. when the map thread stops
+     */
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.dropped += pending_.size();
+        pending_.clear();
+    }
+
+    /**
+     * @brief Number of scans that wait for the next update
+     */
+    size_t pending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pending_.size();
+    }
+
+    /**
+     * @brief Snapshot of the counters
+     */
+    MapUpdateStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    /// Maximum number of scans in a batch
+    size_t max_batch_;
+    /// Protects the pending scans and the counters
+    mutable std::mutex mutex_;
+    /// Signaled when a scan is submitted or the stop is requested
+    std::condition_variable cv_;
+    /// Scans that wait for the next update
+    std::vector<MapUpdate> pending_;
+    /// Counters of the submitted, integrated and dropped scans
+    MapUpdateStats stats_;
+};
+
+} // namespace fastsense::callback
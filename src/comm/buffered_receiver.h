@@ -8,6 +8,7 @@
 #include <util/time.h>
 #include <util/process_thread.h>
 #include <util/concurrent_ring_buffer.h>
+#include <util/stop_event.h>
 #include <comm/receiver.h>
 #include <msg/imu.h>
 #include <msg/point_cloud.h>
@@ -44,13 +45,17 @@ public:
     BufferedReceiver& operator=(BufferedReceiver const&) = delete;
 
     /**
-     * @brief Destroy the Buffered Receiver object
+     * @brief Destroy the Buffered Receiver object, stops the thread while the receiver and the stop event still exist
      */
-    virtual ~BufferedReceiver() override = default;
+    virtual ~BufferedReceiver() override
+    {
+        stop();
+    }
 
     /**
      * @brief 'receive' receives one message
-     * and is called from an endless loop in thread_run
+     * and is called from an endless loop in thread_run.
+     * Blocks until a message arrives or the thread is stopped.
      */
     virtual bool receive() = 0;
 
@@ -60,6 +65,13 @@ public:
      */
     void thread_run() override
     {
+        // the stop makes the event readable, which ends the poll of the receiver without a timeout
+        stop_event_.reset();
+        util::StopCallback wake{stop_token(), [this]()
+        {
+            stop_event_.signal();
+        }};
+
         while (running)
         {
             receive();
@@ -72,16 +84,17 @@ protected:
      * 
      * @param addr address the receiver connects to
      * @param port port the receiver connects to 
-     * @param timeout timeout for receiver
      * @param buffer buffer to write the incoming messages
      */
     BufferedReceiver(   const std::string& addr, 
                         uint16_t port, 
-                        std::chrono::milliseconds timeout, 
                         typename util::ConcurrentRingBuffer<BUFF_T>::Ptr buffer)
-    : receiver_{addr, port, timeout}
+    : receiver_{addr, port, Receiver<RECV_T>::INFINITE_TIMEOUT}
     , buffer_{buffer}
-    {}
+    , stop_event_{}
+    {
+        receiver_.wake_on(stop_event_.fd());
+    }
 
     /// Receiver that's used to get data
     Receiver<RECV_T> receiver_;
@@ -91,6 +104,9 @@ protected:
     
     /// individual message that is received
     RECV_T msg_;
+
+    /// Wakes up the receiver when the thread is stopped
+    util::StopEvent stop_event_;
 };
 
 /**
@@ -104,14 +120,12 @@ public:
      * 
      * @param addr address the receiver connects to
      * @param port port the receiver connects to 
-     * @param timeout timeout for receiver
      * @param buffer buffer to write the incoming messages
      */
     BufferedImuStampedReceiver( const std::string& addr, 
                                 uint16_t port, 
-                                std::chrono::milliseconds timeout,
                                 msg::ImuStampedBuffer::Ptr buffer)
-    : BufferedReceiver{addr, port, timeout, buffer}
+    : BufferedReceiver{addr, port, buffer}
     {}
 
     /**
@@ -120,7 +134,7 @@ public:
     ~BufferedImuStampedReceiver() final = default;
 
     /**
-     * @brief Receive ImuStamped (non blocking) and write into buffer, if received
+     * @brief Receive ImuStamped and write into buffer, if received
      *
      * @return
      */
@@ -150,14 +164,12 @@ public:
      * 
      * @param addr address the receiver connects to
      * @param port port the receiver connects to 
-     * @param timeout timeout for receiver
      * @param buffer buffer to write the incoming messages
      */
     BufferedPclStampedReceiver( const std::string& addr, 
                                 uint16_t port, 
-                                std::chrono::milliseconds timeout,
                                 msg::PointCloudPtrStampedBuffer::Ptr buffer)
-    : BufferedReceiver{addr, port, timeout, buffer}
+    : BufferedReceiver{addr, port, buffer}
     {}
 
     /**
@@ -166,10 +178,10 @@ public:
     ~BufferedPclStampedReceiver() final = default;
 
     /**
-     * @brief Receive PointCloudStamped (non blocking), convert to PointCloud*Ptr*Stamped if received, and save
+     * @brief Receive PointCloudStamped, convert to PointCloud*Ptr*Stamped if received, and save
      *
      * @return true if message received and converted and saved
-     * @return false if no message received
+     * @return false if no message received because the thread was stopped
      */
     bool receive() final
     {
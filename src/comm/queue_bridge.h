@@ -73,9 +73,10 @@ protected:
     void thread_run() override
     {
         T_QUEUE val;
+        auto token = this->stop_token();
         while (this->running)
         {
-            if (!this->in_->pop_nb(&val, DEFAULT_POP_TIMEOUT))
+            if (!this->in_->pop(&val, token))
             {
                 continue;
             }
@@ -85,9 +86,9 @@ protected:
                 {
                     this->out_->push_nb(val, true);
                 }
-                else
+                else if (!this->out_->push(val, token))
                 {
-                    this->out_->push(val);
+                    break;
                 }
             }
 
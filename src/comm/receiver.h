@@ -21,11 +21,15 @@ template <typename T>
 class Receiver
 {
 public:
+    /// timeout of a poll that only ends with a message or a wakeup
+    static constexpr std::chrono::milliseconds INFINITE_TIMEOUT{-1};
+
     /**
      * @brief Construct a new Receiver object
      *
      * @param addr which address receiver should listen to
      * @param port which port receiver should listen to
+     * @param timeout how long a receive waits for a message, INFINITE_TIMEOUT waits until a message or a wakeup
      */
     Receiver(std::string addr, uint16_t port, std::chrono::milliseconds timeout = std::chrono::milliseconds(100))
     :   socket_{ZMQContextManager::getContext(), zmq::socket_type::sub}
@@ -37,7 +41,7 @@ public:
             throw std::runtime_error("Can't connect to address ''");
         }
 
-        if (timeout.count() < 0)
+        if (timeout < INFINITE_TIMEOUT)
         {
             throw std::runtime_error("Invalid timeout chosen");
         }
@@ -70,15 +74,27 @@ public:
      */
     virtual ~Receiver() = default;
 
+    /**
+     * @brief End the polls early as soon as the descriptor is readable, e.g. the eventfd of a StopEvent.
+     *
+     * The descriptor has to be reset by its owner, otherwise every following poll ends right away.
+     *
+     * @param fd file descriptor to poll next to the socket
+     */
+    void wake_on(int fd)
+    {
+        pollitems_.push_back({nullptr, fd, ZMQ_POLLIN, 0});
+    }
+
     /**
      * @brief Performs poll on socket
      * 
      * @return true if successfully polled
-     * @return false if poll took longer than timeout
+     * @return false if poll took longer than timeout or was woken up
      */
     bool poll_successful()
     {
-        zmq::poll(pollitems_.data(), 1, timeout_);
+        zmq::poll(pollitems_.data(), pollitems_.size(), timeout_);
         return pollitems_[0].revents & ZMQ_POLLIN;
     }
 
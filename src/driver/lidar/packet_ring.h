@@ -0,0 +1,238 @@
+#pragma once
+
+/**
+ * @file packet_ring.h
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include <stdexcept>
+
+#include <util/stop_token.h>
+
+namespace fastsense::driver
+{
+
+/**
+ * @brief Lock-free ring of preallocated slots between exactly one producer and one consumer thread
+ *
+ * The slots are written and read in place: the producer fills the free slots behind the write position and
+ * publishes them with commit(), the consumer processes the published slots and returns them with release().
+ * The consumer can sleep while the ring is empty; the producer only takes the mutex when the consumer sleeps.
+ *
+ * @tparam T type of the slots
+ */
+template<typename T>
+class PacketRing
+{
+public:
+    /**
+     * @brief Construct a new Packet Ring object
+     *
+     * @param capacity number of slots, rounded up to a power of two
+     */
+    explicit PacketRing(size_t capacity)
+        : slots_(round_up(capacity)),
+          mask_{slots_.size() - 1},
+          head_{0},
+          tail_{0},
+          high_water_{0},
+          waiting_{false},
+          mutex_{},
+          cond_{}
+    {
+    }
+
+    /// default destructor
+    ~PacketRing() = default;
+
+    /// delete copy assignment operator
+    PacketRing& operator=(const PacketRing& other) = delete;
+
+    /// delete move assignment operator
+    PacketRing& operator=(PacketRing&&) noexcept = delete;
+
+    /// delete copy constructor
+    PacketRing(const PacketRing&) = delete;
+
+    /// delete move constructor
+    PacketRing(PacketRing&&) = delete;
+
+    /**
+     * @brief Number of slots
+     */
+    size_t capacity() const
+    {
+        return slots_.size();
+    }
+
+    /**
+     * @brief Discard all published slots. Only allowed while neither the producer nor the consumer runs
+     */
+    void clear()
+    {
+        tail_.store(head_.load());
+    }
+
+    /**
+     * @brief Producer: number of free slots
+     */
+    size_t writable() const
+    {
+        return slots_.size() - (head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire));
+    }
+
+    /**
+     * @brief Producer: i-th free slot behind the write position
+     */
+    T& write_slot(size_t i)
+    {
+        return slots_[(head_.load(std::memory_order_relaxed) + i) & mask_];
+    }
+
+    /**
+     * @brief Producer: publish the next count free slots to the consumer and wake it up if it sleeps
+     */
+    void commit(size_t count)
+    {
+        size_t head = head_.load(std::memory_order_relaxed) + count;
+        head_.store(head, std::memory_order_seq_cst);
+
+        size_t fill = head - tail_.load(std::memory_order_relaxed);
+        if (fill > high_water_.load(std::memory_order_relaxed))
+        {
+            high_water_.store(fill, std::memory_order_relaxed);
+        }
+
+        // seq_cst on both sides: either the consumer sees the new head or the producer sees the waiting flag
+        if (waiting_.load(std::memory_order_seq_cst))
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cond_.notify_one();
+        }
+    }
+
+    /**
+     * @brief Consumer: number of published slots
+     */
+    size_t readable() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Consumer: i-th published slot behind the read position
+     */
+    T& read_slot(size_t i)
+    {
+        return slots_[(tail_.load(std::memory_order_relaxed) + i) & mask_];
+    }
+
+    /**
+     * @brief Consumer: return the next count published slots to the producer
+     */
+    void release(size_t count)
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    /**
+     * @brief Consumer: wait until slots are published or the timeout expires
+     *
+     * @return size_t number of published slots
+     */
+    template<typename Rep, typename Period>
+    size_t wait_readable(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        size_t count = readable();
+        if (count > 0)
+        {
+            return count;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiting_.store(true, std::memory_order_seq_cst);
+        cond_.wait_for(lock, timeout, [&]()
+        {
+            return head_.load(std::memory_order_seq_cst) != tail_.load(std::memory_order_relaxed);
+        });
+        waiting_.store(false, std::memory_order_relaxed);
+        return readable();
+    }
+
+    /**
+     * @brief Consumer: wait until slots are published or the stop of the token is requested
+     *
+     * @return size_t number of published slots, 0 if stopped
+     */
+    size_t wait_readable(const fastsense::util::StopToken& token)
+    {
+        size_t count = readable();
+        if (count > 0)
+        {
+            return count;
+        }
+
+        // destroyed after the lock is released, a running invocation locks the mutex
+        fastsense::util::StopCallback wake{token, [this]()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cond_.notify_all();
+        }};
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiting_.store(true, std::memory_order_seq_cst);
+        cond_.wait(lock, [&]()
+        {
+            return token.stop_requested() || head_.load(std::memory_order_seq_cst) != tail_.load(std::memory_order_relaxed);
+        });
+        waiting_.store(false, std::memory_order_relaxed);
+        return readable();
+    }
+
+    /**
+     * @brief Highest number of published slots that were waiting for the consumer
+     */
+    size_t high_water() const
+    {
+        return high_water_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static size_t round_up(size_t capacity)
+    {
+        if (capacity == 0)
+        {
+            throw std::runtime_error("packet ring needs at least one slot");
+        }
+
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    /// Preallocated slots
+    std::vector<T> slots_;
+    /// Number of slots - 1, for the index of a position
+    size_t mask_;
+    /// Write position, only changed by the producer
+    alignas(64) std::atomic<size_t> head_;
+    /// Read position, only changed by the consumer
+    alignas(64) std::atomic<size_t> tail_;
+    /// Highest fill level at a commit, only changed by the producer
+    alignas(64) std::atomic<size_t> high_water_;
+    /// Flag if the consumer sleeps
+    std::atomic<bool> waiting_;
+    /// Mutex for the sleeping consumer
+    std::mutex mutex_;
+    /// Wakes up the sleeping consumer
+    std::condition_variable cond_;
+};
+
+} // namespace fastsense::driver
@@ -6,7 +6,7 @@
 #include <system_error>
 #include <cerrno>
 #include <cstring>
-#include <cmath>
+#include <algorithm>
 #include <unistd.h>
 #include <netdb.h>
 #include <sys/socket.h>
@@ -23,94 +23,35 @@ using namespace fastsense::msg;
 using namespace fastsense::util;
 using namespace fastsense::util::logging;
 
-// Magic constants of the sensor
-constexpr uint8_t PROD_ID_VLP16 = 0x22;
-constexpr uint8_t MODE_STRONGEST = 0x37;
-constexpr uint8_t MODE_LAST = 0x38;
-constexpr uint8_t MODE_DUAL = 0x39;
-constexpr uint16_t BLOCK_FLAG = 0xEEFF;
+/// Time without packets after which a warning is logged
+constexpr std::chrono::milliseconds RECEIVE_TIMEOUT{1000};
 
-/**
- * @brief Calculate degrees to radians.
- *
- * @param deg Angle in degrees.
- * @return float Calcualted angle in radians.
- */
-constexpr float deg_to_rad(float deg)
-{
-    return deg * M_PIf32 / 180.f;
-}
-
-/// Lookup table to convert the laser id to vertical angles in radians.
-constexpr float LASER_ID_TO_VERT_ANGLE[16] =
-{
-    deg_to_rad(-15),
-    deg_to_rad(1),
-    deg_to_rad(-13),
-    deg_to_rad(3),
-    deg_to_rad(-11),
-    deg_to_rad(5),
-    deg_to_rad(-9),
-    deg_to_rad(7),
-    deg_to_rad(-7),
-    deg_to_rad(9),
-    deg_to_rad(-5),
-    deg_to_rad(11),
-    deg_to_rad(-3),
-    deg_to_rad(13),
-    deg_to_rad(-1),
-    deg_to_rad(15)
-};
-
-/// Lookup table to get the offset of a laser.
-constexpr float LASER_ID_TO_OFFSET[16] =
-{
-    11.2f,
-    -0.7f,
-    9.7f,
-    -2.2f,
-    8.1f,
-    -3.7f,
-    6.6f,
-    -5.1f,
-    5.1f,
-    -6.6f,
-    3.7f,
-    2.2f,
-    -9.7f,
-    0.7f,
-    -11.2f
-};
-
-/// Lookup table to get ring of laser.
-constexpr uint8_t LASER_ID_TO_RING[16] =
-{
-    15,
-    13,
-    11,
-    9,
-    7,
-    5,
-    3,
-    1,
-    14,
-    12,
-    10,
-    8,
-    6,
-    4,
-    2,
-    0
-};
-
-VelodyneDriver::VelodyneDriver(uint16_t port, const PointCloudPtrStampedBuffer::Ptr& buffer) :
+VelodyneDriver::VelodyneDriver(uint16_t port, const PointCloudPtrStampedBuffer::Ptr& buffer, int receive_buffer, size_t ring_size) :
     port_{port},
     sockfd_{},
-    packet_{},
-    az_last_{0.f},
+    stop_event_{},
+    packet_ring_{ring_size},
+    dropped_packet_{},
+    msgs_{},
+    iovecs_{},
+    control_{},
+    decode_thread_{},
+    decode_settings_{},
+    decoder_{buffer},
     scan_buffer_{buffer},
-    current_scan_{std::make_shared<PointCloud>()}
+    packets_received_{0},
+    receive_calls_{0},
+    packets_dropped_{0},
+    kernel_drops_{0}
 {
+    // every message receives one packet with its timestamp
+    for (size_t i = 0; i < PACKETS_IN_BATCH; i++)
+    {
+        iovecs_[i].iov_len = sizeof(VelodynePacket);
+        msgs_[i].msg_hdr.msg_iov = &iovecs_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+
     // open socket
     sockfd_ = socket(PF_INET, SOCK_DGRAM, 0);
     if (sockfd_ < 0)
@@ -132,17 +73,43 @@ VelodyneDriver::VelodyneDriver(uint16_t port, const PointCloudPtrStampedBuffer::
         throw std::system_error(errno, std::generic_category(),  "failed to bind");
     }
 
-    // set non blocking mode
-    if (fcntl(sockfd_, F_SETFL, O_NONBLOCK | FASYNC) < 0)
+    // let the kernel stamp every packet on arrival
+    int enable = 1;
+    if (setsockopt(sockfd_, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0)
+    {
+        close(sockfd_);
+        throw std::system_error(errno, std::generic_category(),  "failed to enable timestamps");
+    }
+
+    // let the kernel report its count of dropped packets with every packet
+    if (setsockopt(sockfd_, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) < 0)
     {
         close(sockfd_);
-        throw std::system_error(errno, std::generic_category(),  "failed to set non-blocking mode");
+        throw std::system_error(errno, std::generic_category(),  "failed to enable drop counter");
+    }
+
+    // a larger receive buffer bridges longer stalls of the receiver thread.
+    // SO_RCVBUFFORCE ignores the system limit, but needs CAP_NET_ADMIN
+    if (receive_buffer > 0
+            && setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUFFORCE, &receive_buffer, sizeof(receive_buffer)) < 0
+            && setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer)) < 0)
+    {
+        close(sockfd_);
+        throw std::system_error(errno, std::generic_category(),  "failed to set receive buffer size");
+    }
+
+    int actual_buffer = 0;
+    socklen_t length = sizeof(actual_buffer);
+    if (getsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &actual_buffer, &length) == 0 && actual_buffer < receive_buffer)
+    {
+        // the kernel reports twice the usable size
+        Logger::warning("LIDAR receive buffer is limited to ", actual_buffer / 2, " bytes by the system");
     }
 }
 
 VelodyneDriver::~VelodyneDriver()
 {
-    ProcessThread::stop();
+    stop();
     close(sockfd_);
 }
 
@@ -151,10 +118,24 @@ void VelodyneDriver::start()
     if (running == false)
     {
         running = true;
-        az_last_ = 0.f;
-        current_scan_ = std::make_shared<PointCloud>();
+        stop_source = StopSource{};
+        decoder_.reset();
         scan_buffer_->clear();
+        packet_ring_.clear();
+        decode_thread_ = std::thread(&VelodyneDriver::decode_run, this);
+        decode_settings_.apply(decode_thread_);
         worker = std::thread(&VelodyneDriver::thread_run, this);
+        settings.apply(worker);
+    }
+}
+
+void VelodyneDriver::stop()
+{
+    if (running && worker.joinable())
+    {
+        request_stop();
+        worker.join();
+        decode_thread_.join();
     }
 }
 
@@ -167,143 +148,130 @@ fastsense::msg::PointCloudPtrStamped VelodyneDriver::getScan()
 
 void VelodyneDriver::thread_run()
 {
-    constexpr int POLL_TIMEOUT = 1000;
-    struct pollfd fds[1];
-    fds[0].fd = sockfd_;
-    fds[0].events = POLLIN;
-
-    sockaddr_in sender;
-    socklen_t senderLength = sizeof(sender);
+    // the stop makes the event readable, which ends the wait for packets right away
+    stop_event_.reset();
+    StopCallback wake{stop_token(), [this]()
+    {
+        stop_event_.signal();
+    }};
 
     while (running)
     {
-        // wait for packet
-        do
+        int count = receive_packets();
+        if (count > 0)
         {
-            int ret = poll(fds, 1, POLL_TIMEOUT);
-            if (ret < 0)
-            {
-                if (errno != EINTR)
-                {
-                    throw std::system_error(errno, std::generic_category(),  "poll failed");
-                }
-            }
-            else if (ret == 0)
-            {
-                Logger::error("Timeout waiting for LIDAR data!");
-            }
-            else
-            {
-                if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL))
-                {
-                    throw std::runtime_error("poll error");
-                }
-            }
-        }
-        while (!(fds[0].revents & POLLIN));
-
-        // receive packet
-        ssize_t size = recvfrom(sockfd_, &packet_, sizeof(VelodynePacket), 0, (sockaddr*)&sender, &senderLength);
-
-        if (size < 0)
-        {
-            throw std::system_error(errno, std::generic_category(),  "recvfrom failed");
+            packet_ring_.commit(count);
         }
+    }
+}
 
-        // process packet
-        if (size == sizeof(VelodynePacket))
+void VelodyneDriver::decode_run()
+{
+    auto token = stop_token();
+    while (running)
+    {
+        size_t count = packet_ring_.wait_readable(token);
+        for (size_t i = 0; i < count; i++)
         {
-            decode_packet();
+            const auto& slot = packet_ring_.read_slot(i);
+            decoder_.decode_packet(slot.packet, slot.timestamp);
         }
+        packet_ring_.release(count);
     }
 }
 
-void VelodyneDriver::decode_packet()
+int VelodyneDriver::receive_packets()
 {
-    if (packet_.produkt_id != PROD_ID_VLP16)
+    // without free slots the socket is still drained, so the drops are counted here and not in the kernel
+    size_t free_slots = std::min<size_t>(packet_ring_.writable(), PACKETS_IN_BATCH);
+    for (size_t i = 0; i < PACKETS_IN_BATCH; i++)
     {
-        throw std::runtime_error("wrong sensor");
+        iovecs_[i].iov_base = free_slots > 0 ? &packet_ring_.write_slot(i).packet : &dropped_packet_;
+        msgs_[i].msg_hdr.msg_control = control_[i].data();
+        msgs_[i].msg_hdr.msg_controllen = control_[i].size();
     }
+    size_t batch = free_slots > 0 ? free_slots : PACKETS_IN_BATCH;
 
-    if (packet_.mode != MODE_STRONGEST && packet_.mode != MODE_LAST)
+    // block until the first packet of a batch or the stop, but report a silent sensor regularly
+    std::array<pollfd, 2> fds{{{sockfd_, POLLIN, 0}, {stop_event_.fd(), POLLIN, 0}}};
+    int ready = poll(fds.data(), fds.size(), RECEIVE_TIMEOUT.count());
+    if (ready < 0)
     {
-        throw std::runtime_error("wrong mode");
+        if (errno == EINTR)
+        {
+            return 0;
+        }
+        throw std::system_error(errno, std::generic_category(),  "poll failed");
+    }
+    if (ready == 0)
+    {
+        Logger::warning("Timeout waiting for LIDAR data!");
+        return 0;
+    }
+    if ((fds[0].revents & POLLIN) == 0)
+    {
+        return 0;
     }
 
-    for (int b = 0; b < BLOCKS_IN_PACKET; b++)
+    // take everything that is waiting
+    int count = recvmmsg(sockfd_, msgs_.data(), batch, MSG_DONTWAIT, nullptr);
+    if (count < 0)
     {
-        if (packet_.blocks[b].flag == BLOCK_FLAG)
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
         {
-            float az_block = packet_.blocks[b].azimuth * 0.01f; // 0.01 degree
-
-            // add new scan to queue when azimuth overflows
-            if (az_block < az_last_)
-            {
-                current_scan_->rings_ = 16;
-                current_scan_->scaling_ = 1.0f;
-                // TODO std::move()
-                scan_buffer_->push_nb(Stamped<PointCloud::Ptr>{current_scan_, util::HighResTime::now()}, true);
-                current_scan_ = std::make_shared<PointCloud>();
-            }
-            az_last_ = az_block;
+            return 0;
+        }
+        throw std::system_error(errno, std::generic_category(),  "recvmmsg failed");
+    }
+    receive_calls_++;
 
-            // allocate points for current block
-            size_t startIdx = current_scan_->points_.size();
-            current_scan_->points_.resize(startIdx + POINTS_IN_BLOCK);
+    // the kernel stamps with the system clock, which is not necessarily the clock of HighResTime
+    auto now = HighResTime::now();
+    auto system_now = std::chrono::system_clock::now();
 
-            // calculate azimuth difference between current and next block for interpolation
-            // last block uses previous difference for simplification
-            float az_diff;
-            if (b + 1 < BLOCKS_IN_PACKET)
+    int valid = 0;
+    for (int i = 0; i < count; i++)
+    {
+        auto timestamp = now;
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs_[i].msg_hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msgs_[i].msg_hdr, cmsg))
+        {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS)
             {
-                az_diff = (packet_.blocks[b + 1].azimuth * 0.01f) - az_block;
-                if (packet_.blocks[b + 1].azimuth < packet_.blocks[b].azimuth)
-                {
-                    az_diff += 360.f;
-                }
+                timespec stamp;
+                memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+                std::chrono::system_clock::time_point received{std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                        std::chrono::seconds(stamp.tv_sec) + std::chrono::nanoseconds(stamp.tv_nsec))};
+                timestamp = now - std::chrono::duration_cast<HighResTime::duration>(system_now - received);
             }
-
-            for (int p = 0; p < POINTS_IN_BLOCK; p++)
+            else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
             {
-                // select point
-                auto& new_point = current_scan_->points_[startIdx + LASER_ID_TO_RING[p % 16] + (p < 16 ? 0 : 16)];
-
-                // interpolate azimuth (VLP-16 User Manual, Ch. 9.5)
-                float az;
-                if (p < 16)
-                {
-                    az = az_block + (az_diff * 2.304f * p) / 55.296f;
-                }
-                else
-                {
-                    az = az_block + (az_diff * 2.304f * (p - 16)) / (2 * 55.296f);
-                }
+                uint32_t drops;
+                memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+                kernel_drops_ = drops;
+            }
+        }
 
-                // check angle overflow
-                if (az > 360.f)
-                {
-                    az -= 360.f;
-                }
+        if (msgs_[i].msg_len != sizeof(VelodynePacket))
+        {
+            continue;
+        }
 
-                az = deg_to_rad(az);
+        if (free_slots == 0)
+        {
+            packets_dropped_++;
+            continue;
+        }
 
-                // calculate XYZ and fill new point
-                if (packet_.blocks[b].points[p].distance > 0 && packet_.blocks[b].points[p].distance <= std::numeric_limits<ScanPointType>::max())
-                {
-                    float r = packet_.blocks[b].points[p].distance * 2 - LASER_ID_TO_OFFSET[p % 16]; // 2 mm
-                    float cos_vertical = cos(LASER_ID_TO_VERT_ANGLE[p % 16]);
-                    new_point.x() = r * cos_vertical * sin(az);
-                    new_point.y() = r * cos_vertical * cos(az);
-                    new_point.z() = r * sin(LASER_ID_TO_VERT_ANGLE[p % 16]);
-                }
-                else
-                {
-                    // out of range: set to zero
-                    new_point.x() = 0;
-                    new_point.y() = 0;
-                    new_point.z() = 0;
-                }
-            }
+        // close the gaps of invalid packets
+        auto& slot = packet_ring_.write_slot(valid);
+        if (valid != i)
+        {
+            slot.packet = packet_ring_.write_slot(i).packet;
         }
+        slot.timestamp = timestamp;
+        packets_received_++;
+        valid++;
     }
+
+    return valid;
 }
@@ -7,59 +7,43 @@
 
 #include <util/time.h>
 #include <msg/point_cloud.h>
+#include <driver/lidar/velodyne_decoder.h>
 #include <util/process_thread.h>
 #include <util/concurrent_ring_buffer.h>
+#include <util/stop_event.h>
+#include <driver/lidar/packet_ring.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <ctime>
+#include <sys/socket.h>
 
 namespace fastsense::driver
 {
 
-constexpr uint8_t POINTS_IN_BLOCK = 32;
-constexpr uint8_t BLOCKS_IN_PACKET = 12;
-
-// Do not pad the following structs as they represent encoded data
-#pragma pack(push, 1)
-
-/**
- * @brief Represents a single data point in a Velodyne packet.
- *
- */
-struct VelodyneDataPoint
-{
-    uint16_t distance;
-    uint8_t intensity;
-};
+constexpr uint8_t PACKETS_IN_BATCH = 32;
+constexpr size_t DEFAULT_PACKET_RING_SIZE = 1024;
 
 /**
- * @brief Represents a block in a Velodyne packet.
+ * @brief A received packet in the ring between the receive and the decode thread.
  *
  */
-struct VelodyneBlock
+struct PacketSlot
 {
-    uint16_t flag;
-    uint16_t azimuth;
-    VelodyneDataPoint points[POINTS_IN_BLOCK];
+    /// Raw packet
+    VelodynePacket packet;
+    /// Kernel receive time
+    fastsense::util::HighResTimePoint timestamp;
 };
 
-/**
- * @brief Represents a complete Velodyne packet.
- *
- */
-struct VelodynePacket
-{
-    VelodyneBlock blocks[BLOCKS_IN_PACKET];
-    uint32_t timestamp;
-    uint8_t mode;
-    uint8_t produkt_id;
-};
-#pragma pack(pop)
-
-// A packet must be exactly 1206 bytes long. There might be a padding error or wrong struct definition if not.
-static_assert(sizeof(VelodynePacket) == 1206);
-
 /**
  * @brief Driver for the Velodyne LIDAR.
  *
- * A new Thread is started that receives, decodes and bundles the data as point clouds.
+ * Two threads are started: the receive thread only moves the raw packets from the socket into a lock-free
+ * ring, the decode thread decodes and bundles them as point clouds. A slow decode is buffered by the ring
+ * instead of overrunning the socket. All packets that are waiting in the socket are received with one
+ * recvmmsg call directly into the ring. Every scan is stamped with the kernel receive time of its packets.
  *
  */
 class VelodyneDriver : public fastsense::util::ProcessThread
@@ -72,8 +56,11 @@ public:
      *
      * @param port Port for receiving the sensor data.
      * @param buffer Ring buffer for storing the sensor data and transfer to the next step.
+     * @param receive_buffer Size of the socket receive buffer in bytes. 0 keeps the system default.
+     * @param ring_size Number of packets that the ring between the receive and the decode thread holds.
      */
-    VelodyneDriver(uint16_t port, const fastsense::msg::PointCloudPtrStampedBuffer::Ptr& buffer);
+    VelodyneDriver(uint16_t port, const fastsense::msg::PointCloudPtrStampedBuffer::Ptr& buffer,
+                   int receive_buffer = 0, size_t ring_size = DEFAULT_PACKET_RING_SIZE);
 
     /**
      * @brief Destroy the Velodyne Driver object.
@@ -94,11 +81,17 @@ public:
     VelodyneDriver(VelodyneDriver&&) = delete;
 
     /**
-     * @brief Start receiver thread. The buffer will be cleared.
+     * @brief Start receive and decode thread. The buffer will be cleared.
      *
      */
     void start() override;
 
+    /**
+     * @brief Stop receive and decode thread.
+     *
+     */
+    void stop() override;
+
     /**
      * @brief Get the next scan.
      *
@@ -106,18 +99,90 @@ public:
      */
     fastsense::msg::PointCloudPtrStamped getScan();
 
+    /**
+     * @brief Number of valid packets received into the packet ring since the construction.
+     */
+    uint64_t packets_received() const
+    {
+        return packets_received_;
+    }
+
+    /**
+     * @brief Number of recvmmsg calls that returned packets since the construction.
+     */
+    uint64_t receive_calls() const
+    {
+        return receive_calls_;
+    }
+
+    /**
+     * @brief Number of packets dropped by the receive thread because the packet ring was full.
+     */
+    uint64_t packets_dropped() const
+    {
+        return packets_dropped_;
+    }
+
+    /**
+     * @brief Number of packets dropped by the kernel because the socket receive buffer was full.
+     */
+    uint64_t kernel_drops() const
+    {
+        return kernel_drops_;
+    }
+
+    /**
+     * @brief Highest number of packets that were waiting for the decode thread in the packet ring.
+     */
+    size_t ring_high_water() const
+    {
+        return packet_ring_.high_water();
+    }
+
+    /**
+     * @brief Number of packets that fit into the packet ring.
+     */
+    size_t ring_capacity() const
+    {
+        return packet_ring_.capacity();
+    }
+
+    /**
+     * @brief Pool of the scans.
+     */
+    const fastsense::msg::PointCloudPool& cloud_pool() const
+    {
+        return decoder_.cloud_pool();
+    }
+
+    /**
+     * @brief Set name, CPU affinity and priority of the decode thread. Applied by the next start().
+     */
+    void configure_decode(const fastsense::util::ThreadSettings& thread_settings)
+    {
+        decode_settings_ = thread_settings;
+    }
+
 protected:
     /**
-     * @brief Receives a packet. This is the main receiver thread function.
+     * @brief Receives packets into the packet ring. This is the main receiver thread function.
      *
      */
     void thread_run() override;
 
     /**
-     * @brief Decode the packet and make point clouds from the data.
+     * @brief Decodes the packets of the packet ring. This is the decode thread function.
      *
      */
-    void decode_packet();
+    void decode_run();
+
+    /**
+     * @brief Receive all waiting packets, but at least one, into the free slots of the packet ring.
+     *        Without free slots, the packets are received and dropped.
+     *
+     * @return int Number of received packets in the ring. 0 after a timeout or if the wait was woken up by the stop.
+     */
+    int receive_packets();
 
     /// Port for receiving data
     uint16_t port_;
@@ -125,17 +190,47 @@ protected:
     /// Socket file descriptor
     int sockfd_;
 
-    /// Current packet
-    VelodynePacket packet_;
+    /// Wakes up the receive thread when it is stopped
+    fastsense::util::StopEvent stop_event_;
+
+    /// Packets between the receive and the decode thread
+    PacketRing<PacketSlot> packet_ring_;
+
+    /// Receives the packets that do not fit into the packet ring
+    VelodynePacket dropped_packet_;
+
+    /// Message headers of one recvmmsg call
+    std::array<mmsghdr, PACKETS_IN_BATCH> msgs_;
 
-    /// Last azimuth
-    float az_last_;
+    /// Scatter entries of one recvmmsg call, one packet each
+    std::array<iovec, PACKETS_IN_BATCH> iovecs_;
+
+    /// Control messages of one recvmmsg call, which hold the receive timestamp and the kernel drop counter
+    std::array<std::array<char, CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(uint32_t))>, PACKETS_IN_BATCH> control_;
+
+    /// Decode thread
+    std::thread decode_thread_;
+
+    /// Name, CPU affinity and priority of the decode thread
+    fastsense::util::ThreadSettings decode_settings_;
+
+    /// Decodes the packets into scans
+    VelodyneDecoder decoder_;
 
     /// Buffer to write scans to
     fastsense::util::ConcurrentRingBuffer<fastsense::msg::PointCloudPtrStamped>::Ptr scan_buffer_;
 
-    /// Current scan
-    fastsense::msg::PointCloud::Ptr current_scan_;
+    /// Number of valid packets
+    std::atomic<uint64_t> packets_received_;
+
+    /// Number of recvmmsg calls that returned packets
+    std::atomic<uint64_t> receive_calls_;
+
+    /// Number of packets dropped because the packet ring was full
+    std::atomic<uint64_t> packets_dropped_;
+
+    /// Number of packets dropped by the kernel
+    std::atomic<uint64_t> kernel_drops_;
 };
 
 } // namespace fastsense::driver
@@ -0,0 +1,291 @@
+/**
+ * @file velodyne_decoder.cpp
+ * @author Marcel Flottmann
+ */
+
+#include <util/time.h>
+#include <cmath>
+#include <array>
+#include <vector>
+#include <stdexcept>
+
+#include <driver/lidar/velodyne_decoder.h>
+
+using namespace fastsense::driver;
+using namespace fastsense::msg;
+using namespace fastsense::util;
+
+// Magic constants of the sensor
+constexpr uint8_t PROD_ID_VLP16 = 0x22;
+constexpr uint8_t MODE_STRONGEST = 0x37;
+constexpr uint8_t MODE_LAST = 0x38;
+constexpr uint8_t MODE_DUAL = 0x39;
+constexpr uint16_t BLOCK_FLAG = 0xEEFF;
+
+/**
+ * @brief Calculate degrees to radians.
+ *
+ * @param deg Angle in degrees.
+ * @return float Calcualted angle in radians.
+ */
+constexpr float deg_to_rad(float deg)
+{
+    return deg * M_PIf32 / 180.f;
+}
+
+/// Lookup table to convert the laser id to vertical angles in radians.
+constexpr float LASER_ID_TO_VERT_ANGLE[16] =
+{
+    deg_to_rad(-15),
+    deg_to_rad(1),
+    deg_to_rad(-13),
+    deg_to_rad(3),
+    deg_to_rad(-11),
+    deg_to_rad(5),
+    deg_to_rad(-9),
+    deg_to_rad(7),
+    deg_to_rad(-7),
+    deg_to_rad(9),
+    deg_to_rad(-5),
+    deg_to_rad(11),
+    deg_to_rad(-3),
+    deg_to_rad(13),
+    deg_to_rad(-1),
+    deg_to_rad(15)
+};
+
+/// Lookup table to get the offset of a laser.
+constexpr float LASER_ID_TO_OFFSET[16] =
+{
+    11.2f,
+    -0.7f,
+    9.7f,
+    -2.2f,
+    8.1f,
+    -3.7f,
+    6.6f,
+    -5.1f,
+    5.1f,
+    -6.6f,
+    3.7f,
+    2.2f,
+    -9.7f,
+    0.7f,
+    -11.2f
+};
+
+/// Lookup table to get ring of laser.
+constexpr uint8_t LASER_ID_TO_RING[16] =
+{
+    15,
+    13,
+    11,
+    9,
+    7,
+    5,
+    3,
+    1,
+    14,
+    12,
+    10,
+    8,
+    6,
+    4,
+    2,
+    0
+};
+
+/// Number of azimuth steps of the sensor, one for every 0.01 degree
+constexpr int AZIMUTH_STEPS = 36000;
+
+/// Sine and cosine of an angle
+struct SinCos
+{
+    float sin;
+    float cos;
+};
+
+/**
+ * @brief Precomputed terms of the decoding: the vertical terms for every point of a block and the
+ *        horizontal terms for every azimuth step.
+ *
+ */
+struct DecodeTables
+{
+    /// Azimuth offset of the point in units of the azimuth difference between two blocks
+    std::array<float, POINTS_IN_BLOCK> azimuth_factor;
+    /// Distance offset of the laser of the point in mm
+    std::array<float, POINTS_IN_BLOCK> offset;
+    /// Sine of the vertical angle of the laser of the point
+    std::array<float, POINTS_IN_BLOCK> sin_vertical;
+    /// Cosine of the vertical angle of the laser of the point
+    std::array<float, POINTS_IN_BLOCK> cos_vertical;
+    /// Position of the point in the two columns of the block
+    std::array<uint8_t, POINTS_IN_BLOCK> index;
+    /// Sine and cosine of every azimuth step
+    std::vector<SinCos> azimuth;
+};
+
+/**
+ * @brief Lookup tables of the decoding, computed on the first use.
+ */
+static const DecodeTables& decode_tables()
+{
+    static const DecodeTables tables = []()
+    {
+        DecodeTables t;
+        for (int p = 0; p < POINTS_IN_BLOCK; p++)
+        {
+            int laser = p % RINGS_IN_SCAN;
+
+            // interpolate azimuth (VLP-16 User Manual, Ch. 9.5)
+            t.azimuth_factor[p] = p < RINGS_IN_SCAN ? (2.304f * p) / 55.296f : (2.304f * (p - RINGS_IN_SCAN)) / (2 * 55.296f);
+            t.offset[p] = LASER_ID_TO_OFFSET[laser];
+            t.sin_vertical[p] = std::sin(LASER_ID_TO_VERT_ANGLE[laser]);
+            t.cos_vertical[p] = std::cos(LASER_ID_TO_VERT_ANGLE[laser]);
+            t.index[p] = LASER_ID_TO_RING[laser] + (p < RINGS_IN_SCAN ? 0 : RINGS_IN_SCAN);
+        }
+
+        t.azimuth.resize(AZIMUTH_STEPS);
+        for (int step = 0; step < AZIMUTH_STEPS; step++)
+        {
+            float az = deg_to_rad(step * 0.01f);
+            t.azimuth[step] = {std::sin(az), std::cos(az)};
+        }
+        return t;
+    }();
+    return tables;
+}
+
+VelodyneDecoder::VelodyneDecoder(const PointCloudPtrStampedBuffer::Ptr& buffer) :
+    az_last_{0.f},
+    scan_buffer_{buffer},
+    // every scan in the buffer, the current one and the one being processed
+    cloud_pool_{std::make_shared<PointCloudPool>(buffer->capacity() + 2, POINTS_IN_REVOLUTION)},
+    current_scan_{},
+    last_scan_size_{0}
+{
+    new_scan();
+
+    // compute the lookup tables before the first packet arrives
+    decode_tables();
+}
+
+void VelodyneDecoder::reset()
+{
+    az_last_ = 0.f;
+    new_scan();
+}
+
+void VelodyneDecoder::decode_packet(const VelodynePacket& packet, const HighResTimePoint& timestamp)
+{
+    if (packet.produkt_id != PROD_ID_VLP16)
+    {
+        throw std::runtime_error("wrong sensor");
+    }
+
+    if (packet.mode != MODE_STRONGEST && packet.mode != MODE_LAST)
+    {
+        throw std::runtime_error("wrong mode");
+    }
+
+    const DecodeTables& tables = decode_tables();
+
+    // azimuth difference between current and next block for interpolation in 0.01 degree
+    // last block uses previous difference for simplification
+    float az_diff = 0.f;
+
+    for (int b = 0; b < BLOCKS_IN_PACKET; b++)
+    {
+        const VelodyneBlock& block = packet.blocks[b];
+        if (block.flag != BLOCK_FLAG)
+        {
+            continue;
+        }
+
+        float az_block = block.azimuth * 0.01f; // 0.01 degree
+
+        // add new scan to queue when azimuth overflows, stamped with the arrival of the overflowing packet
+        if (az_block < az_last_)
+        {
+            last_scan_size_ = current_scan_->points_.size();
+            current_scan_->arrival_ = SteadyTime::now();
+            // TODO std::move()
+            scan_buffer_->push_nb(Stamped<PointCloud::Ptr>{current_scan_, timestamp}, true);
+            new_scan();
+        }
+        az_last_ = az_block;
+
+        if (b + 1 < BLOCKS_IN_PACKET)
+        {
+            az_diff = static_cast<float>(packet.blocks[b + 1].azimuth) - block.azimuth;
+            if (packet.blocks[b + 1].azimuth < block.azimuth)
+            {
+                az_diff += AZIMUTH_STEPS;
+            }
+        }
+
+        // the packed points are unpacked first, so the loops below run on plain arrays and are vectorized.
+        // only the lookup of the azimuth terms stays scalar
+        float az_start = block.azimuth;
+        float distance[POINTS_IN_BLOCK];
+        float valid[POINTS_IN_BLOCK];
+        int step[POINTS_IN_BLOCK];
+        float sin_az[POINTS_IN_BLOCK];
+        float cos_az[POINTS_IN_BLOCK];
+
+        for (int p = 0; p < POINTS_IN_BLOCK; p++)
+        {
+            // out of range: set to zero. A distance always fits into ScanPointType
+            distance[p] = block.points[p].distance;
+            valid[p] = block.points[p].distance > 0 ? 1.f : 0.f;
+        }
+
+        #pragma omp simd
+        for (int p = 0; p < POINTS_IN_BLOCK; p++)
+        {
+            // interpolated azimuth, rounded to the next step of the lookup table
+            step[p] = static_cast<int>(az_start + az_diff * tables.azimuth_factor[p] + 0.5f) % AZIMUTH_STEPS;
+        }
+
+        for (int p = 0; p < POINTS_IN_BLOCK; p++)
+        {
+            sin_az[p] = tables.azimuth[step[p]].sin;
+            cos_az[p] = tables.azimuth[step[p]].cos;
+        }
+
+        ScanPointType x[POINTS_IN_BLOCK];
+        ScanPointType y[POINTS_IN_BLOCK];
+        ScanPointType z[POINTS_IN_BLOCK];
+
+        #pragma omp simd
+        for (int p = 0; p < POINTS_IN_BLOCK; p++)
+        {
+            float r = (distance[p] * 2 - tables.offset[p]) * valid[p]; // 2 mm
+            float r_horizontal = r * tables.cos_vertical[p];
+
+            x[p] = static_cast<ScanPointType>(r_horizontal * sin_az[p]);
+            y[p] = static_cast<ScanPointType>(r_horizontal * cos_az[p]);
+            z[p] = static_cast<ScanPointType>(r * tables.sin_vertical[p]);
+        }
+
+        // allocate points for current block: two columns with a point of every ring
+        size_t startIdx = current_scan_->points_.size();
+        current_scan_->points_.resize(startIdx + POINTS_IN_BLOCK);
+        ScanPoint* points = current_scan_->points_.data() + startIdx;
+
+        for (int p = 0; p < POINTS_IN_BLOCK; p++)
+        {
+            points[tables.index[p]] = ScanPoint(x[p], y[p], z[p]);
+        }
+    }
+}
+
+void VelodyneDecoder::new_scan()
+{
+    // the points are stored column by column, so the scan is organized with a fixed number of rings
+    current_scan_ = cloud_pool_->acquire();
+    current_scan_->rings_ = RINGS_IN_SCAN;
+    current_scan_->scaling_ = 1.0f;
+    current_scan_->points_.reserve(last_scan_size_ + POINTS_IN_BLOCK);
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+
+/**
+ * @file velodyne_decoder.h
+ * @author Marcel Flottmann
+ */
+
+#include <util/time.h>
+#include <msg/point_cloud.h>
+#include <msg/point_cloud_pool.h>
+#include <util/concurrent_ring_buffer.h>
+
+namespace fastsense::driver
+{
+
+constexpr uint8_t POINTS_IN_BLOCK = 32;
+constexpr uint8_t BLOCKS_IN_PACKET = 12;
+constexpr uint8_t RINGS_IN_SCAN = 16;
+/// Points of one revolution at 10 Hz: 754 packets per second
+constexpr size_t POINTS_IN_REVOLUTION = 76 * BLOCKS_IN_PACKET * POINTS_IN_BLOCK;
+
+// Do not pad the following structs as they represent encoded data
+#pragma pack(push, 1)
+
+/**
+ * @brief Represents a single data point in a Velodyne packet.
+ *
+ */
+struct VelodyneDataPoint
+{
+    uint16_t distance;
+    uint8_t intensity;
+};
+
+/**
+ * @brief Represents a block in a Velodyne packet.
+ *
+ */
+struct VelodyneBlock
+{
+    uint16_t flag;
+    uint16_t azimuth;
+    VelodyneDataPoint points[POINTS_IN_BLOCK];
+};
+
+/**
+ * @brief Represents a complete Velodyne packet.
+ *
+ */
+struct VelodynePacket
+{
+    VelodyneBlock blocks[BLOCKS_IN_PACKET];
+    uint32_t timestamp;
+    uint8_t mode;
+    uint8_t produkt_id;
+};
+#pragma pack(pop)
+
+// A packet must be exactly 1206 bytes long. There might be a padding error or wrong struct definition if not.
+static_assert(sizeof(VelodynePacket) == 1206);
+
+/**
+ * @brief Decodes Velodyne packets and bundles them as point clouds.
+ *
+ * A scan is complete when the azimuth overflows. The scans are taken from a pool of preallocated clouds,
+ * so the decoding does not allocate memory.
+ *
+ */
+class VelodyneDecoder
+{
+public:
+    /**
+     * @brief Construct a new Velodyne Decoder object.
+     *
+     * @param buffer Ring buffer for the complete scans.
+     */
+    explicit VelodyneDecoder(const fastsense::msg::PointCloudPtrStampedBuffer::Ptr& buffer);
+
+    /// default destructor
+    ~VelodyneDecoder() = default;
+
+    /// delete copy assignment operator
+    VelodyneDecoder& operator=(const VelodyneDecoder& other) = delete;
+
+    /// delete move assignment operator
+    VelodyneDecoder& operator=(VelodyneDecoder&&) noexcept = delete;
+
+    /// delete copy constructor
+    VelodyneDecoder(const VelodyneDecoder&) = delete;
+
+    /// delete move constructor
+    VelodyneDecoder(VelodyneDecoder&&) = delete;
+
+    /**
+     * @brief Decode the packet and make point clouds from the data.
+     *
+     * @param packet The received packet.
+     * @param timestamp Receive time of the packet. A complete scan is stamped with the time of the packet that completes it.
+     */
+    void decode_packet(const VelodynePacket& packet, const fastsense::util::HighResTimePoint& timestamp);
+
+    /**
+     * @brief Discard the current scan and start over.
+     *
+     */
+    void reset();
+
+    /**
+     * @brief The scan that is not complete yet.
+     */
+    const fastsense::msg::PointCloud& current_scan() const
+    {
+        return *current_scan_;
+    }
+
+    /**
+     * @brief Pool of the scans.
+     */
+    const fastsense::msg::PointCloudPool& cloud_pool() const
+    {
+        return *cloud_pool_;
+    }
+
+private:
+    /**
+     * @brief Start a new organized scan from the pool with at least the capacity of the last scan.
+     *
+     */
+    void new_scan();
+
+    /// Last azimuth
+    float az_last_;
+
+    /// Buffer to write scans to
+    fastsense::msg::PointCloudPtrStampedBuffer::Ptr scan_buffer_;
+
+    /// Pool of the scans
+    fastsense::msg::PointCloudPool::Ptr cloud_pool_;
+
+    /// Current scan
+    fastsense::msg::PointCloud::Ptr current_scan_;
+
+    /// Number of points of the last scan
+    size_t last_scan_size_;
+};
+
+} // namespace fastsense::driver
@@ -0,0 +1,251 @@
+/**
+ * @file velodyne_pcap.cpp
+ */
+
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <driver/lidar/velodyne_pcap.h>
+#include <util/logging/logger.h>
+
+using namespace fastsense::driver;
+using namespace fastsense::msg;
+using namespace fastsense::util;
+using namespace fastsense::util::logging;
+
+// Magic numbers of the pcap format
+constexpr uint32_t PCAP_MAGIC_MICROSECONDS = 0xa1b2c3d4;
+constexpr uint32_t PCAP_MAGIC_NANOSECONDS = 0xa1b23c4d;
+constexpr size_t PCAP_FILE_HEADER_SIZE = 24;
+constexpr size_t PCAP_RECORD_HEADER_SIZE = 16;
+
+// Link layers
+constexpr uint32_t LINKTYPE_ETHERNET = 1;
+constexpr uint32_t LINKTYPE_RAW = 101;
+constexpr uint32_t LINKTYPE_LINUX_SLL = 113;
+constexpr uint32_t LINKTYPE_IPV4 = 228;
+
+constexpr uint16_t ETHERTYPE_IPV4 = 0x0800;
+constexpr uint16_t ETHERTYPE_VLAN = 0x8100;
+constexpr uint8_t IP_PROTOCOL_UDP = 17;
+constexpr size_t UDP_HEADER_SIZE = 8;
+
+/// Longest wait for a packet, so that a stop is noticed during gaps in the file
+constexpr auto MAX_WAIT = std::chrono::milliseconds(100);
+
+/**
+ * @brief Read a 16 bit network byte order value.
+ */
+static uint16_t read_be16(const char* data)
+{
+    return static_cast<uint16_t>(static_cast<uint8_t>(data[0]) << 8 | static_cast<uint8_t>(data[1]));
+}
+
+/**
+ * @brief Read a 32 bit value of the pcap headers.
+ */
+static uint32_t read_u32(const char* data, bool swapped)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return swapped ? __builtin_bswap32(value) : value;
+}
+
+VelodynePcapDriver::VelodynePcapDriver(const std::string& file, uint16_t port, float replay_speed, const PointCloudPtrStampedBuffer::Ptr& buffer) :
+    path_{file},
+    file_{file, std::ios::binary},
+    port_{port},
+    replay_speed_{replay_speed},
+    link_type_{0},
+    swapped_{false},
+    nanoseconds_{false},
+    record_{},
+    first_time_{},
+    replay_start_{},
+    decoder_{buffer},
+    scan_buffer_{buffer},
+    packets_replayed_{0},
+    finished_{false}
+{
+    if (!file_)
+    {
+        throw std::runtime_error("failed to open pcap file " + file);
+    }
+
+    if (replay_speed < 0.f)
+    {
+        throw std::runtime_error("replay speed has to be positive, or 0 to replay as fast as possible");
+    }
+
+    char header[PCAP_FILE_HEADER_SIZE];
+    if (!file_.read(header, sizeof(header)))
+    {
+        throw std::runtime_error("pcap file is too short: " + file);
+    }
+
+    uint32_t magic = read_u32(header, false);
+    swapped_ = magic == __builtin_bswap32(PCAP_MAGIC_MICROSECONDS) || magic == __builtin_bswap32(PCAP_MAGIC_NANOSECONDS);
+    magic = read_u32(header, swapped_);
+    if (magic != PCAP_MAGIC_MICROSECONDS && magic != PCAP_MAGIC_NANOSECONDS)
+    {
+        throw std::runtime_error("not a pcap file: " + file);
+    }
+    nanoseconds_ = magic == PCAP_MAGIC_NANOSECONDS;
+
+    link_type_ = read_u32(header + 20, swapped_);
+    if (link_type_ != LINKTYPE_ETHERNET && link_type_ != LINKTYPE_RAW && link_type_ != LINKTYPE_LINUX_SLL && link_type_ != LINKTYPE_IPV4)
+    {
+        throw std::runtime_error("unsupported link layer " + std::to_string(link_type_) + " in pcap file " + file);
+    }
+}
+
+VelodynePcapDriver::~VelodynePcapDriver()
+{
+    ProcessThread::stop();
+}
+
+void VelodynePcapDriver::start()
+{
+    if (running == false)
+    {
+        running = true;
+        stop_source = StopSource{};
+        finished_ = false;
+        packets_replayed_ = 0;
+        file_.clear();
+        file_.seekg(PCAP_FILE_HEADER_SIZE);
+        decoder_.reset();
+        scan_buffer_->clear();
+        worker = std::thread(&VelodynePcapDriver::thread_run, this);
+        settings.apply(worker);
+    }
+}
+
+void VelodynePcapDriver::thread_run()
+{
+    VelodynePacket packet;
+    std::chrono::system_clock::time_point time;
+    HighResTimePoint first_stamp;
+
+    while (running)
+    {
+        if (!next_packet(packet, time))
+        {
+            Logger::info("Replay of ", path_, " finished after ", packets_replayed_, " packets");
+            finished_ = true;
+            break;
+        }
+
+        if (packets_replayed_ == 0)
+        {
+            first_time_ = time;
+            first_stamp = to_high_res_time(time);
+            replay_start_ = std::chrono::steady_clock::now();
+        }
+
+        wait_for(time);
+        if (!running)
+        {
+            break;
+        }
+
+        // the offset between the clocks is taken once, so the time differences of the file are exact
+        decoder_.decode_packet(packet, first_stamp + std::chrono::duration_cast<HighResTime::duration>(time - first_time_));
+        packets_replayed_++;
+    }
+}
+
+void VelodynePcapDriver::wait_for(const std::chrono::system_clock::time_point& time)
+{
+    if (replay_speed_ == 0.f)
+    {
+        // a scan is only completed by the next packet, so a free slot is enough to never drop a scan
+        scan_buffer_->wait_for_space(stop_token());
+        return;
+    }
+
+    auto due = replay_start_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>((time - first_time_) / replay_speed_);
+    while (running && std::chrono::steady_clock::now() < due)
+    {
+        std::this_thread::sleep_until(std::min(due, std::chrono::steady_clock::now() + MAX_WAIT));
+    }
+}
+
+bool VelodynePcapDriver::next_packet(VelodynePacket& packet, std::chrono::system_clock::time_point& time)
+{
+    char header[PCAP_RECORD_HEADER_SIZE];
+    while (file_.read(header, sizeof(header)))
+    {
+        uint32_t seconds = read_u32(header, swapped_);
+        uint32_t fraction = read_u32(header + 4, swapped_);
+        uint32_t length = read_u32(header + 8, swapped_);
+
+        record_.resize(length);
+        if (!file_.read(record_.data(), length))
+        {
+            Logger::warning("Last record of ", path_, " is truncated");
+            return false;
+        }
+
+        // link layer
+        size_t offset = 0;
+        uint16_t ethertype = ETHERTYPE_IPV4;
+        if (link_type_ == LINKTYPE_ETHERNET)
+        {
+            offset = 14;
+            if (length < offset)
+            {
+                continue;
+            }
+            ethertype = read_be16(&record_[12]);
+            if (ethertype == ETHERTYPE_VLAN && length >= 18)
+            {
+                ethertype = read_be16(&record_[16]);
+                offset = 18;
+            }
+        }
+        else if (link_type_ == LINKTYPE_LINUX_SLL)
+        {
+            offset = 16;
+            if (length < offset)
+            {
+                continue;
+            }
+            ethertype = read_be16(&record_[14]);
+        }
+        if (ethertype != ETHERTYPE_IPV4 || length < offset + 20)
+        {
+            continue;
+        }
+
+        // IPv4 without fragments
+        const char* ip = &record_[offset];
+        size_t ip_header_size = (static_cast<uint8_t>(ip[0]) & 0x0F) * 4;
+        bool fragment = (read_be16(ip + 6) & 0x3FFF) != 0;
+        if ((static_cast<uint8_t>(ip[0]) >> 4) != 4 || static_cast<uint8_t>(ip[9]) != IP_PROTOCOL_UDP || fragment)
+        {
+            continue;
+        }
+        offset += ip_header_size;
+
+        // UDP to the port of the sensor
+        if (length < offset + UDP_HEADER_SIZE)
+        {
+            continue;
+        }
+        const char* udp = &record_[offset];
+        size_t payload_size = read_be16(udp + 4) - UDP_HEADER_SIZE;
+        offset += UDP_HEADER_SIZE;
+        if (read_be16(udp + 2) != port_ || payload_size != sizeof(VelodynePacket) || length < offset + payload_size)
+        {
+            continue;
+        }
+
+        memcpy(&packet, &record_[offset], sizeof(VelodynePacket));
+        time = std::chrono::system_clock::time_point{std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                    std::chrono::seconds(seconds) + (nanoseconds_ ? std::chrono::nanoseconds(fraction) : std::chrono::microseconds(fraction)))};
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+/**
+ * @file velodyne_pcap.h
+ */
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <util/time.h>
+#include <msg/point_cloud.h>
+#include <util/process_thread.h>
+#include <driver/lidar/velodyne_decoder.h>
+
+namespace fastsense::driver
+{
+
+/**
+ * @brief Replays the Velodyne packets of a pcap file instead of receiving them from the sensor.
+ *
+ * The packets are decoded like the packets of the VelodyneDriver, either with the original timing, a scaled timing
+ * or as fast as the scans are consumed. The scans keep the original capture times of their packets.
+ * Only UDP packets to the given port over Ethernet, Linux cooked capture or raw IPv4 are replayed.
+ *
+ */
+class VelodynePcapDriver : public fastsense::util::ProcessThread
+{
+public:
+    /**
+     * @brief Construct a new Velodyne Pcap Driver object.
+     *
+     * @param file Path of the pcap file.
+     * @param port Destination port of the packets of the sensor.
+     * @param replay_speed Factor for the timing of the file. 1 replays in real time, 0 replays as fast as possible.
+     * @param buffer Ring buffer for storing the sensor data and transfer to the next step.
+     */
+    VelodynePcapDriver(const std::string& file, uint16_t port, float replay_speed, const fastsense::msg::PointCloudPtrStampedBuffer::Ptr& buffer);
+
+    /**
+     * @brief Destroy the Velodyne Pcap Driver object.
+     *
+     */
+    ~VelodynePcapDriver() override;
+
+    /// delete copy assignment operator
+    VelodynePcapDriver& operator=(const VelodynePcapDriver& other) = delete;
+
+    /// delete move assignment operator
+    VelodynePcapDriver& operator=(VelodynePcapDriver&&) noexcept = delete;
+
+    /// delete copy constructor
+    VelodynePcapDriver(const VelodynePcapDriver&) = delete;
+
+    /// delete move constructor
+    VelodynePcapDriver(VelodynePcapDriver&&) = delete;
+
+    /**
+     * @brief Start the replay from the beginning of the file. The buffer will be cleared.
+     *
+     */
+    void start() override;
+
+    /**
+     * @brief Number of packets of the sensor that were replayed since the start.
+     */
+    size_t packets_replayed() const
+    {
+        return packets_replayed_;
+    }
+
+    /**
+     * @brief Whether the end of the file was reached.
+     */
+    bool finished() const
+    {
+        return finished_;
+    }
+
+protected:
+    /**
+     * @brief Replays the packets. This is the main thread function.
+     *
+     */
+    void thread_run() override;
+
+    /**
+     * @brief Read the next packet of the sensor from the file.
+     *
+     * @param packet The packet.
+     * @param time Capture time of the packet.
+     * @return true if a packet was read, false at the end of the file.
+     */
+    bool next_packet(VelodynePacket& packet, std::chrono::system_clock::time_point& time);
+
+    /**
+     * @brief Wait until the packet is due, or as long as the buffer is full when replaying as fast as possible.
+     *
+     * @param time Capture time of the packet.
+     */
+    void wait_for(const std::chrono::system_clock::time_point& time);
+
+    /// Path of the file
+    std::string path_;
+
+    /// Pcap file
+    std::ifstream file_;
+
+    /// Destination port of the packets of the sensor
+    uint16_t port_;
+
+    /// Factor for the timing of the file
+    float replay_speed_;
+
+    /// Link layer of the captured packets
+    uint32_t link_type_;
+
+    /// Whether the file was written with the other byte order
+    bool swapped_;
+
+    /// Whether the fractions of the capture times are nanoseconds instead of microseconds
+    bool nanoseconds_;
+
+    /// Data of the current record
+    std::vector<char> record_;
+
+    /// Capture time of the first packet
+    std::chrono::system_clock::time_point first_time_;
+
+    /// Start of the replay
+    std::chrono::steady_clock::time_point replay_start_;
+
+    /// Decodes the packets into scans
+    VelodyneDecoder decoder_;
+
+    /// Buffer to write scans to
+    fastsense::msg::PointCloudPtrStampedBuffer::Ptr scan_buffer_;
+
+    /// Number of replayed packets
+    std::atomic<size_t> packets_replayed_;
+
+    /// Whether the end of the file was reached
+    std::atomic<bool> finished_;
+};
+
+} // namespace fastsense::driver
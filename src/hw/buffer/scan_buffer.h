@@ -0,0 +1,210 @@
+#pragma once
+
+/**
+ * @file scan_buffer.h
+ */
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include <hw/buffer/buffer.h>
+#include <util/point.h>
+#include <util/point_hw.h>
+#include <util/time.h>
+#include <msg/stamped.h>
+#include <util/concurrent_ring_buffer.h>
+
+namespace fastsense::buffer
+{
+
+/**
+ * @brief Device buffer with the points of one preprocessed scan
+ *
+ * The preprocessing writes the reduced points directly into this buffer. The registration and the map thread share it
+ * by reference count, so the points are not copied after the preprocessing.
+ */
+struct ScanBuffer
+{
+    using Ptr = std::shared_ptr<ScanBuffer>;
+
+    /**
+     * @brief Construct a new Scan Buffer object
+     *
+     * @param queue command queue of the buffer
+     * @param capacity number of points that fit into the buffer
+     */
+    ScanBuffer(const CommandQueuePtr& queue, size_t capacity)
+        : points_{queue, capacity},
+          num_points_{0},
+          arrival_{}
+    {
+    }
+
+    /// default destructor
+    ~ScanBuffer() = default;
+
+    /// delete copy assignment operator
+    ScanBuffer& operator=(const ScanBuffer& other) = delete;
+
+    /// delete move assignment operator
+    ScanBuffer& operator=(ScanBuffer&&) noexcept = delete;
+
+    /// delete copy constructor
+    ScanBuffer(const ScanBuffer&) = delete;
+
+    /// delete move constructor
+    ScanBuffer(ScanBuffer&&) = delete;
+
+    /**
+     * @brief Copy the valid points, e.g. to send them
+     *
+     * @param points resized to num_points_
+     */
+    void copy_to(std::vector<ScanPoint>& points) const
+    {
+        points.resize(num_points_);
+        for (int i = 0; i < num_points_; i++)
+        {
+            const auto& point = points_[i];
+            points[i] = ScanPoint(point.x, point.y, point.z);
+        }
+    }
+
+    /// Points in device memory. The buffer might be larger than num_points_
+    InputBuffer<PointHW> points_;
+
+    /// Number of valid points in points_
+    int num_points_;
+
+    /// Time the scan entered the pipeline, see msg::PointCloud::arrival_
+    util::SteadyTimePoint arrival_;
+};
+
+using ScanBufferStamped = msg::Stamped<ScanBuffer::Ptr>;
+using ScanBufferStampedBuffer = util::ConcurrentRingBuffer<ScanBufferStamped>;
+
+/**
+ * @brief Pool of ScanBuffers, so that no device memory is allocated for every scan
+ *
+ * A buffer returns to the pool when its last reference is dropped. The pool has to be created with std::make_shared.
+ */
+class ScanBufferPool : public std::enable_shared_from_this<ScanBufferPool>
+{
+public:
+    using Ptr = std::shared_ptr<ScanBufferPool>;
+
+    /**
+     * @brief Construct a new Scan Buffer Pool object without any buffers
+     *
+     * @param queue command queue of the buffers
+     */
+    explicit ScanBufferPool(const CommandQueuePtr& queue)
+        : queue_{queue},
+          mutex_{},
+          free_{},
+          allocations_{0}
+    {
+    }
+
+    /// default destructor
+    ~ScanBufferPool() = default;
+
+    /// delete copy assignment operator
+    ScanBufferPool& operator=(const ScanBufferPool& other) = delete;
+
+    /// delete move assignment operator
+    ScanBufferPool& operator=(ScanBufferPool&&) noexcept = delete;
+
+    /// delete copy constructor
+    ScanBufferPool(const ScanBufferPool&) = delete;
+
+    /// delete move constructor
+    ScanBufferPool(ScanBufferPool&&) = delete;
+
+    /**
+     * @brief Take a buffer from the pool, or allocate a new one if no free buffer is large enough
+     *
+     * @param num_points number of points that have to fit into the buffer. num_points_ is set to this value
+     * @return ScanBuffer::Ptr buffer that returns to the pool when it is not used anymore
+     */
+    ScanBuffer::Ptr acquire(size_t num_points)
+    {
+        std::unique_ptr<ScanBuffer> buffer;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            auto it = std::find_if(free_.begin(), free_.end(), [&](const auto & free)
+            {
+                return free->points_.size() >= num_points;
+            });
+            if (it != free_.end())
+            {
+                buffer = std::move(*it);
+                free_.erase(it);
+            }
+            else
+            {
+                // IMPORTANT: Delete a buffer that is too small first, the device memory is limited
+                if (!free_.empty())
+                {
+                    free_.pop_back();
+                }
+                allocations_++;
+            }
+        }
+
+        if (!buffer)
+        {
+            // leave room for larger scans
+            buffer = std::make_unique<ScanBuffer>(queue_, std::max<size_t>(num_points * 3 / 2, 1));
+        }
+        buffer->num_points_ = num_points;
+
+        std::weak_ptr<ScanBufferPool> pool = weak_from_this();
+        return ScanBuffer::Ptr(buffer.release(), [pool](ScanBuffer * released)
+        {
+            if (auto owner = pool.lock())
+            {
+                owner->release(released);
+            }
+            else
+            {
+                delete released;
+            }
+        });
+    }
+
+    /**
+     * @brief Number of buffers that were allocated by the pool
+     */
+    size_t allocations() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return allocations_;
+    }
+
+private:
+    /**
+     * @brief Return a buffer to the pool
+     *
+     * @param buffer buffer that is not referenced anymore
+     */
+    void release(ScanBuffer* buffer)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.emplace_back(buffer);
+    }
+
+    /// Command queue of the buffers
+    CommandQueuePtr queue_;
+    /// Protects the free buffers, buffers are released from any thread
+    mutable std::mutex mutex_;
+    /// Buffers that are not in use
+    std::vector<std::unique_ptr<ScanBuffer>> free_;
+    /// Number of buffers that were allocated
+    size_t allocations_;
+};
+
+} // namespace fastsense::buffer
@@ -6,11 +6,59 @@
  * @author Marcel Flottmann
  */
 
+#include <vector>
+
 #include <hw/fpga_manager.h>
 
 namespace fastsense::kernels
 {
 
+/**
+ * @brief Handle of a kernel run that was started without waiting
+ *
+ * Holds the events of the last command of the run, so that the caller can do other work and wait later.
+ * An empty handle does not wait.
+ */
+class KernelHandle
+{
+public:
+    /// an empty handle
+    KernelHandle() = default;
+
+    /**
+     * @brief Handle of the run that finishes with the events
+     *
+     * @param events events of the last command of the run
+     */
+    explicit KernelHandle(std::vector<cl::Event> events) : events_{std::move(events)}
+    {
+    }
+
+    /**
+     * @brief Wait until the run is complete. The handle is empty afterwards
+     */
+    void wait()
+    {
+        if (!events_.empty())
+        {
+            cl::Event::waitForEvents(events_);
+            events_.clear();
+        }
+    }
+
+    /**
+     * @brief Whether the handle still has to be waited for
+     */
+    bool pending() const
+    {
+        return !events_.empty();
+    }
+
+private:
+    /// Events of the last command of the run
+    std::vector<cl::Event> events_;
+};
+
 class BaseKernel
 {
 private:
@@ -91,6 +139,14 @@ public:
     {
         cl::Event::waitForEvents(post_events_);
     }
+
+    /**
+     * @brief Handle of the last run, to wait for it later instead of calling waitComplete()
+     */
+    KernelHandle handle() const
+    {
+        return KernelHandle{post_events_};
+    }
 };
 
 } // namespace fastsense::kernels
\ No newline at end of file
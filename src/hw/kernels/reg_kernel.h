@@ -8,8 +8,9 @@
 #include <hw/kernels/base_kernel.h>
 #include <map/local_map.h>
 #include <util/point_hw.h>
-#include <util/logging/logger.h>
-#include <util/filter.h>
+#include <msg/registration_stats.h>
+
+#include <chrono>
 
 namespace fastsense::kernels
 {
@@ -41,22 +42,28 @@ public:
      *
      * @param map           current local map
      * @param scan_points   points from the current velodyne scan
-     * @param local_h       reference for the local h matrix used by the software
-     * @param local_g       reference for the local g matrix used by the software
-     * @param local_error   local error ref
-     * @param local_count   local count ref
+     * @param num_points    number of valid points
+     * @param max_iterations maximum number of iterations
+     * @param it_weight_gradient decay variable for the iteration influence
+     * @param epsilon       minimum change of the error between two iterations to stop
      * @param transform     transform from last registration iteration (including imu one) - needs to be applied in the kernel
+     * @param error         mean absolute TSDF value of the last iteration
+     * @param stats         optional convergence record of this registration. The kernel does not separate the point loop
+     *                      from the solve, so the whole runtime of the kernel is counted as point loop
+     * @return int          number of iterations
      */
-    void synchronized_run(map::LocalMap& map,
-                          buffer::InputBuffer<PointHW>& point_data,
-                          int num_points,
-                          int max_iterations,
-                          float it_weight_gradient,
-                          float epsilon,
-                          Eigen::Matrix4f& transform)
+    int synchronized_run(map::LocalMap& map,
+                         buffer::InputBuffer<PointHW>& point_data,
+                         int num_points,
+                         int max_iterations,
+                         float it_weight_gradient,
+                         float epsilon,
+                         Eigen::Matrix4f& transform,
+                         float& error,
+                         msg::RegistrationStats* stats = nullptr)
     {
-        // 4x4 Matrix and Number of iterations = 17
-        buffer::OutputBuffer<float> out_transform(cmd_q_, 17);
+        // header and the error of every iteration
+        buffer::OutputBuffer<float> out_transform(cmd_q_, REG_OUT_HEADER_SIZE + max_iterations);
 
         // 4x4 Matrix and epsilon = 17
         buffer::InputBuffer<float> in_transform(cmd_q_, 17);
@@ -71,11 +78,15 @@ public:
         }
         in_transform[16] = epsilon;
 
+        auto start = std::chrono::steady_clock::now();
+
         //run the encapsulated kernel
         run(map, point_data, num_points, max_iterations, it_weight_gradient, in_transform, out_transform);
 
         waitComplete();
 
+        auto time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
         for (int row = 0; row < 4; row++)
         {
             for (int col = 0; col < 4; col++)
@@ -84,16 +95,35 @@ public:
             }
         }
 
-        static util::SlidingWindowFilter<float> filter(100);
-        static int iter_count = 0;
+        error = out_transform[17];
+        int iterations = static_cast<int>(out_transform[16]);
 
-        int i = out_transform[16];
-        filter.update(i);
-        iter_count++;
-        if (iter_count > 100 && iter_count % 20 == 0)
+        if (stats)
         {
-            fastsense::util::logging::Logger::info("Average Iterations: ", (int)filter.get_mean(), " / ", max_iterations);
+            stats->iterations_ = iterations;
+            stats->max_iterations_ = max_iterations;
+            stats->cap_hit_ = iterations >= max_iterations;
+            stats->num_points_ = num_points;
+            stats->num_hits_ = static_cast<int>(out_transform[18]);
+            stats->point_time_ = time;
+            stats->solve_time_ = 0.0f;
+
+            Eigen::Matrix<double, 6, 6> h;
+            for (int row = 0; row < 6; row++)
+            {
+                for (int col = 0; col < 6; col++)
+                {
+                    h(row, col) = out_transform[19 + row * 6 + col];
+                }
+            }
+            stats->set_condition(h);
+
+            // the last iteration is not counted if the kernel converged
+            int num_errors = std::min(iterations + 1, max_iterations);
+            stats->errors_.assign(out_transform.begin() + REG_OUT_HEADER_SIZE, out_transform.begin() + REG_OUT_HEADER_SIZE + num_errors);
         }
+
+        return iterations;
     }
 
     /**
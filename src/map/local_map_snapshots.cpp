@@ -0,0 +1,109 @@
+/**
+ * @file local_map_snapshots.cpp
+ */
+
+#include <map/local_map_snapshots.h>
+
+#include <stdexcept>
+
+namespace fastsense::map
+{
+
+LocalMapSnapshots::LocalMapSnapshots(std::unique_ptr<LocalMap> initial, size_t count)
+    : slots_{},
+      current_{0},
+      back_{0},
+      pin_retries_{0},
+      update_waits_{0},
+      released_{}
+{
+    if (!initial)
+    {
+        throw std::invalid_argument("LocalMapSnapshots need an initial map");
+    }
+    if (count < 2)
+    {
+        throw std::invalid_argument("LocalMapSnapshots need at least two copies of the map");
+    }
+
+    slots_.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        auto slot = std::make_unique<Slot>();
+        slot->map = i == 0 ? std::move(initial) : std::make_unique<LocalMap>(*slots_[0]->map);
+        slot->readers = 0;
+        slot->version = 0;
+        slot->released = &released_;
+        slots_.push_back(std::move(slot));
+    }
+}
+
+LocalMapSnapshots::Pin LocalMapSnapshots::pin()
+{
+    while (true)
+    {
+        size_t index = current_.load();
+        Slot* slot = slots_[index].get();
+        slot->readers.fetch_add(1);
+
+        // the writer only reuses copies that are not current and have no readers:
+        // if the copy is still current after counting the reader, it is safe to use
+        if (current_.load() == index)
+        {
+            return Pin{slot};
+        }
+
+        if (slot->readers.fetch_sub(1, std::memory_order_release) == 1)
+        {
+            released_.notify_all();
+        }
+        pin_retries_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+LocalMap& LocalMapSnapshots::begin_update()
+{
+    size_t current = current_.load();
+    while (true)
+    {
+        // read before checking the copies, so a release in between is not missed
+        uint32_t released = released_.value();
+        for (size_t i = 1; i < slots_.size(); i++)
+        {
+            size_t index = (current + i) % slots_.size();
+            if (slots_[index]->readers.load() == 0)
+            {
+                back_ = index;
+                slots_[back_]->map->fill_from(*slots_[current]->map);
+                return *slots_[back_]->map;
+            }
+        }
+
+        // all other copies are pinned, the readers release them after one registration or one export
+        update_waits_.fetch_add(1, std::memory_order_relaxed);
+        released_.wait(released);
+    }
+}
+
+uint64_t LocalMapSnapshots::publish()
+{
+    size_t current = current_.load();
+    if (back_ == current)
+    {
+        throw std::logic_error("LocalMapSnapshots::publish without begin_update");
+    }
+
+    uint64_t version = slots_[current]->version + 1;
+    slots_[back_]->version = version;
+
+    // back_ stays the current copy until the next begin_update
+    current_.store(back_);
+    return version;
+}
+
+uint64_t LocalMapSnapshots::version() const
+{
+    return slots_[current_.load()]->version;
+}
+
+} // namespace fastsense::map
@@ -0,0 +1,229 @@
+#pragma once
+
+/**
+ * @file local_map_snapshots.h
+ */
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <map/local_map.h>
+#include <util/futex.h>
+
+namespace fastsense::map
+{
+
+/**
+ * @brief Versioned copies of the local map, so that the registration and the map update never wait for each other.
+ *
+ * The map thread is the only writer. It updates a copy that no reader uses and publishes it atomically as the
+ * new current version. Readers pin the current version without a lock: a pin counts as a reader of its copy,
+ * and a copy with readers is never updated. A copy that is not current anymore is reclaimed by the writer as
+ * soon as its last pin is released.
+ *
+ * Three copies are enough for any number of readers: the current one, one for the update and one that a reader
+ * still pins. If the readers pin two old versions at the same time, the update waits until the first of them
+ * is released. The readers only pin a version while they use it, e.g. the export while it copies the map,
+ * so this wait is short. Every further copy would cost the device memory of a local map
+ * (about 15 MB for 201 x 201 x 95 cells) and would not save any copying: every update fills its copy once.
+ */
+class LocalMapSnapshots
+{
+    /// Copy of the map with the number of its readers
+    struct Slot
+    {
+        /// the copy
+        std::unique_ptr<LocalMap> map;
+        /// Number of pins of this copy
+        std::atomic<int> readers;
+        /// Version of the copy while it is current
+        uint64_t version;
+        /// Notified when the last pin of a copy is released
+        util::Futex* released;
+    };
+
+public:
+    using Ptr = std::shared_ptr<LocalMapSnapshots>;
+
+    /**
+     * @brief Pinned version of the map. The map is not changed and not reclaimed while it is pinned.
+     */
+    class Pin
+    {
+    public:
+        /// an empty pin
+        Pin() : slot_{nullptr}
+        {
+        }
+
+        /// release the pin
+        ~Pin()
+        {
+            release();
+        }
+
+        /// delete copy assignment operator
+        Pin& operator=(const Pin& other) = delete;
+
+        /// delete copy constructor
+        Pin(const Pin&) = delete;
+
+        /// move the pin
+        Pin(Pin&& other) noexcept : slot_{other.slot_}
+        {
+            other.slot_ = nullptr;
+        }
+
+        /// move the pin, releases the current one
+        Pin& operator=(Pin&& other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                slot_ = other.slot_;
+                other.slot_ = nullptr;
+            }
+            return *this;
+        }
+
+        /**
+         * @brief The pinned map. Readers must not change it.
+         */
+        LocalMap& map() const
+        {
+            return *slot_->map;
+        }
+
+        /// access to the pinned map
+        LocalMap* operator->() const
+        {
+            return slot_->map.get();
+        }
+
+        /// access to the pinned map
+        LocalMap& operator*() const
+        {
+            return *slot_->map;
+        }
+
+        /**
+         * @brief Version of the pinned map, increased by every publish
+         */
+        uint64_t version() const
+        {
+            return slot_->version;
+        }
+
+        /**
+         * @brief Unpin the map before the pin is destroyed
+         */
+        void release()
+        {
+            if (slot_ != nullptr)
+            {
+                if (slot_->readers.fetch_sub(1, std::memory_order_release) == 1)
+                {
+                    // only a system call if the writer waits for a copy
+                    slot_->released->notify_all();
+                }
+                slot_ = nullptr;
+            }
+        }
+
+    private:
+        friend class LocalMapSnapshots;
+
+        /// pin the slot, its reader count is already increased
+        explicit Pin(Slot* slot) : slot_{slot}
+        {
+        }
+
+        /// Pinned slot, nullptr if empty
+        Slot* slot_;
+    };
+
+    /**
+     * @brief Construct the snapshots from the initial map
+     *
+     * @param initial the first version of the map
+     * @param count number of copies of the map, 3 avoid waiting in most cases.
+     *              Every copy takes the device memory of a local map
+     */
+    explicit LocalMapSnapshots(std::unique_ptr<LocalMap> initial, size_t count = 3);
+
+    /// default destructor
+    ~LocalMapSnapshots() = default;
+
+    /// delete copy assignment operator
+    LocalMapSnapshots& operator=(const LocalMapSnapshots& other) = delete;
+
+    /// delete move assignment operator
+    LocalMapSnapshots& operator=(LocalMapSnapshots&&) noexcept = delete;
+
+    /// delete copy constructor
+    LocalMapSnapshots(const LocalMapSnapshots&) = delete;
+
+    /// delete move constructor
+    LocalMapSnapshots(LocalMapSnapshots&&) = delete;
+
+    /**
+     * @brief Pin the current version of the map without a lock
+     *
+     * @return Pin the current map, released when the pin is destroyed
+     */
+    Pin pin();
+
+    /**
+     * @brief Start an update: take a copy without readers and fill it with the current version.
+     *
+     * Only one thread may update the map. If all other copies are pinned, it sleeps until a pin is released.
+     *
+     * @return LocalMap& the map to update, published by publish()
+     */
+    LocalMap& begin_update();
+
+    /**
+     * @brief Make the map of begin_update() the current version
+     *
+     * @return uint64_t the new version
+     */
+    uint64_t publish();
+
+    /**
+     * @brief Current version, increased by every publish
+     */
+    uint64_t version() const;
+
+    /**
+     * @brief Number of pins that had to retry because the current version changed while pinning
+     */
+    uint64_t pin_retries() const
+    {
+        return pin_retries_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of times begin_update() slept because all other copies were pinned
+     */
+    uint64_t update_waits() const
+    {
+        return update_waits_.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// The copies of the map
+    std::vector<std::unique_ptr<Slot>> slots_;
+    /// Index of the current version in slots_
+    std::atomic<size_t> current_;
+    /// Index of the copy that is updated, only used by the writer
+    size_t back_;
+    /// Number of pins that had to retry
+    std::atomic<uint64_t> pin_retries_;
+    /// Number of waits of begin_update()
+    std::atomic<uint64_t> update_waits_;
+    /// Wakes up begin_update() when a copy is not pinned anymore
+    util::Futex released_;
+};
+
+} // namespace fastsense::map
@@ -36,6 +36,7 @@ public:
     : points_{}
     , rings_{}
     , scaling_{1.0f}
+    , arrival_{util::SteadyTime::now()}
     {
     }
 
@@ -44,6 +45,7 @@ public:
     : points_{}
     , rings_{}
     , scaling_{scaling}
+    , arrival_{util::SteadyTime::now()}
     {
     }
     
@@ -52,6 +54,7 @@ public:
     : points_{std::move(pcl.points_)}
     , rings_{pcl.rings_}
     , scaling_{pcl.scaling_}
+    , arrival_{pcl.arrival_}
     {
     }
 
@@ -61,6 +64,7 @@ public:
         points_ = std::move(other.points_);
         rings_ = other.rings_;
         scaling_ = other.scaling_;
+        arrival_ = other.arrival_;
         return *this;
     }
 
@@ -70,6 +74,7 @@ public:
         points_ = other.points_;
         rings_ = other.rings_;
         scaling_ = other.scaling_;
+        arrival_ = other.arrival_;
         return *this;
     }
 
@@ -78,6 +83,7 @@ public:
     : points_{p.points_}
     , rings_{p.rings_}
     , scaling_{p.scaling_}
+    , arrival_{p.arrival_}
     {
     }
 
@@ -93,6 +99,32 @@ public:
     /// Scaling factor
     float scaling_;
 
+    /**
+     * @brief Time the cloud entered the pipeline, set by the decoder when the scan is complete
+     *
+     * Unlike the sensor timestamp of the Stamped message, it is never in the past for a replayed recording,
+     * so it measures the latency inside the pipeline. Not sent over zmq.
+     */
+    util::SteadyTimePoint arrival_;
+
+    /**
+     * @brief Whether every column contains a point of every ring
+     *
+     * The filters that depend on the ring structure require an organized cloud.
+     */
+    bool organized() const
+    {
+        return rings_ > 0 && points_.size() % rings_ == 0;
+    }
+
+    /**
+     * @brief Number of columns of an organized cloud
+     */
+    size_t columns() const
+    {
+        return rings_ > 0 ? points_.size() / rings_ : 0;
+    }
+
     /**
      * @brief Turn incoming zmq message into PCL
      * 
@@ -0,0 +1,251 @@
+#pragma once
+
+/**
+ * @file point_cloud_pool.h
+ */
+
+#include <mutex>
+#include <memory>
+#include <vector>
+
+#include <msg/point_cloud.h>
+
+namespace fastsense::msg
+{
+
+/**
+ * @brief Pool of preallocated PointClouds, so that no memory is allocated for every scan
+ *
+ * A cloud returns to the pool with its point memory when its last reference is dropped, on whichever thread that happens.
+ * The control blocks of the shared pointers are recycled as well, so after the pool has grown to the number of clouds
+ * in flight, acquiring and releasing a cloud does not touch the heap. The pool has to be created with std::make_shared.
+ */
+class PointCloudPool : public std::enable_shared_from_this<PointCloudPool>
+{
+public:
+    using Ptr = std::shared_ptr<PointCloudPool>;
+
+    /**
+     * @brief Construct a new Point Cloud Pool object
+     *
+     * @param num_clouds number of clouds that are allocated up front
+     * @param capacity number of points that every cloud can hold without reallocation
+     */
+    PointCloudPool(size_t num_clouds, size_t capacity)
+        : capacity_{capacity},
+          mutex_{},
+          free_{},
+          control_blocks_{std::make_shared<ControlBlockCache>()},
+          allocations_{0}
+    {
+        free_.reserve(num_clouds);
+        for (size_t i = 0; i < num_clouds; i++)
+        {
+            free_.push_back(allocate());
+        }
+    }
+
+    /// default destructor
+    ~PointCloudPool() = default;
+
+    /// delete copy assignment operator
+    PointCloudPool& operator=(const PointCloudPool& other) = delete;
+
+    /// delete move assignment operator
+    PointCloudPool& operator=(PointCloudPool&&) noexcept = delete;
+
+    /// delete copy constructor
+    PointCloudPool(const PointCloudPool&) = delete;
+
+    /// delete move constructor
+    PointCloudPool(PointCloudPool&&) = delete;
+
+    /**
+     * @brief Take an empty cloud from the pool, or allocate a new one if all clouds are in use
+     *
+     * @return PointCloud::Ptr cloud without points and rings and scaling 1, that returns to the pool when it is not used anymore
+     */
+    PointCloud::Ptr acquire()
+    {
+        std::unique_ptr<PointCloud> cloud;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty())
+            {
+                cloud = std::move(free_.back());
+                free_.pop_back();
+            }
+        }
+
+        if (!cloud)
+        {
+            cloud = allocate();
+        }
+
+        // the points keep their memory
+        cloud->points_.clear();
+        cloud->rings_ = 0;
+        cloud->scaling_ = 1.0f;
+
+        std::weak_ptr<PointCloudPool> pool = weak_from_this();
+        return PointCloud::Ptr(cloud.release(), [pool](PointCloud * released)
+        {
+            if (auto owner = pool.lock())
+            {
+                owner->release(released);
+            }
+            else
+            {
+                delete released;
+            }
+        }, ControlBlockAllocator<PointCloud>{control_blocks_});
+    }
+
+    /**
+     * @brief Number of clouds that were allocated by the pool, including the preallocated ones
+     */
+    size_t allocations() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return allocations_;
+    }
+
+    /**
+     * @brief Number of clouds that are not in use
+     */
+    size_t available() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size();
+    }
+
+private:
+    /**
+     * @brief Memory of released control blocks of the shared pointers
+     *
+     * Shared by the pool and all control blocks, so that a control block can be released after the pool is gone.
+     */
+    struct ControlBlockCache
+    {
+        std::mutex mutex;
+        std::vector<void*> blocks;
+        size_t block_size = 0;
+
+        ~ControlBlockCache()
+        {
+            for (void* block : blocks)
+            {
+                ::operator delete(block);
+            }
+        }
+    };
+
+    /**
+     * @brief Allocator for the control blocks, which reuses the memory of released ones
+     */
+    template<typename T>
+    struct ControlBlockAllocator
+    {
+        using value_type = T;
+
+        explicit ControlBlockAllocator(const std::shared_ptr<ControlBlockCache>& cache)
+            : cache{cache}
+        {
+        }
+
+        template<typename U>
+        ControlBlockAllocator(const ControlBlockAllocator<U>& other) // NOLINT
+            : cache{other.cache}
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            // all control blocks of the pool have the same type, and therefore the same size
+            size_t size = n * sizeof(T);
+            {
+                std::lock_guard<std::mutex> lock(cache->mutex);
+                if (size == cache->block_size && !cache->blocks.empty())
+                {
+                    void* block = cache->blocks.back();
+                    cache->blocks.pop_back();
+                    return static_cast<T*>(block);
+                }
+            }
+            return static_cast<T*>(::operator new(size));
+        }
+
+        void deallocate(T* block, size_t n)
+        {
+            size_t size = n * sizeof(T);
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            if (cache->block_size == 0)
+            {
+                cache->block_size = size;
+            }
+            if (size == cache->block_size && cache->blocks.size() < cache->blocks.capacity())
+            {
+                cache->blocks.push_back(block);
+            }
+            else
+            {
+                ::operator delete(block);
+            }
+        }
+
+        template<typename U>
+        bool operator==(const ControlBlockAllocator<U>& other) const
+        {
+            return cache == other.cache;
+        }
+
+        template<typename U>
+        bool operator!=(const ControlBlockAllocator<U>& other) const
+        {
+            return cache != other.cache;
+        }
+
+        std::shared_ptr<ControlBlockCache> cache;
+    };
+
+    /**
+     * @brief Allocate a new cloud with the capacity of the pool
+     */
+    std::unique_ptr<PointCloud> allocate()
+    {
+        auto cloud = std::make_unique<PointCloud>();
+        cloud->points_.reserve(capacity_);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        allocations_++;
+        // released clouds and control blocks must fit without reallocation
+        free_.reserve(allocations_);
+        std::lock_guard<std::mutex> cache_lock(control_blocks_->mutex);
+        control_blocks_->blocks.reserve(allocations_);
+        return cloud;
+    }
+
+    /**
+     * @brief Return a cloud to the pool
+     *
+     * @param cloud cloud that is not referenced anymore
+     */
+    void release(PointCloud* cloud)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.emplace_back(cloud);
+    }
+
+    /// Number of points of a new cloud
+    size_t capacity_;
+    /// Protects the free clouds, clouds are released from any thread
+    mutable std::mutex mutex_;
+    /// Clouds that are not in use
+    std::vector<std::unique_ptr<PointCloud>> free_;
+    /// Memory of the control blocks of the clouds that are not in use
+    std::shared_ptr<ControlBlockCache> control_blocks_;
+    /// Number of clouds allocated by the pool
+    size_t allocations_;
+};
+
+} // namespace fastsense::msg
@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+ * @file preprocessing_stats.h
+ */
+
+#include <msg/stamped.h>
+#include <util/concurrent_ring_buffer.h>
+
+namespace fastsense::msg
+{
+
+/**
+ * @brief Record of the preprocessing of one scan
+ *
+ * Plain data, so it is sent as a single zmq message
+ */
+struct PreprocessingStats
+{
+    /// voxel size (in mm) of the reduction of this scan
+    int voxel_size_;
+
+    /// number of points received from the lidar
+    int num_points_in_;
+
+    /// number of points after the reduction
+    int num_points_;
+};
+
+using PreprocessingStatsStamped = Stamped<PreprocessingStats>;
+using PreprocessingStatsStampedBuffer = util::ConcurrentRingBuffer<PreprocessingStatsStamped>;
+
+} // namespace fastsense::msg
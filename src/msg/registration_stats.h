@@ -0,0 +1,142 @@
+#pragma once
+
+/**
+ * @file registration_stats.h
+ */
+
+#include <vector>
+#include <limits>
+
+#include <eigen3/Eigen/Eigenvalues>
+
+#include <msg/stamped.h>
+#include <msg/zmq_converter.h>
+#include <util/concurrent_ring_buffer.h>
+
+namespace fastsense::msg
+{
+
+/**
+ * @brief Convergence record of the registration of one scan
+ *
+ * Inherits from ZMQConverter, because it contains a dynamic data type (std::vector)
+ */
+struct RegistrationStats : public ZMQConverter
+{
+    /// default constructor
+    RegistrationStats()
+    : iterations_{0}
+    , max_iterations_{0}
+    , cap_hit_{false}
+    , num_points_{0}
+    , num_hits_{0}
+    , condition_{0.0f}
+    , point_time_{0.0f}
+    , solve_time_{0.0f}
+    , errors_{}
+    {
+    }
+
+    /// default destructor
+    ~RegistrationStats() override = default;
+
+    /// default copy assignment operator
+    RegistrationStats& operator=(const RegistrationStats& other) = default;
+
+    /// default move assignment operator
+    RegistrationStats& operator=(RegistrationStats&&) noexcept = default;
+
+    /// default copy constructor
+    RegistrationStats(const RegistrationStats&) = default;
+
+    /// default move constructor
+    RegistrationStats(RegistrationStats&&) noexcept = default;
+
+    /// number of iterations used
+    int iterations_;
+
+    /// maximum number of iterations of this scan
+    int max_iterations_;
+
+    /// true if the registration stopped because of the maximum number of iterations
+    bool cap_hit_;
+
+    /// number of points given to the solver
+    int num_points_;
+
+    /// number of points that hit an observed cell in the last iteration
+    int num_hits_;
+
+    /// condition number of H in the last iteration, infinite if a direction is not constrained
+    float condition_;
+
+    /// time (in ms) spent in the point loop, that builds H and g
+    float point_time_;
+
+    /// time (in ms) spent in solving the systems and updating the pose
+    float solve_time_;
+
+    /// mean absolute TSDF error after every iteration
+    std::vector<float> errors_;
+
+    /**
+     * @brief Set the condition number from the H matrix (ratio of the largest to the smallest eigenvalue)
+     *
+     * @param h H matrix of the last iteration
+     */
+    void set_condition(const Eigen::Matrix<double, 6, 6>& h)
+    {
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix<double, 6, 6>> solver(h, Eigen::EigenvaluesOnly);
+        double min = solver.eigenvalues().minCoeff();
+        double max = solver.eigenvalues().maxCoeff();
+        condition_ = min > 0.0 ? max / min : std::numeric_limits<float>::infinity();
+    }
+
+    /**
+     * @brief Convert zmq_multipart to RegistrationStats
+     *
+     * @param msg multipart message
+     */
+    void from_zmq_msg(zmq::multipart_t& msg) override
+    {
+        iterations_ = msg.poptyp<int>();
+        max_iterations_ = msg.poptyp<int>();
+        cap_hit_ = msg.poptyp<bool>();
+        num_points_ = msg.poptyp<int>();
+        num_hits_ = msg.poptyp<int>();
+        condition_ = msg.poptyp<float>();
+        point_time_ = msg.poptyp<float>();
+        solve_time_ = msg.poptyp<float>();
+
+        zmq::message_t errors_msg = msg.pop();
+        size_t n_errors = errors_msg.size() / sizeof(float);
+        errors_.clear();
+        errors_.reserve(n_errors);
+        std::copy_n(static_cast<float*>(errors_msg.data()), n_errors, std::back_inserter(errors_));
+    }
+
+    /**
+     * @brief Convert RegistrationStats to multipart
+     *
+     * @return zmq::multipart_t zmq multipart message
+     */
+    zmq::multipart_t to_zmq_msg() const override
+    {
+        zmq::multipart_t multi;
+        multi.addtyp(iterations_);
+        multi.addtyp(max_iterations_);
+        multi.addtyp(cap_hit_);
+        multi.addtyp(num_points_);
+        multi.addtyp(num_hits_);
+        multi.addtyp(condition_);
+        multi.addtyp(point_time_);
+        multi.addtyp(solve_time_);
+        multi.add(zmq::message_t(errors_.begin(), errors_.end()));
+        return multi;
+    }
+};
+
+using RegistrationStatsStamped = Stamped<RegistrationStats>;
+using RegistrationStatsStampedBuffer = util::ConcurrentRingBuffer<RegistrationStatsStamped>;
+
+} // namespace fastsense::msg
@@ -8,35 +8,34 @@
 #include <util/logging/logger.h>
 #include <util/config/config_manager.h>
 
-#include <unordered_set>
-
 using namespace fastsense::preprocessing;
 using fastsense::buffer::InputBuffer;
 using fastsense::util::logging::Logger;
 
-namespace std
-{
-template<> struct hash<fastsense::ScanPoint>
-{
-    std::size_t operator()(fastsense::ScanPoint const& p) const noexcept
-    {
-        long long v = ((long long)p.x() << 32) ^ ((long long)p.y() << 16) ^ (long long)p.z();
-        return std::hash<long long>()(v);
-    }
-};
-}
-
-
 Preprocessing::Preprocessing(const std::shared_ptr<PointCloudBuffer>& in_buffer,
-                             const std::shared_ptr<PointCloudBuffer>& out_buffer,
+                             const buffer::ScanBufferStampedBuffer::Ptr& out_buffer,
+                             const buffer::ScanBufferPool::Ptr& scan_pool,
                              const std::shared_ptr<PointCloudBuffer>& send_buffer,
                              bool send_original,
                              bool send_preprocessed,
-                             float scale)
-    : QueueBridge{in_buffer, out_buffer, 0, false}, send_original(send_original), send_preprocessed(send_preprocessed), send_buffer(send_buffer), scale(scale), 
+                             float scale,
+                             unsigned int threads,
+                             int median_window,
+                             float outlier_distance,
+                             int outlier_neighbors,
+                             int column_step,
+                             int target_points,
+                             float target_tolerance,
+                             int max_voxel_size)
+    : ProcessThread(), in_buffer(in_buffer), out_buffer(out_buffer), scan_pool(scan_pool),
+      send_original(send_original), send_preprocessed(send_preprocessed), send_buffer(send_buffer), scale(scale), 
       map_bounds(util::config::ConfigManager::config().slam.map_size_x() / 2 * MAP_RESOLUTION, 
                  util::config::ConfigManager::config().slam.map_size_y() / 2 * MAP_RESOLUTION, 
-                 util::config::ConfigManager::config().slam.map_size_z() / 2 * MAP_RESOLUTION)
+                 util::config::ConfigManager::config().slam.map_size_z() / 2 * MAP_RESOLUTION),
+      voxel_grid{threads}, reduced_points{},
+      range_image{}, median_window(median_window), outlier_distance(outlier_distance), outlier_neighbors(outlier_neighbors), column_step(column_step),
+      voxel_size_controller{target_points, target_tolerance, MAP_RESOLUTION, max_voxel_size}, stats_buffer{},
+      occupancy{"preprocessing"}
 {
 
 }
@@ -44,208 +43,179 @@ Preprocessing::Preprocessing(const std::shared_ptr<PointCloudBuffer>& in_buffer,
 void Preprocessing::thread_run()
 {
     fastsense::msg::PointCloudPtrStamped in_cloud;
+    auto token = stop_token();
+
+    // a restart of the SLAM does not continue with the voxel size of the previous run
+    voxel_size_controller.reset();
+    voxel_grid.set_voxel_size(voxel_size_controller.voxel_size());
+
     while (this->running)
     {
-        if (!this->in_->pop_nb(&in_cloud, DEFAULT_POP_TIMEOUT))
+        if (!in_buffer->pop(&in_cloud, token))
         {
             continue;
         }
+        occupancy.begin();
 
-        fastsense::msg::PointCloudPtrStamped out_cloud;
-        out_cloud.data_ = in_cloud.data_;
-        out_cloud.timestamp_ = in_cloud.timestamp_;
+        int num_points_in = in_cloud.data_->points_.size();
 
-        if (scale != 1.0f)
+        if (send_original)
         {
-            for (auto& point : out_cloud.data_->points_)
-            {
-                point = (point.cast<float>() * scale).cast<ScanPointType>();
-            }
+            // the filters below change the cloud while it is waiting to be sent
+            fastsense::msg::PointCloudPtrStamped original_cloud;
+            original_cloud.data_ = std::make_shared<msg::PointCloud>(*in_cloud.data_);
+            original_cloud.data_->scaling_ = 1.0f;
+            original_cloud.timestamp_ = in_cloud.timestamp_;
+            send_buffer->push_nb(original_cloud);
         }
 
-        if (send_original)
+        // the range image filters need the ring structure, which is destroyed by the reduction
+        if (outlier_neighbors > 0)
         {
-            in_cloud.data_->scaling_ = scale;
-            send_buffer->push_nb(in_cloud);
+            outlier_filter(in_cloud, outlier_distance, outlier_neighbors);
+        }
+        if (median_window > 0)
+        {
+            median_filter(in_cloud, median_window);
+        }
+        if (column_step > 1)
+        {
+            downsample_filter(in_cloud, column_step);
         }
 
+        buffer::ScanBuffer::Ptr scan = reduce_to_scan(in_cloud);
 
-        /*if (util::config::ConfigManager::config().lidar.rings() == out_cloud.data_->rings_)
+        if (stats_buffer)
         {
-            median_filter(out_cloud, 5);
+            msg::PreprocessingStats stats{voxel_grid.voxel_size(), num_points_in, scan->num_points_};
+            stats_buffer->push_nb(msg::PreprocessingStatsStamped{stats, in_cloud.timestamp_}, true);
         }
-        else
+
+        // the size of this scan decides the voxel size of the next one
+        if (voxel_size_controller.active())
         {
-            Logger::warning("Expected rings not equal to received rings! Skipping median filter");
-        }*/
-        
-        reduction_filter_closest(out_cloud);
-        this->out_->push_nb(out_cloud, true);
+            voxel_grid.set_voxel_size(voxel_size_controller.update(scan->num_points_));
+        }
 
+        // the registration transforms the scan in place, so the copy for sending is made before
         if (send_preprocessed)
         {
-            out_cloud.data_->scaling_ = scale;
+            fastsense::msg::PointCloudPtrStamped out_cloud;
+            out_cloud.data_ = std::make_shared<msg::PointCloud>(scale);
+            scan->copy_to(out_cloud.data_->points_);
+            out_cloud.timestamp_ = in_cloud.timestamp_;
             send_buffer->push_nb(out_cloud);
         }
+
+        out_buffer->push_nb(buffer::ScanBufferStamped{scan, in_cloud.timestamp_}, true);
+        occupancy.end();
     }
 }
 
-void Preprocessing::reduction_filter_average(fastsense::msg::PointCloudPtrStamped& cloud)
+fastsense::buffer::ScanBuffer::Ptr Preprocessing::reduce_to_scan(const fastsense::msg::PointCloudPtrStamped& cloud)
 {
-    auto& cloud_points = cloud.data_->points_;
+    const auto& cloud_points = cloud.data_->points_;
 
-    std::unordered_map<ScanPoint, std::pair<Vector3i, int>> point_map;
-    std::pair<Vector3i, int> default_value = std::make_pair(Vector3i::Zero(), 0);
-
-    point_map.reserve(cloud_points.size());
-
-    for (const auto& point : cloud_points)
+    voxel_grid.build(cloud_points, map_bounds, scale);
+    auto scan = scan_pool->acquire(voxel_grid.num_voxels());
+    scan->arrival_ = cloud.data_->arrival_;
+    voxel_grid.reduce(scan->points_.getVirtualAddress(), [&](const VoxelGrid::Entry * begin, const VoxelGrid::Entry * end)
     {
-        if ((point.x() == 0 && point.y() == 0 && point.z() == 0) || map_bounds.x() < std::abs(point.x()) || map_bounds.y() < std::abs(point.y()) || map_bounds.z() < std::abs(point.z()))
-        {
-            continue;
-        }
-
-        ScanPoint voxel(
-            std::floor((float)point.x() / MAP_RESOLUTION),
-            std::floor((float)point.y() / MAP_RESOLUTION),
-            std::floor((float)point.z() / MAP_RESOLUTION)
-        );
-
-        auto& avg_point = point_map.try_emplace(voxel, default_value).first->second;
-        avg_point.first += point.cast<int>();
-        avg_point.second++;
-    }
+        ScanPoint point = closest_point(cloud_points, begin, end, scale);
+        return PointHW(point.x(), point.y(), point.z());
+    });
 
-    cloud_points.resize(point_map.size());
-    int counter = 0;
-    for (auto& avg_point : point_map)
-    {
-        cloud_points[counter] = (avg_point.second.first / avg_point.second.second).cast<ScanPointType>();
-        counter++;
-    }
+    return scan;
 }
 
-void Preprocessing::reduction_filter_closest(fastsense::msg::PointCloudPtrStamped& cloud)
+void Preprocessing::set_stats_buffer(const msg::PreprocessingStatsStampedBuffer::Ptr& stats_buffer)
 {
-    auto& cloud_points = cloud.data_->points_;
-
-    std::unordered_map<ScanPoint, std::pair<ScanPoint, int>> point_map;
-    std::pair<ScanPoint, int> default_value = std::make_pair(ScanPoint::Zero(), MAP_RESOLUTION * 2);
+    this->stats_buffer = stats_buffer;
+}
 
-    point_map.reserve(cloud_points.size());
+fastsense::ScanPoint Preprocessing::closest_point(const std::vector<ScanPoint>& points, const VoxelGrid::Entry* begin, const VoxelGrid::Entry* end, float scale) const
+{
+    ScanPoint voxel_center = voxel_grid.voxel_center(VoxelGrid::scaled(points[begin->index], scale));
 
-    for (const auto& point : cloud_points)
+    // the first point with the smallest distance wins
+    ScanPoint closest = ScanPoint::Zero();
+    int closest_distance = std::numeric_limits<int>::max();
+    for (auto entry = begin; entry != end; ++entry)
     {
-        if ((point.x() == 0 && point.y() == 0 && point.z() == 0) || map_bounds.x() < std::abs(point.x()) || map_bounds.y() < std::abs(point.y()) || map_bounds.z() < std::abs(point.z()))
-        {
-            continue;
-        }
-
-        ScanPoint voxel_center(
-            std::floor((float)point.x() / MAP_RESOLUTION) * MAP_RESOLUTION + MAP_RESOLUTION / 2,
-            std::floor((float)point.y() / MAP_RESOLUTION) * MAP_RESOLUTION + MAP_RESOLUTION / 2,
-            std::floor((float)point.z() / MAP_RESOLUTION) * MAP_RESOLUTION + MAP_RESOLUTION / 2
-        );
+        ScanPoint point = VoxelGrid::scaled(points[entry->index], scale);
         int distance = (point - voxel_center).norm();
-
-        auto& closest = point_map.try_emplace(voxel_center, default_value).first->second;
-        if (distance < closest.second)
+        if (distance < closest_distance)
         {
-            closest.first = point;
-            closest.second = distance;
+            closest = point;
+            closest_distance = distance;
         }
     }
-
-    cloud_points.resize(point_map.size());
-    int counter = 0;
-    for (auto& avg_point : point_map)
-    {
-        cloud_points[counter] = avg_point.second.first;
-        counter++;
-    }
+    return closest;
 }
 
-void Preprocessing::reduction_filter_voxel_center(fastsense::msg::PointCloudPtrStamped& cloud)
+void Preprocessing::reduction_filter_average(fastsense::msg::PointCloudPtrStamped& cloud)
 {
     auto& cloud_points = cloud.data_->points_;
 
-    std::unordered_set<ScanPoint> point_set;
-
-    for (const auto& point : cloud_points)
+    voxel_grid.build(cloud_points, map_bounds);
+    voxel_grid.reduce(reduced_points, [&](const VoxelGrid::Entry * begin, const VoxelGrid::Entry * end)
     {
-        if ((point.x() == 0 && point.y() == 0 && point.z() == 0) || map_bounds.x() < std::abs(point.x()) || map_bounds.y() < std::abs(point.y()) || map_bounds.z() < std::abs(point.z()))
+        Vector3i sum = Vector3i::Zero();
+        for (auto entry = begin; entry != end; ++entry)
         {
-            continue;
+            sum += cloud_points[entry->index].cast<int>();
         }
+        return ScanPoint((sum / static_cast<int>(end - begin)).cast<ScanPointType>());
+    });
 
-        ScanPoint voxel_center(
-            std::floor((float)point.x() / MAP_RESOLUTION) * MAP_RESOLUTION + MAP_RESOLUTION / 2,
-            std::floor((float)point.y() / MAP_RESOLUTION) * MAP_RESOLUTION + MAP_RESOLUTION / 2,
-            std::floor((float)point.z() / MAP_RESOLUTION) * MAP_RESOLUTION + MAP_RESOLUTION / 2
-        );
-
-        point_set.insert(voxel_center);
-    }
-
-    cloud_points.resize(point_set.size());
-    std::copy(point_set.begin(), point_set.end(), cloud_points.begin());
+    cloud_points.swap(reduced_points);
 }
 
-
-void Preprocessing::reduction_filter_random_point(fastsense::msg::PointCloudPtrStamped& cloud)
+void Preprocessing::reduction_filter_closest(fastsense::msg::PointCloudPtrStamped& cloud)
 {
-
     auto& cloud_points = cloud.data_->points_;
 
-    std::unordered_map<ScanPoint, ScanPoint> point_map;
-
-    std::random_shuffle(cloud_points.begin(), cloud_points.end());
-
-    for (const auto& point : cloud_points)
+    voxel_grid.build(cloud_points, map_bounds);
+    voxel_grid.reduce(reduced_points, [&](const VoxelGrid::Entry * begin, const VoxelGrid::Entry * end)
     {
-        if (point.x() == 0 && point.y() == 0 && point.z() == 0)
-        {
-            continue;
-        }
+        return closest_point(cloud_points, begin, end, 1.0f);
+    });
 
-        ScanPoint voxel(
-            std::floor((float)point.x() / MAP_RESOLUTION),
-            std::floor((float)point.y() / MAP_RESOLUTION),
-            std::floor((float)point.z() / MAP_RESOLUTION)
-        );
+    cloud_points.swap(reduced_points);
+}
 
-        point_map.try_emplace(voxel, point);
-    }
+void Preprocessing::reduction_filter_voxel_center(fastsense::msg::PointCloudPtrStamped& cloud)
+{
+    auto& cloud_points = cloud.data_->points_;
 
-    cloud_points.resize(point_map.size());
-    int counter = 0;
-    for (auto& c_point : point_map)
+    voxel_grid.build(cloud_points, map_bounds);
+    voxel_grid.reduce(reduced_points, [&](const VoxelGrid::Entry * begin, const VoxelGrid::Entry*)
     {
-        cloud_points[counter] = c_point.second;
-        counter++;
-    }
+        return voxel_grid.voxel_center(cloud_points[begin->index]);
+    });
+
+    cloud_points.swap(reduced_points);
 }
 
 
-uint8_t Preprocessing::median_from_array(std::vector<ScanPoint*> medians)
+void Preprocessing::reduction_filter_random_point(fastsense::msg::PointCloudPtrStamped& cloud)
 {
-    std::vector<std::pair<int, double>> distances(medians.size());
 
-    for (uint8_t i = 0; i < distances.size(); i++)
-    {
-        distances[i].first = i;
-        distances[i].second = medians[i]->norm();
-    }
+    auto& cloud_points = cloud.data_->points_;
 
-    std::nth_element(distances.begin(), distances.begin() + distances.size() / 2, distances.end(), [](auto & left, auto & right)
+    std::random_shuffle(cloud_points.begin(), cloud_points.end());
+
+    // the sort is stable, so the first point of every voxel is a random one
+    voxel_grid.build(cloud_points);
+    voxel_grid.reduce(reduced_points, [&](const VoxelGrid::Entry * begin, const VoxelGrid::Entry*)
     {
-        return left.second < right.second;
+        return cloud_points[begin->index];
     });
 
-    return distances[distances.size() / 2].first;
+    cloud_points.swap(reduced_points);
 }
 
+
 void Preprocessing::median_filter(fastsense::msg::PointCloudPtrStamped& cloud, uint8_t window_size)
 {
     if (window_size % 2 == 0)
@@ -254,28 +224,24 @@ void Preprocessing::median_filter(fastsense::msg::PointCloudPtrStamped& cloud, u
         return;
     }
 
-    std::vector<ScanPoint> result(cloud.data_->points_.size());
-
-    int half_window_size = window_size / 2;
-
-    #pragma omp parallel for schedule(static) shared(result)
-    for (uint8_t ring = 0; ring < cloud.data_->rings_; ring++)
+    if (!range_image.median_filter(*cloud.data_, window_size))
     {
-        std::vector<ScanPoint*> window(window_size);
-        for (uint32_t point = 0; point < (cloud.data_->points_.size() / cloud.data_->rings_); point++)
-        {
-            int i = (point * cloud.data_->rings_) + ring;
-            int first_element = (i - (half_window_size * cloud.data_->rings_));
-            for (uint8_t j = 0; j < window_size; j++)
-            {
-                int index = ((first_element + (j * cloud.data_->rings_)) + cloud.data_->points_.size()) % cloud.data_->points_.size();
-                window[j] = (ScanPoint*)&cloud.data_->points_[index];
-            }
-
-            result[i] = *window[median_from_array(window)];
+        Logger::warning("Point cloud is not organized in rings! Skipping median filter");
+    }
+}
 
-        }
+void Preprocessing::outlier_filter(fastsense::msg::PointCloudPtrStamped& cloud, float max_distance, int min_neighbors)
+{
+    if (!range_image.outlier_filter(*cloud.data_, max_distance, min_neighbors))
+    {
+        Logger::warning("Point cloud is not organized in rings! Skipping outlier filter");
     }
+}
 
-    cloud.data_->points_ = result;
-}
\ No newline at end of file
+void Preprocessing::downsample_filter(fastsense::msg::PointCloudPtrStamped& cloud, int column_step)
+{
+    if (!range_image.downsample(*cloud.data_, column_step))
+    {
+        Logger::warning("Point cloud is not organized in rings! Skipping downsampling");
+    }
+}
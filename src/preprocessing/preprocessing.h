@@ -9,13 +9,18 @@
 #include <util/point_hw.h>
 #include <msg/point_cloud.h>
 #include <hw/buffer/buffer.h>
+#include <hw/buffer/scan_buffer.h>
 #include <util/point.h>
+#include <preprocessing/voxel_grid.h>
+#include <preprocessing/range_image.h>
+#include <preprocessing/voxel_size_controller.h>
+#include <msg/preprocessing_stats.h>
 
 #include <stdlib.h>
 #include <algorithm>
 
 #include <util/process_thread.h>
-#include <comm/queue_bridge.h>
+#include <util/stage_occupancy.h>
 
 namespace fastsense::preprocessing
 {
@@ -25,19 +30,75 @@ using PointCloudBuffer = util::ConcurrentRingBuffer<fastsense::msg::PointCloudPt
 /**
  * @brief This class provides functions to process raw lidar data.
  *        Namely it provides a reduction filter, a median filter and a function to convert PointCloud points to HWPoints.
+ *
+ * The thread scales, culls and reduces every scan in one pass directly into a pooled device buffer,
+ * which is passed on to the registration without copying the points.
  */
-class Preprocessing : public comm::QueueBridge<msg::PointCloudPtrStamped, true>
+class Preprocessing : public util::ProcessThread
 {
 public:
+    /**
+     * @brief Construct a new Preprocessing object
+     *
+     * @param in_buffer buffer of the incoming point clouds
+     * @param out_buffer buffer of the preprocessed scans
+     * @param scan_pool pool of the device buffers of the preprocessed scans
+     * @param send_buffer buffer of the point clouds that are sent to the host
+     * @param send_original send the point clouds before the preprocessing
+     * @param send_preprocessed send the point clouds after the preprocessing
+     * @param scale factor applied to all points
+     * @param threads number of threads of the reduction filters. 0 uses all cores
+     * @param median_window window size of the ring-wise median filter. 0 disables the filter
+     * @param outlier_distance maximum range difference of a neighbour in the outlier filter
+     * @param outlier_neighbors minimum number of neighbours to keep a point. 0 disables the filter
+     * @param column_step number of columns merged by the range image downsampling. 1 disables the downsampling
+     * @param target_points point budget per reduced scan, the voxel size is adapted to it. 0 keeps MAP_RESOLUTION
+     * @param target_tolerance relative deviation from the budget that starts an adaption of the voxel size
+     * @param max_voxel_size largest voxel size of the adaption
+     */
     Preprocessing(const std::shared_ptr<PointCloudBuffer>& in_buffer,
-                  const std::shared_ptr<PointCloudBuffer>& out_buffer,
+                  const buffer::ScanBufferStampedBuffer::Ptr& out_buffer,
+                  const buffer::ScanBufferPool::Ptr& scan_pool,
                   const std::shared_ptr<PointCloudBuffer>& send_buffer,
                   bool send_original,
                   bool send_preprocessed,
-                  float scale = 1.0);
+                  float scale = 1.0,
+                  unsigned int threads = 1,
+                  int median_window = 0,
+                  float outlier_distance = 0.0f,
+                  int outlier_neighbors = 0,
+                  int column_step = 1,
+                  int target_points = 0,
+                  float target_tolerance = 0.1f,
+                  int max_voxel_size = MAP_RESOLUTION);
 
     void thread_run() override;
 
+    /**
+     * @brief Scales, culls and reduces the PointCloud into a device buffer in one pass
+     *
+     * Same result as scaling the points followed by reduction_filter_closest, but the points are written only once.
+     *
+     * @param cloud point cloud message that contains data points from the lidar. It is not changed
+     * @return buffer::ScanBuffer::Ptr buffer from the scan pool with the reduced and scaled points
+     */
+    buffer::ScanBuffer::Ptr reduce_to_scan(const fastsense::msg::PointCloudPtrStamped& cloud);
+
+    /**
+     * @brief Publish a record of every preprocessed scan (voxel size and number of points) into the given buffer
+     *
+     * @param stats_buffer buffer for the records, nullptr disables the records
+     */
+    void set_stats_buffer(const msg::PreprocessingStatsStampedBuffer::Ptr& stats_buffer);
+
+    /**
+     * @brief Edge length of the voxels of the next reduction
+     */
+    int voxel_size() const
+    {
+        return voxel_grid.voxel_size();
+    }
+
     /**
      * @brief Reduces the PointCloud with Voxel reduction
      *
@@ -67,23 +128,61 @@ public:
      */
     void median_filter(fastsense::msg::PointCloudPtrStamped& cloud, uint8_t window_size);
 
-private:
+    /**
+     * @brief Removes points with too few neighbours of a similar range in the ring structure
+     *
+     * @param cloud point cloud message that contains data points from the lidar
+     * @param max_distance maximum range difference of a neighbour
+     * @param min_neighbors minimum number of neighbours (out of 8) to keep a point
+     */
+    void outlier_filter(fastsense::msg::PointCloudPtrStamped& cloud, float max_distance, int min_neighbors);
+
+    /**
+     * @brief Merges adjacent columns of the ring structure. The cloud stays organized
+     *
+     * @param cloud point cloud message that contains data points from the lidar
+     * @param column_step number of columns that are merged into one
+     */
+    void downsample_filter(fastsense::msg::PointCloudPtrStamped& cloud, int column_step);
 
+private:
     /**
-    * @brief This function applies a median filter to the input point cloud. The median filter will be applied ring-wise. So every point in the point cloud
-    *        will be replaced by the median point (based of the euclidian distance to the origin) of its neighbours.
-    *
-    * @param cloud point cloud message that contains data points from the lidar
-    * @param window_size determines the size of the neighbourhood that will be looked at to find the median point
-    *        NOTE: window_size has to be odd
-    */
-    uint8_t median_from_array(std::vector<ScanPoint*> medians);
+     * @brief Point of a voxel that is closest to the voxel center, the first one wins
+     *
+     * @param points points of the cloud
+     * @param begin first entry of the voxel in the voxel grid
+     * @param end end of the entries of the voxel
+     * @param scale factor applied to the points
+     */
+    ScanPoint closest_point(const std::vector<ScanPoint>& points, const VoxelGrid::Entry* begin, const VoxelGrid::Entry* end, float scale) const;
 
+    std::shared_ptr<PointCloudBuffer> in_buffer;
+    buffer::ScanBufferStampedBuffer::Ptr out_buffer;
+    buffer::ScanBufferPool::Ptr scan_pool;
     bool send_original;
     bool send_preprocessed;
     const std::shared_ptr<PointCloudBuffer> send_buffer;
     float scale;
     ScanPoint map_bounds;
+
+    /// Sorts the points by voxel for the reduction filters, reused for every scan
+    VoxelGrid voxel_grid;
+    /// Result of the reduction filters, swapped with the points of the cloud
+    std::vector<ScanPoint> reduced_points;
+
+    /// Filters on the ring structure, applied before the reduction
+    RangeImage range_image;
+    int median_window;
+    float outlier_distance;
+    int outlier_neighbors;
+    int column_step;
+
+    /// Adapts the voxel size of the reduction to the point budget
+    VoxelSizeController voxel_size_controller;
+    /// Records of the preprocessed scans, nullptr if nobody listens
+    msg::PreprocessingStatsStampedBuffer::Ptr stats_buffer;
+    /// Busy time and throughput of the preprocessing stage
+    util::StageOccupancy occupancy;
 };
 
 }
\ No newline at end of file
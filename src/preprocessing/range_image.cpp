@@ -0,0 +1,183 @@
+/**
+ * @file range_image.cpp
+ */
+
+#include "range_image.h"
+
+#include <util/thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace fastsense;
+using namespace fastsense::msg;
+using namespace fastsense::preprocessing;
+
+/// Range and index of a point, sorted by range
+using RangeIndex = std::pair<float, size_t>;
+
+RangeImage::RangeImage()
+    : ranges_{},
+      result_{},
+      rings_{0},
+      columns_{0}
+{
+}
+
+bool RangeImage::build(const PointCloud& cloud)
+{
+    if (!cloud.organized())
+    {
+        return false;
+    }
+
+    rings_ = cloud.rings_;
+    columns_ = cloud.columns();
+
+    const auto& points = cloud.points_;
+    ranges_.resize(points.size());
+
+    util::ThreadPool::get_instance().parallel_for(0, points.size(), [&](size_t i)
+    {
+        ranges_[i] = points[i].isZero() ? 0.0f : points[i].cast<float>().norm();
+    });
+    return true;
+}
+
+bool RangeImage::median_filter(PointCloud& cloud, int window_size)
+{
+    if (window_size % 2 == 0 || !build(cloud))
+    {
+        return false;
+    }
+
+    const auto& points = cloud.points_;
+    result_.resize(points.size());
+
+    size_t half_window = std::min<size_t>(window_size / 2, columns_ / 2);
+
+    util::ThreadPool::get_instance().parallel_for(0, rings_, [&](size_t ring)
+    {
+        std::vector<RangeIndex> window;
+        window.reserve(half_window * 2 + 1);
+
+        for (size_t column = 0; column < columns_; column++)
+        {
+            size_t i = column * rings_ + ring;
+            if (ranges_[i] == 0.0f)
+            {
+                result_[i] = ScanPoint::Zero();
+                continue;
+            }
+
+            window.clear();
+            size_t first = column + columns_ - half_window;
+            for (size_t j = first; j <= first + half_window * 2; j++)
+            {
+                size_t index = (j % columns_) * rings_ + ring;
+                if (ranges_[index] != 0.0f)
+                {
+                    window.emplace_back(ranges_[index], index);
+                }
+            }
+
+            auto median = window.begin() + window.size() / 2;
+            std::nth_element(window.begin(), median, window.end());
+            result_[i] = points[median->second];
+        }
+    });
+
+    cloud.points_.swap(result_);
+    return true;
+}
+
+bool RangeImage::outlier_filter(PointCloud& cloud, float max_distance, int min_neighbors)
+{
+    if (!build(cloud))
+    {
+        return false;
+    }
+
+    auto& points = cloud.points_;
+
+    // the decision is made on the ranges before the filter, so the points can be removed in place
+    util::ThreadPool::get_instance().parallel_for(0, columns_, [&](size_t column)
+    {
+        size_t previous = (column + columns_ - 1) % columns_;
+        size_t next = (column + 1) % columns_;
+
+        for (size_t ring = 0; ring < rings_; ring++)
+        {
+            float range = ranges_[column * rings_ + ring];
+            if (range == 0.0f)
+            {
+                continue;
+            }
+
+            int neighbors = 0;
+            for (size_t c : {previous, column, next})
+            {
+                for (size_t r = ring > 0 ? ring - 1 : 0; r <= ring + 1 && r < rings_; r++)
+                {
+                    float neighbor = ranges_[c * rings_ + r];
+                    neighbors += neighbor != 0.0f && std::abs(neighbor - range) <= max_distance;
+                }
+            }
+
+            // the point itself was counted as well
+            if (neighbors - 1 < min_neighbors)
+            {
+                points[column * rings_ + ring] = ScanPoint::Zero();
+            }
+        }
+    });
+
+    return true;
+}
+
+bool RangeImage::downsample(PointCloud& cloud, int column_step)
+{
+    if (column_step <= 0 || !build(cloud))
+    {
+        return false;
+    }
+
+    const auto& points = cloud.points_;
+    size_t step = column_step;
+    size_t out_columns = (columns_ + step - 1) / step;
+    result_.resize(out_columns * rings_);
+
+    util::ThreadPool::get_instance().parallel_for(0, rings_, [&](size_t ring)
+    {
+        std::vector<RangeIndex> block;
+        block.reserve(step);
+
+        for (size_t out_column = 0; out_column < out_columns; out_column++)
+        {
+            block.clear();
+            size_t end = std::min(columns_, (out_column + 1) * step);
+            for (size_t column = out_column * step; column < end; column++)
+            {
+                size_t index = column * rings_ + ring;
+                if (ranges_[index] != 0.0f)
+                {
+                    block.emplace_back(ranges_[index], index);
+                }
+            }
+
+            auto& target = result_[out_column * rings_ + ring];
+            if (block.empty())
+            {
+                target = ScanPoint::Zero();
+                continue;
+            }
+
+            auto median = block.begin() + (block.size() - 1) / 2;
+            std::nth_element(block.begin(), median, block.end());
+            target = points[median->second];
+        }
+    });
+
+    cloud.points_.swap(result_);
+    return true;
+}
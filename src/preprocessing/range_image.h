@@ -0,0 +1,96 @@
+#pragma once
+
+/**
+ * @file range_image.h
+ */
+
+#include <vector>
+
+#include <msg/point_cloud.h>
+
+namespace fastsense::preprocessing
+{
+
+/**
+ * @brief Filters on the ring structure of an organized point cloud
+ *
+ * The cloud is seen as an image with one row per ring and one column per firing of the lidar, as delivered by the driver.
+ * The range of every point is computed once per filter, so every filter only looks at a fixed neighbourhood of each point
+ * and runs in O(n). Invalid points (at the origin) are ignored by all filters and stay invalid.
+ *
+ * The columns are cyclic, because a scan is a full rotation of the lidar.
+ */
+class RangeImage
+{
+public:
+    /// default constructor
+    RangeImage();
+
+    /// default destructor
+    ~RangeImage() = default;
+
+    /// delete copy assignment operator
+    RangeImage& operator=(const RangeImage& other) = delete;
+
+    /// delete move assignment operator
+    RangeImage& operator=(RangeImage&&) noexcept = delete;
+
+    /// delete copy constructor
+    RangeImage(const RangeImage&) = delete;
+
+    /// delete move constructor
+    RangeImage(RangeImage&&) = delete;
+
+    /**
+     * @brief Replace every valid point by the valid point with the median range in its window on the same ring
+     *
+     * @param cloud organized point cloud
+     * @param window_size number of columns of the window, has to be odd
+     * @return false if the cloud is not organized or the window size is even. The cloud is not changed in that case
+     */
+    bool median_filter(msg::PointCloud& cloud, int window_size);
+
+    /**
+     * @brief Remove points that have too few neighbours with a similar range
+     *
+     * The neighbours are the 8 surrounding points in the image. Removed points are set to the origin.
+     *
+     * @param cloud organized point cloud
+     * @param max_distance maximum range difference of a neighbour
+     * @param min_neighbors minimum number of neighbours within max_distance to keep a point
+     * @return false if the cloud is not organized. The cloud is not changed in that case
+     */
+    bool outlier_filter(msg::PointCloud& cloud, float max_distance, int min_neighbors);
+
+    /**
+     * @brief Merge column_step adjacent columns of every ring into one point
+     *
+     * The valid point with the (lower) median range of a block is kept, so the cloud stays organized.
+     * A block without valid points results in an invalid point.
+     *
+     * @param cloud organized point cloud
+     * @param column_step number of columns that are merged
+     * @return false if the cloud is not organized. The cloud is not changed in that case
+     */
+    bool downsample(msg::PointCloud& cloud, int column_step);
+
+private:
+    /**
+     * @brief Compute the ranges of all points of the cloud
+     *
+     * @param cloud point cloud
+     * @return false if the cloud is not organized
+     */
+    bool build(const msg::PointCloud& cloud);
+
+    /// Range of every point, 0 for invalid points
+    std::vector<float> ranges_;
+    /// Result of the median filter and the downsampling, swapped with the points of the cloud
+    std::vector<ScanPoint> result_;
+    /// Number of rings of the last cloud
+    size_t rings_;
+    /// Number of columns of the last cloud
+    size_t columns_;
+};
+
+} // namespace fastsense::preprocessing
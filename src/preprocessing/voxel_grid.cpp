@@ -0,0 +1,283 @@
+/**
+ * @file voxel_grid.cpp
+ */
+
+#include "voxel_grid.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <util/thread_pool.h>
+
+using namespace fastsense;
+using namespace fastsense::preprocessing;
+
+/**
+ * @brief Number of bits necessary to store the value
+ */
+static int bit_width(uint64_t value)
+{
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+/**
+ * @brief Number of different keys in a sorted range
+ */
+static size_t count_voxels(const VoxelGrid::Entry* begin, const VoxelGrid::Entry* end)
+{
+    if (begin == end)
+    {
+        return 0;
+    }
+
+    size_t count = 1;
+    for (auto entry = begin + 1; entry != end; ++entry)
+    {
+        count += entry->key != (entry - 1)->key;
+    }
+    return count;
+}
+
+VoxelGrid::VoxelGrid(unsigned int threads)
+    : threads_{threads > 0 ? threads : static_cast<unsigned int>(util::ThreadPool::get_instance().concurrency())},
+      scale_{1.0f},
+      voxel_size_{0},
+      voxel_shift_{-1},
+      keys_{},
+      chunk_min_(threads_),
+      chunk_max_(threads_),
+      entries_{},
+      buffer_{},
+      histograms_(threads_, std::vector<size_t>(RADIX_SIZE)),
+      chunk_counts_(threads_ * threads_),
+      partition_offsets_(threads_ + 1, 0),
+      voxel_offsets_(threads_ + 1, 0)
+{
+    set_voxel_size(MAP_RESOLUTION);
+}
+
+void VoxelGrid::set_voxel_size(int voxel_size)
+{
+    if (voxel_size <= 0)
+    {
+        throw std::runtime_error("voxel size has to be positive");
+    }
+
+    voxel_size_ = voxel_size;
+    voxel_shift_ = (voxel_size & (voxel_size - 1)) == 0 ? __builtin_ctz(voxel_size) : -1;
+}
+
+void VoxelGrid::build(const std::vector<ScanPoint>& points, const ScanPoint& bounds, float scale)
+{
+    size_t n = points.size();
+    scale_ = scale;
+    keys_.resize(n);
+
+    auto& pool = util::ThreadPool::get_instance();
+
+    // every chunk of the input finds its own voxel range, which are merged afterwards
+    size_t chunk_size = (n + threads_ - 1) / threads_;
+
+    pool.parallel_for(0, threads_, [&](size_t chunk)
+    {
+        ScanPoint local_min = ScanPoint::Constant(std::numeric_limits<ScanPointType>::max());
+        ScanPoint local_max = ScanPoint::Constant(std::numeric_limits<ScanPointType>::min());
+
+        size_t end = std::min(n, (chunk + 1) * chunk_size);
+        for (size_t i = chunk * chunk_size; i < end; i++)
+        {
+            ScanPoint point = scaled(points[i], scale_);
+            if ((point.x() == 0 && point.y() == 0 && point.z() == 0) || bounds.x() < std::abs(point.x()) || bounds.y() < std::abs(point.y()) || bounds.z() < std::abs(point.z()))
+            {
+                keys_[i] = INVALID_KEY;
+                continue;
+            }
+
+            keys_[i] = 0;
+            ScanPoint v = voxel(point);
+            local_min = local_min.cwiseMin(v);
+            local_max = local_max.cwiseMax(v);
+        }
+
+        chunk_min_[chunk] = local_min;
+        chunk_max_[chunk] = local_max;
+    });
+
+    ScanPoint min = ScanPoint::Constant(std::numeric_limits<ScanPointType>::max());
+    ScanPoint max = ScanPoint::Constant(std::numeric_limits<ScanPointType>::min());
+    for (size_t chunk = 0; chunk < threads_; chunk++)
+    {
+        min = min.cwiseMin(chunk_min_[chunk]);
+        max = max.cwiseMax(chunk_max_[chunk]);
+    }
+
+    if (min.x() > max.x())
+    {
+        entries_.clear();
+        std::fill(partition_offsets_.begin(), partition_offsets_.end(), 0);
+        std::fill(voxel_offsets_.begin(), voxel_offsets_.end(), 0);
+        return;
+    }
+
+    // mixed radix key relative to the voxel range of the scan: only the occupied range needs to be sorted
+    uint64_t size_x = static_cast<int64_t>(max.x()) - min.x() + 1;
+    uint64_t size_y = static_cast<int64_t>(max.y()) - min.y() + 1;
+    uint64_t size_z = static_cast<int64_t>(max.z()) - min.z() + 1;
+    if (bit_width(size_x) + bit_width(size_y) + bit_width(size_z) > 64)
+    {
+        // the range does not fit into the key, which only happens with garbage points
+        fallback_sort(points);
+        return;
+    }
+    int key_bits = bit_width(size_x * size_y * size_z - 1);
+
+    // count the points of every chunk of the input per partition
+    pool.parallel_for(0, threads_, [&](size_t chunk)
+    {
+        size_t* counts = &chunk_counts_[chunk * threads_];
+        std::fill(counts, counts + threads_, 0);
+
+        size_t end = std::min(n, (chunk + 1) * chunk_size);
+        for (size_t i = chunk * chunk_size; i < end; i++)
+        {
+            if (keys_[i] == INVALID_KEY)
+            {
+                continue;
+            }
+
+            ScanPoint v = voxel(scaled(points[i], scale_));
+            uint64_t key = ((v.x() - min.x()) * size_y + (v.y() - min.y())) * size_z + (v.z() - min.z());
+            keys_[i] = key;
+            counts[partition(key)]++;
+        }
+    });
+
+    // every chunk writes to its own range of every partition, in the order of the input
+    size_t total = 0;
+    for (size_t partition = 0; partition < threads_; partition++)
+    {
+        partition_offsets_[partition] = total;
+        for (size_t chunk = 0; chunk < threads_; chunk++)
+        {
+            size_t count = chunk_counts_[chunk * threads_ + partition];
+            chunk_counts_[chunk * threads_ + partition] = total;
+            total += count;
+        }
+    }
+    partition_offsets_[threads_] = total;
+
+    entries_.resize(total);
+    buffer_.resize(total);
+
+    pool.parallel_for(0, threads_, [&](size_t chunk)
+    {
+        size_t* offsets = &chunk_counts_[chunk * threads_];
+        size_t end = std::min(n, (chunk + 1) * chunk_size);
+        for (size_t i = chunk * chunk_size; i < end; i++)
+        {
+            uint64_t key = keys_[i];
+            if (key != INVALID_KEY)
+            {
+                entries_[offsets[partition(key)]++] = {key, static_cast<uint32_t>(i)};
+            }
+        }
+    });
+
+    pool.parallel_for(0, threads_, [&](size_t partition)
+    {
+        radix_sort(partition, key_bits);
+        voxel_offsets_[partition + 1] = count_voxels(entries_.data() + partition_offsets_[partition],
+                                                     entries_.data() + partition_offsets_[partition + 1]);
+    });
+
+    voxel_offsets_[0] = 0;
+    for (size_t partition = 0; partition < threads_; partition++)
+    {
+        voxel_offsets_[partition + 1] += voxel_offsets_[partition];
+    }
+}
+
+void VoxelGrid::radix_sort(size_t partition, int key_bits)
+{
+    size_t n = partition_offsets_[partition + 1] - partition_offsets_[partition];
+    if (n == 0)
+    {
+        return;
+    }
+
+    Entry* src = entries_.data() + partition_offsets_[partition];
+    Entry* dst = buffer_.data() + partition_offsets_[partition];
+    auto& histogram = histograms_[partition];
+    bool in_buffer = false;
+
+    for (int shift = 0; shift < key_bits; shift += RADIX_BITS)
+    {
+        std::fill(histogram.begin(), histogram.end(), 0);
+        for (auto entry = src; entry != src + n; ++entry)
+        {
+            histogram[(entry->key >> shift) & (RADIX_SIZE - 1)]++;
+        }
+
+        // all keys share this digit
+        if (histogram[(src->key >> shift) & (RADIX_SIZE - 1)] == n)
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (auto& count : histogram)
+        {
+            size_t tmp = count;
+            count = offset;
+            offset += tmp;
+        }
+
+        for (auto entry = src; entry != src + n; ++entry)
+        {
+            dst[histogram[(entry->key >> shift) & (RADIX_SIZE - 1)]++] = *entry;
+        }
+        std::swap(src, dst);
+        in_buffer = !in_buffer;
+    }
+
+    if (in_buffer)
+    {
+        std::copy(src, src + n, dst);
+    }
+}
+
+void VoxelGrid::fallback_sort(const std::vector<ScanPoint>& points)
+{
+    entries_.clear();
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        if (keys_[i] != INVALID_KEY)
+        {
+            entries_.push_back({0, static_cast<uint32_t>(i)});
+        }
+    }
+
+    std::stable_sort(entries_.begin(), entries_.end(), [&](const Entry & a, const Entry & b)
+    {
+        ScanPoint va = voxel(scaled(points[a.index], scale_));
+        ScanPoint vb = voxel(scaled(points[b.index], scale_));
+        return std::lexicographical_compare(va.data(), va.data() + 3, vb.data(), vb.data() + 3);
+    });
+
+    uint64_t key = 0;
+    for (size_t i = 1; i < entries_.size(); i++)
+    {
+        if (voxel(scaled(points[entries_[i].index], scale_)) != voxel(scaled(points[entries_[i - 1].index], scale_)))
+        {
+            key++;
+        }
+        entries_[i].key = key;
+    }
+
+    // everything is in the first partition
+    partition_offsets_[0] = 0;
+    std::fill(partition_offsets_.begin() + 1, partition_offsets_.end(), entries_.size());
+    voxel_offsets_[0] = 0;
+    std::fill(voxel_offsets_.begin() + 1, voxel_offsets_.end(), count_voxels(entries_.data(), entries_.data() + entries_.size()));
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+/**
+ * @file voxel_grid.h
+ */
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <utility>
+
+#include <util/point.h>
+#include <util/constants.h>
+#include <util/thread_pool.h>
+
+namespace fastsense::preprocessing
+{
+
+/**
+ * @brief Groups the points of a scan by the voxel (map cell) they lie in
+ *
+ * Every valid point gets a packed 64-bit key of its voxel. The keys are compacted to the voxel range of the scan,
+ * so that a radix sort over the few significant bits is enough to bring all points of a voxel next to each other.
+ * The sort is stable, so the points of a voxel keep their order of the input.
+ *
+ * With more than one thread, the points are partitioned by a hash of their key. Every voxel lies in exactly one
+ * partition, so the partitions are sorted and reduced independently and their results are written to disjoint
+ * ranges of the output.
+ *
+ * All memory is kept between scans, so after the first scans no allocations are necessary.
+ */
+class VoxelGrid
+{
+public:
+    /// Voxel key and index of a point in the input
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    /**
+     * @brief Construct a new Voxel Grid object without any points
+     *
+     * @param threads number of partitions, which are processed in parallel by the ThreadPool. 0 uses one per thread of the pool
+     */
+    explicit VoxelGrid(unsigned int threads = 1);
+
+    /// default destructor
+    ~VoxelGrid() = default;
+
+    /// delete copy assignment operator
+    VoxelGrid& operator=(const VoxelGrid& other) = delete;
+
+    /// delete move assignment operator
+    VoxelGrid& operator=(VoxelGrid&&) noexcept = delete;
+
+    /// delete copy constructor
+    VoxelGrid(const VoxelGrid&) = delete;
+
+    /// delete move constructor
+    VoxelGrid(VoxelGrid&&) = delete;
+
+    /**
+     * @brief Sort the valid points by their voxel
+     *
+     * Points at the origin (invalid measurements) and points outside of the bounds are ignored.
+     * The scale is applied on the fly, so the points do not have to be scaled in a separate pass.
+     *
+     * @param points points of the scan
+     * @param bounds maximum absolute value of the scaled coordinates
+     * @param scale factor applied to all points
+     */
+    void build(const std::vector<ScanPoint>& points,
+               const ScanPoint& bounds = ScanPoint::Constant(std::numeric_limits<ScanPointType>::max()),
+               float scale = 1.0f);
+
+    /**
+     * @brief Reduce every occupied voxel of the last build to one point
+     *
+     * The partitions are reduced in parallel. The points of a partition are stored after the points of all previous partitions.
+     *
+     * @param out room for num_voxels() points, receives the reduced points
+     * @param f function with the signature T(const Entry* begin, const Entry* end)
+     */
+    template<typename T, typename F>
+    void reduce(T* out, F&& f) const
+    {
+        util::ThreadPool::get_instance().parallel_for(0, threads_, [&](size_t partition)
+        {
+            T* target = out + voxel_offsets_[partition];
+            const Entry* end = entries_.data() + partition_offsets_[partition + 1];
+            const Entry* begin = entries_.data() + partition_offsets_[partition];
+            while (begin != end)
+            {
+                const Entry* next = begin + 1;
+                while (next != end && next->key == begin->key)
+                {
+                    ++next;
+                }
+                *target++ = f(begin, next);
+                begin = next;
+            }
+        });
+    }
+
+    /**
+     * @brief Reduce every occupied voxel of the last build to one point
+     *
+     * @param out resized to the number of occupied voxels, receives the reduced points
+     * @param f function with the signature ScanPoint(const Entry* begin, const Entry* end)
+     */
+    template<typename F>
+    void reduce(std::vector<ScanPoint>& out, F&& f) const
+    {
+        out.resize(num_voxels());
+        reduce(out.data(), std::forward<F>(f));
+    }
+
+    /**
+     * @brief Number of occupied voxels of the last build
+     */
+    inline size_t num_voxels() const
+    {
+        return voxel_offsets_[threads_];
+    }
+
+    /**
+     * @brief Number of threads and partitions
+     */
+    inline unsigned int threads() const
+    {
+        return threads_;
+    }
+
+    /**
+     * @brief Edge length of the voxels
+     */
+    inline int voxel_size() const
+    {
+        return voxel_size_;
+    }
+
+    /**
+     * @brief Set the edge length of the voxels for the next builds
+     *
+     * Powers of two use a shift instead of a division.
+     *
+     * @param voxel_size edge length in the unit of the points, MAP_RESOLUTION by default
+     */
+    void set_voxel_size(int voxel_size);
+
+    /**
+     * @brief Voxel index of a point, same as std::floor(point / voxel_size)
+     */
+    inline ScanPoint voxel(const ScanPoint& point) const
+    {
+        if (voxel_shift_ >= 0)
+        {
+            return ScanPoint(point.x() >> voxel_shift_, point.y() >> voxel_shift_, point.z() >> voxel_shift_);
+        }
+        return ScanPoint(floor_div(point.x()), floor_div(point.y()), floor_div(point.z()));
+    }
+
+    /**
+     * @brief Point multiplied by the scale
+     */
+    static inline ScanPoint scaled(const ScanPoint& point, float scale)
+    {
+        return scale == 1.0f ? point : ScanPoint((point.cast<float>() * scale).cast<ScanPointType>());
+    }
+
+    /**
+     * @brief Center of the voxel of a point
+     */
+    inline ScanPoint voxel_center(const ScanPoint& point) const
+    {
+        return voxel(point) * voxel_size_ + ScanPoint::Constant(voxel_size_ / 2);
+    }
+
+private:
+    /**
+     * @brief Division by the voxel size, rounded towards negative infinity
+     */
+    inline ScanPointType floor_div(ScanPointType value) const
+    {
+        ScanPointType quotient = value / voxel_size_;
+        return quotient - (value % voxel_size_ < 0);
+    }
+
+    /// Bits that are sorted per radix pass
+    static constexpr int RADIX_BITS = 11;
+    static constexpr size_t RADIX_SIZE = 1 << RADIX_BITS;
+
+    /// Key of points that are ignored
+    static constexpr uint64_t INVALID_KEY = std::numeric_limits<uint64_t>::max();
+
+    /**
+     * @brief Partition of a key
+     */
+    inline size_t partition(uint64_t key) const
+    {
+        // fibonacci hashing spreads neighboring voxels over all partitions
+        return ((key * 0x9E3779B97F4A7C15ull) >> 32) % threads_;
+    }
+
+    /**
+     * @brief Stable LSD radix sort of the entries of one partition by the lowest key_bits bits of the keys
+     *
+     * @param partition partition to sort
+     * @param key_bits number of significant bits of the keys
+     */
+    void radix_sort(size_t partition, int key_bits);
+
+    /**
+     * @brief Sort all valid points in one partition, if the key range does not fit into 64 bits
+     *
+     * @param points points of the scan
+     */
+    void fallback_sort(const std::vector<ScanPoint>& points);
+
+    /// Number of threads and partitions
+    unsigned int threads_;
+    /// Scale of the last build
+    float scale_;
+    /// Edge length of the voxels
+    int voxel_size_;
+    /// log2(voxel_size_) if it is a power of two, the shift replaces the floor division. -1 otherwise
+    int voxel_shift_;
+
+    /// Voxel key of every point, INVALID_KEY for ignored points
+    std::vector<uint64_t> keys_;
+    /// Voxel range of the valid points of every chunk of the input
+    std::vector<ScanPoint> chunk_min_;
+    std::vector<ScanPoint> chunk_max_;
+    /// Entries of the valid points, grouped by partition and sorted by key after build
+    std::vector<Entry> entries_;
+    /// Second buffer of the radix sort
+    std::vector<Entry> buffer_;
+    /// Histogram of one radix pass for every partition
+    std::vector<std::vector<size_t>> histograms_;
+    /// Number of points of every chunk of the input in every partition
+    std::vector<size_t> chunk_counts_;
+    /// Start of every partition in entries_, followed by the total number of entries
+    std::vector<size_t> partition_offsets_;
+    /// Start of every partition in the reduced points, followed by the total number of voxels
+    std::vector<size_t> voxel_offsets_;
+};
+
+} // namespace fastsense::preprocessing
@@ -0,0 +1,67 @@
+/**
+ * @file voxel_size_controller.cpp
+ */
+
+#include "voxel_size_controller.h"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace fastsense::preprocessing;
+
+VoxelSizeController::VoxelSizeController(int target_points, float tolerance, int min_size, int max_size)
+    : target_points_{target_points},
+      tolerance_{tolerance},
+      min_size_{min_size},
+      max_size_{std::max(min_size, max_size)},
+      voxel_size_{min_size},
+      correcting_{false}
+{
+    if (min_size <= 0)
+    {
+        throw std::runtime_error("The voxel size has to be positive");
+    }
+}
+
+void VoxelSizeController::reset()
+{
+    voxel_size_ = min_size_;
+    correcting_ = false;
+}
+
+int VoxelSizeController::update(int num_points)
+{
+    if (!active())
+    {
+        return voxel_size_;
+    }
+
+    float ratio = static_cast<float>(num_points) / target_points_;
+    float deviation = std::abs(ratio - 1.0f);
+
+    if (deviation > tolerance_)
+    {
+        correcting_ = true;
+    }
+    else if (deviation <= tolerance_ / 2.0f)
+    {
+        correcting_ = false;
+    }
+
+    if (correcting_)
+    {
+        // an empty scan says nothing about the next one
+        float step = num_points > 0 ? std::clamp(std::sqrt(ratio), 1.0f / MAX_STEP, MAX_STEP) : 1.0f;
+        int voxel_size = std::clamp(static_cast<int>(std::lround(voxel_size_ * step)), min_size_, max_size_);
+
+        // the voxel size cannot change any more, so there is nothing to correct
+        if (voxel_size == voxel_size_)
+        {
+            correcting_ = false;
+        }
+        voxel_size_ = voxel_size;
+    }
+
+    return voxel_size_;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+ * @file voxel_size_controller.h
+ */
+
+namespace fastsense::preprocessing
+{
+
+/**
+ * @brief Adapts the voxel size of the reduction, so that the reduced scans stay close to a point budget
+ *
+ * The number of reduced points of a scan drops with the square of the voxel size, because a scan samples surfaces.
+ * So the voxel size is scaled by the square root of the ratio of points to budget.
+ *
+ * A hysteresis prevents the voxel size from changing with every scan: a correction starts if the point count leaves
+ * the tolerance band around the budget and only ends when it is back within half of the band.
+ */
+class VoxelSizeController
+{
+public:
+    /**
+     * @brief Construct a new Voxel Size Controller object
+     *
+     * @param target_points Point budget per reduced scan. 0 keeps the voxel size fixed at min_size
+     * @param tolerance Relative deviation from the budget that starts a correction
+     * @param min_size Smallest voxel size
+     * @param max_size Largest voxel size
+     */
+    VoxelSizeController(int target_points, float tolerance, int min_size, int max_size);
+
+    /// default destructor
+    ~VoxelSizeController() = default;
+
+    /// delete copy assignment operator
+    VoxelSizeController& operator=(const VoxelSizeController& other) = delete;
+
+    /// delete move assignment operator
+    VoxelSizeController& operator=(VoxelSizeController&&) noexcept = delete;
+
+    /// delete copy constructor
+    VoxelSizeController(const VoxelSizeController&) = delete;
+
+    /// delete move constructor
+    VoxelSizeController(VoxelSizeController&&) = delete;
+
+    /**
+     * @brief Add the result of a reduction with the current voxel size
+     *
+     * @param num_points number of points after the reduction
+     * @return int voxel size for the next scan
+     */
+    int update(int num_points);
+
+    /**
+     * @brief Voxel size for the next scan
+     */
+    int voxel_size() const
+    {
+        return voxel_size_;
+    }
+
+    /**
+     * @brief Whether the voxel size is adapted at all
+     */
+    bool active() const
+    {
+        return target_points_ > 0;
+    }
+
+    /**
+     * @brief Start again with the smallest voxel size
+     */
+    void reset();
+
+private:
+    /// Largest change of the voxel size per scan, to limit the effect of single outliers
+    static constexpr float MAX_STEP = 2.0f;
+
+    /// Point budget per reduced scan
+    int target_points_;
+    /// Relative deviation from the budget that starts a correction
+    float tolerance_;
+    /// Smallest voxel size
+    int min_size_;
+    /// Largest voxel size
+    int max_size_;
+    /// Voxel size for the next scan
+    int voxel_size_;
+    /// True while the point count is not back within the inner band
+    bool correcting_;
+};
+
+} // namespace fastsense::preprocessing
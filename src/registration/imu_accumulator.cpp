@@ -11,48 +11,57 @@ using namespace fastsense;
 
 ImuAccumulator::ImuAccumulator(msg::ImuStampedBuffer::Ptr& buffer)
     :   buffer_{buffer},
+        batch_(buffer->capacity()),
         first_imu_msg_{true},
         last_imu_timestamp_{}
 {}
 
 
-bool ImuAccumulator::before(fastsense::util::HighResTimePoint& ts_1, fastsense::util::HighResTimePoint& ts_2){
+bool ImuAccumulator::before(const fastsense::util::HighResTimePoint& ts_1, const fastsense::util::HighResTimePoint& ts_2){
     return std::chrono::duration_cast<std::chrono::milliseconds>(ts_2 - ts_1).count() >= 0;
 }
 
 Eigen::Matrix4f ImuAccumulator::acc_transform(util::HighResTimePoint pcl_timestamp) {
     
-    msg::ImuStamped imu_msg;
-    Matrix4f acc_transform = Matrix4f::Identity();
+    Eigen::Matrix3f acc_rotation = Eigen::Matrix3f::Identity();
     
-    auto imu_before_pcl = [&](msg::ImuStamped& msg){ return before(msg.timestamp_, pcl_timestamp); };
+    auto imu_before_pcl = [&](const msg::ImuStamped& msg){ return before(msg.timestamp_, pcl_timestamp); };
 
-    while(buffer_->pop_nb_if(&imu_msg, imu_before_pcl)) 
+    // the buffer may be refilled while a full batch is integrated
+    size_t count;
+    do
+    {
+        count = buffer_->drain_until(imu_before_pcl, batch_.data(), batch_.size());
+        apply_transforms(acc_rotation, batch_.data(), count);
+    }
+    while (count > 0 && count == batch_.size());
+
+    Matrix4f acc_transform = Matrix4f::Identity();
+    acc_transform.block<3, 3>(0, 0) = acc_rotation;
+    return acc_transform;
+}
+
+void ImuAccumulator::apply_transforms(Eigen::Matrix3f& acc_rotation, const msg::ImuStamped* batch, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
     {
+        const auto& imu_msg = batch[i];
         if(first_imu_msg_)
         {
             last_imu_timestamp_ = imu_msg.timestamp_;
             first_imu_msg_ = false;
             continue;
         }
+
+        const auto& ang_vel = imu_msg.data_.ang;
+        const double acc_time = std::abs(std::chrono::duration_cast<util::time::secs_double>(imu_msg.timestamp_ - last_imu_timestamp_).count());
+        Vector3f orientation = ang_vel * acc_time; //in radiants [rad, rad, rad]
         
-        apply_transform(acc_transform, imu_msg);
+        auto rotation = Eigen::AngleAxisf(orientation.x(), Vector3f::UnitX())
+                        * Eigen::AngleAxisf(orientation.y(), Vector3f::UnitY())
+                        * Eigen::AngleAxisf(orientation.z(), Vector3f::UnitZ());
+
+        acc_rotation = rotation.toRotationMatrix() * acc_rotation; //combine/update transforms
         last_imu_timestamp_ = imu_msg.timestamp_;
     }
-
-    return acc_transform;
-}
-
-void ImuAccumulator::apply_transform(Matrix4f& acc_transform, const msg::ImuStamped& imu_msg)
-{
-    const auto& ang_vel = imu_msg.data_.ang;
-    const double acc_time = std::abs(std::chrono::duration_cast<util::time::secs_double>(imu_msg.timestamp_ - last_imu_timestamp_).count());
-    Vector3f orientation = ang_vel * acc_time; //in radiants [rad, rad, rad]
-    
-    auto rotation = Eigen::AngleAxisf(orientation.x(), Vector3f::UnitX())
-                    * Eigen::AngleAxisf(orientation.y(), Vector3f::UnitY())
-                    * Eigen::AngleAxisf(orientation.z(), Vector3f::UnitZ());
-
-    Eigen::Matrix3f total = rotation.toRotationMatrix() * acc_transform.block<3, 3>(0, 0);
-    acc_transform.block<3, 3>(0, 0) = total; //combine/update transforms
 }
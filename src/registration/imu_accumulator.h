@@ -7,6 +7,7 @@
 
 #include <util/time.h>
 #include <mutex>
+#include <vector>
 #include <util/point.h>
 #include <msg/imu.h>
 
@@ -59,12 +60,13 @@ public:
     msg::ImuStampedBuffer::Ptr& buffer_;
 private:
     /**
-     * @brief applies single imu transform with duration since last imu message to accumulation matrix
+     * @brief applies the imu transforms of a batch of messages with the duration since the respective last imu message
      * 
-     * @param acc_transform current acculumation matrix
-     * @param imu_msg stamped imu message
+     * @param acc_rotation current accumulated rotation
+     * @param batch stamped imu messages in the order of their timestamps
+     * @param count number of messages in batch
      */
-    void apply_transform(Matrix4f& acc_transform, const msg::ImuStamped& imu_msg);
+    void apply_transforms(Eigen::Matrix3f& acc_rotation, const msg::ImuStamped* batch, size_t count);
     
     /**
      * @brief Calculates whether or not ts_1 happened before ts_2 (before in the OS timestamp sense)
@@ -74,7 +76,10 @@ private:
      * @return true if ts_1 happened before ts_2
      * @return false if ts_1 happened after ts_2
      */
-    bool before(util::HighResTimePoint& ts_1, util::HighResTimePoint& ts_2);
+    static bool before(const util::HighResTimePoint& ts_1, const util::HighResTimePoint& ts_2);
+
+    /// messages drained from the buffer at once, as many as the buffer holds
+    std::vector<msg::ImuStamped> batch_;
 
     /// first imu message needs to be catched to calculate diff
     bool first_imu_msg_;
@@ -291,7 +291,10 @@ extern "C"
      * @param max_iterations Maximum number of iteration for determining the transfomormation of the current scan to the map
      * @param it_weight_gradient Decay variable for the iteration influence
      * @param in_transform Initial transformation for scan point
-     * @param out_transform Result transformation for the scan into the global coordinate system
+     * @param out_transform Result transformation for the scan into the global coordinate system,
+     *                      followed by the number of iterations, the error of the last iteration,
+     *                      the number of points that hit the map, the H matrix of the last iteration
+     *                      and the error of every iteration (REG_OUT_HEADER_SIZE + max_iterations entries)
      */
     void krnl_reg(const PointHW* pointData0, // MARKER: SPLIT
                   const PointHW* pointData1,
@@ -379,6 +382,8 @@ extern "C"
         }
         float epsilon = in_transform[16];
 
+        float err = 0.0f;
+
         int i;
     registration_loop:
         for (i = 0; i < max_iterations; i++)
@@ -457,7 +462,8 @@ extern "C"
             }
 
             alpha += it_weight_gradient;
-            float err = (float)error0 / count0;
+            err = (float)error0 / count0;
+            out_transform[REG_OUT_HEADER_SIZE + i] = err;
             float d1 = err - previous_errors[2];
             float d2 = err - previous_errors[0];
 
@@ -487,5 +493,19 @@ extern "C"
             }
         }
         out_transform[16] = i;
+        out_transform[17] = err;
+        out_transform[18] = count0;
+
+        // h0..h2 still contain the sums of the last iteration
+    out_h_loop:
+        for (int row = 0; row < 6; row++)
+        {
+            for (int col = 0; col < 6; col++)
+            {
+#pragma HLS pipeline II=1
+                // MARKER: SPLIT
+                out_transform[19 + row * 6 + col] = static_cast<float>(h0[row][col] + h1[row][col] + h2[row][col]);
+            }
+        }
     }
 }
@@ -0,0 +1,89 @@
+/**
+ * @file latency_budget.cpp
+ */
+
+#include <registration/latency_budget.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace fastsense::registration;
+
+/// Weight of a new measurement in the moving average of the runtime
+constexpr float COST_WEIGHT = 0.2f;
+
+LatencyBudget::LatencyBudget(float budget, unsigned int min_iterations, size_t min_points)
+    : budget_{budget},
+      min_iterations_{std::max(min_iterations, 1u)},
+      min_points_{min_points},
+      dropped_{0},
+      cost_{0.0f}
+{
+}
+
+ScanBudget LatencyBudget::plan(float age, size_t backlog, size_t num_points, unsigned int max_iterations)
+{
+    if (!enabled() || num_points == 0 || max_iterations == 0)
+    {
+        return ScanBudget{DeadlineLevel::FULL, max_iterations, 0};
+    }
+
+    unsigned int min_iterations = std::min(min_iterations_, max_iterations);
+    size_t min_points = std::min(min_points_, num_points);
+    float remaining = budget_ - age;
+
+    if (remaining <= 0.0f)
+    {
+        // a newer scan can still meet its deadline, this one cannot
+        if (backlog > 0 && dropped_ < MAX_DROPPED)
+        {
+            dropped_++;
+            return ScanBudget{DeadlineLevel::DROP, 0, 0};
+        }
+        dropped_ = 0;
+        return ScanBudget{DeadlineLevel::FEWER_POINTS, min_iterations, min_points};
+    }
+    dropped_ = 0;
+
+    // without a measurement, the first registrations run as configured
+    if (cost_ <= 0.0f || cost_ * num_points * max_iterations <= remaining)
+    {
+        return ScanBudget{DeadlineLevel::FULL, max_iterations, 0};
+    }
+
+    auto iterations = static_cast<unsigned int>(remaining / (cost_ * num_points));
+    if (iterations >= min_iterations)
+    {
+        return ScanBudget{DeadlineLevel::FEWER_ITERATIONS, iterations, 0};
+    }
+
+    auto points = static_cast<size_t>(remaining / (cost_ * min_iterations));
+    points = std::min(std::max(points, min_points), num_points);
+    return ScanBudget{DeadlineLevel::FEWER_POINTS, min_iterations, points};
+}
+
+void LatencyBudget::update(float time, size_t num_points, int iterations)
+{
+    if (num_points == 0 || iterations <= 0 || !std::isfinite(time))
+    {
+        return;
+    }
+
+    float cost = time / (num_points * iterations);
+    cost_ = cost_ <= 0.0f ? cost : cost_ + COST_WEIGHT * (cost - cost_);
+}
+
+const char* LatencyBudget::name(DeadlineLevel level)
+{
+    switch (level)
+    {
+    case DeadlineLevel::FEWER_ITERATIONS:
+        return "deadline_iterations";
+    case DeadlineLevel::FEWER_POINTS:
+        return "deadline_points";
+    case DeadlineLevel::DROP:
+        return "deadline_drop";
+    default:
+        return "deadline_full";
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+/**
+ * @file latency_budget.h
+ */
+
+#include <cstddef>
+
+namespace fastsense::registration
+{
+
+/**
+ * @brief How far the registration of a scan is degraded to meet its deadline
+ */
+enum class DeadlineLevel
+{
+    /// Registration as configured
+    FULL,
+    /// Fewer iterations than configured
+    FEWER_ITERATIONS,
+    /// The minimum number of iterations on a reduced set of points
+    FEWER_POINTS,
+    /// The scan is neither registered nor integrated, a newer scan is waiting
+    DROP
+};
+
+/**
+ * @brief Limits of the registration of one scan, 0 means no limit
+ */
+struct ScanBudget
+{
+    /// Degradation that led to the limits
+    DeadlineLevel level = DeadlineLevel::FULL;
+    /// Maximum number of iterations
+    unsigned int iterations = 0;
+    /// Maximum number of points
+    size_t points = 0;
+};
+
+/**
+ * @brief Plans the registration of a scan, so that it is finished within a latency budget after the arrival of the scan
+ *
+ * The runtime of the solver is estimated from the previous registrations as time per point and iteration.
+ * If the registration does not fit into the remaining time, the number of iterations is reduced first.
+ * Below the minimum number of iterations, the number of points is reduced. A scan that already missed
+ * its deadline is dropped, but only if a newer scan is waiting and only a limited number of times in a row,
+ * otherwise it gets the cheapest registration.
+ */
+class LatencyBudget
+{
+public:
+    /**
+     * @brief Construct a new Latency Budget object
+     *
+     * @param budget Time (in ms) from the arrival of a scan until its registration is finished. 0 disables the budget
+     * @param min_iterations Iterations below which the number of points is reduced instead, at least 1
+     * @param min_points Minimum number of points of a reduced registration
+     */
+    LatencyBudget(float budget, unsigned int min_iterations, size_t min_points);
+
+    /// default destructor
+    ~LatencyBudget() = default;
+
+    /// delete copy assignment operator
+    LatencyBudget& operator=(const LatencyBudget& other) = delete;
+
+    /// delete move assignment operator
+    LatencyBudget& operator=(LatencyBudget&&) noexcept = delete;
+
+    /// delete copy constructor
+    LatencyBudget(const LatencyBudget&) = delete;
+
+    /// delete move constructor
+    LatencyBudget(LatencyBudget&&) = delete;
+
+    /**
+     * @brief Plan the registration of the next scan
+     *
+     * @param age Time (in ms) since the arrival of the scan
+     * @param backlog Number of newer scans waiting in the queue
+     * @param num_points Number of points of the scan
+     * @param max_iterations Configured number of iterations
+     * @return ScanBudget limits of the registration
+     */
+    ScanBudget plan(float age, size_t backlog, size_t num_points, unsigned int max_iterations);
+
+    /**
+     * @brief Add the runtime of a registration to the estimate
+     *
+     * @param time runtime of the solver in ms
+     * @param num_points number of points used by the solver
+     * @param iterations number of iterations of the solver
+     */
+    void update(float time, size_t num_points, int iterations);
+
+    /**
+     * @brief Checks if a budget is set
+     */
+    inline bool enabled() const
+    {
+        return budget_ > 0.0f;
+    }
+
+    /**
+     * @brief Estimated runtime (in ms) per point and iteration, 0 before the first registration
+     */
+    inline float cost() const
+    {
+        return cost_;
+    }
+
+    /**
+     * @brief Name of a level for the logs and the runtime statistics
+     */
+    static const char* name(DeadlineLevel level);
+
+private:
+    /// Maximum number of dropped scans in a row
+    static constexpr unsigned int MAX_DROPPED = 2;
+
+    float budget_;
+    unsigned int min_iterations_;
+    size_t min_points_;
+
+    /// Number of scans dropped in a row
+    unsigned int dropped_;
+
+    /// Moving average of the runtime per point and iteration
+    float cost_;
+};
+
+} // namespace fastsense::registration
@@ -0,0 +1,268 @@
+/**
+ * @file lm_solver.cpp
+ */
+
+#include <registration/lm_solver.h>
+#include <registration/tsdf_gradient.h>
+#include <util/thread_pool.h>
+
+#include <eigen3/Eigen/Geometry>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace fastsense;
+using namespace fastsense::registration;
+
+/// Bounds of the damping. If a step is rejected with the maximum damping, no better pose can be found
+constexpr double MIN_DAMPING = 1e-9;
+constexpr double MAX_DAMPING = 1e9;
+
+/// Factor for decreasing and increasing the damping after accepted and rejected steps
+constexpr double DAMPING_FACTOR = 10.0;
+
+/// Lever arm (in mm) to convert rotation errors of the prior into distances
+constexpr double PRIOR_LEVER = 1000.0;
+
+LMSolver::LMSolver(unsigned int max_iterations, float initial_damping, float translation_epsilon, float rotation_epsilon, float prior_weight)
+    : max_iterations_{max_iterations},
+      initial_damping_{initial_damping},
+      translation_epsilon_{translation_epsilon},
+      rotation_epsilon_{rotation_epsilon},
+      prior_weight_{prior_weight}
+{
+}
+
+void LMSolver::build_system(const map::LocalMap& map,
+                            const buffer::InputBuffer<PointHW>& cloud,
+                            int num_points,
+                            const Matrix4f& pose,
+                            System& system)
+{
+    system.h.setZero();
+    system.g.setZero();
+    system.squared_error = 0.0;
+    system.error = 0.0;
+    system.count = 0;
+
+    const Eigen::Matrix3f rotation = pose.block<3, 3>(0, 0);
+    const Vector3f translation = pose.block<3, 1>(0, 3);
+    const Vector3i center = translation.cast<int>();
+
+    // every part of the cloud is summed up separately, then the parts are added in a fixed order
+    auto& pool = util::ThreadPool::get_instance();
+    size_t num_parts = std::min<size_t>(pool.concurrency() * 4, std::max(num_points, 1));
+    size_t part_size = (static_cast<size_t>(std::max(num_points, 0)) + num_parts - 1) / num_parts;
+    std::vector<System> parts(num_parts);
+
+    pool.parallel_for(0, num_parts, [&](size_t part)
+    {
+        System& local = parts[part];
+        local.h.setZero();
+        local.g.setZero();
+        local.squared_error = 0.0;
+        local.error = 0.0;
+        local.count = 0;
+
+        int end = std::min<int>(num_points, static_cast<int>((part + 1) * part_size));
+        for (int i = static_cast<int>(part * part_size); i < end; i++)
+        {
+            const auto& point = cloud[i];
+            Vector3i transformed = (rotation * Vector3f(point.x, point.y, point.z) + translation).cast<int>();
+
+            int value;
+            Vector3i gradient;
+            if (!tsdf_gradient(map, transformed, value, gradient))
+            {
+                continue;
+            }
+
+            // the kernel uses the gradient per cell, but the update has to be in mm
+            Eigen::Vector3d lever = (transformed - center).cast<double>();
+            Eigen::Vector3d grad = gradient.cast<double>() / MAP_RESOLUTION;
+
+            Vector6d jacobi;
+            jacobi.head<3>() = lever.cross(grad);
+            jacobi.tail<3>() = grad;
+
+            local.h += jacobi * jacobi.transpose();
+            local.g += jacobi * value;
+            local.squared_error += static_cast<double>(value) * value;
+            local.error += std::abs(value);
+            local.count++;
+        }
+    });
+
+    for (const auto& local : parts)
+    {
+        system.h += local.h;
+        system.g += local.g;
+        system.squared_error += local.squared_error;
+        system.error += local.error;
+        system.count += local.count;
+    }
+}
+
+Matrix4f LMSolver::xi_to_transform(const Vector6d& xi, const Vector3f& center)
+{
+    // Formula 3.9 on Page 40 of "Truncated Signed Distance Fields Applied To Robotics"
+    Eigen::Vector3f angular = xi.head<3>().cast<float>();
+    float theta = angular.norm();
+
+    Matrix4f transform = Matrix4f::Identity();
+    if (theta > 0.0f)
+    {
+        transform.block<3, 3>(0, 0) = Eigen::AngleAxisf(theta, angular / theta).toRotationMatrix();
+    }
+
+    // rotate around the center and apply the new translation
+    transform.block<3, 1>(0, 3) = center - transform.block<3, 3>(0, 0) * center + xi.tail<3>().cast<float>();
+
+    return transform;
+}
+
+double LMSolver::add_prior(const Matrix4f& pose, const Matrix4f& prior, System& system) const
+{
+    // difference to the prior in the same parametrization as the update: rotation vector and translation
+    Eigen::AngleAxisd rotation((pose.block<3, 3>(0, 0) * prior.block<3, 3>(0, 0).transpose()).cast<double>());
+    Vector6d difference;
+    difference.head<3>() = rotation.axis() * rotation.angle();
+    difference.tail<3>() = (pose.block<3, 1>(0, 3) - prior.block<3, 1>(0, 3)).cast<double>();
+
+    // a deviation of 1 mm costs as much as 1 mm of TSDF error on prior_weight of the points
+    Vector6d weight;
+    weight.head<3>().setConstant(prior_weight_ * system.count * PRIOR_LEVER * PRIOR_LEVER);
+    weight.tail<3>().setConstant(prior_weight_ * system.count);
+
+    system.h.diagonal() += weight;
+    system.g += weight.cwiseProduct(difference);
+
+    return difference.dot(weight.cwiseProduct(difference));
+}
+
+int LMSolver::solve(const map::LocalMap& map,
+                    const buffer::InputBuffer<PointHW>& cloud,
+                    int num_points,
+                    Matrix4f& pose,
+                    float& error,
+                    unsigned int max_iterations,
+                    msg::RegistrationStats* stats)
+{
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    clock::duration point_time{0};
+
+    System current, trial;
+    build_system(map, cloud, num_points, pose, current);
+    point_time += clock::now() - start;
+
+    if (max_iterations == 0 || max_iterations > max_iterations_)
+    {
+        max_iterations = max_iterations_;
+    }
+
+    if (stats)
+    {
+        stats->max_iterations_ = max_iterations;
+        stats->num_points_ = num_points;
+        stats->errors_.clear();
+    }
+
+    if (current.count == 0)
+    {
+        error = 0.0f;
+        if (stats)
+        {
+            stats->iterations_ = 0;
+            stats->cap_hit_ = false;
+            stats->num_hits_ = 0;
+            stats->condition_ = std::numeric_limits<float>::infinity();
+            stats->point_time_ = std::chrono::duration<float, std::milli>(point_time).count();
+            stats->solve_time_ = 0.0f;
+        }
+        return 0;
+    }
+
+    const Matrix4f prior = pose;
+    bool use_prior = prior_weight_ > 0.0;
+
+    // the accepted cost includes the prior, the reported error only the points
+    double current_cost = current.cost();
+    if (use_prior)
+    {
+        current_cost += add_prior(pose, prior, current) / current.count;
+    }
+
+    double damping = initial_damping_;
+    unsigned int iteration = 0;
+    bool stopped = false;
+
+    while (iteration < max_iterations)
+    {
+        iteration++;
+
+        // Marquardt: scale the damping with the diagonal, so that every degree of freedom is damped relative to its information
+        Matrix6d h = current.h;
+        h.diagonal() *= 1.0 + damping;
+        Vector6d xi = h.ldlt().solve(-current.g);
+
+        Matrix4f trial_pose = xi_to_transform(xi, pose.block<3, 1>(0, 3)) * pose;
+        auto point_start = clock::now();
+        build_system(map, cloud, num_points, trial_pose, trial);
+        point_time += clock::now() - point_start;
+
+        double trial_cost = trial.cost();
+        if (use_prior && trial.count > 0)
+        {
+            trial_cost += add_prior(trial_pose, prior, trial) / trial.count;
+        }
+
+        // only an accepted step can converge: a rejected one is small because of the damping, not because the pose is final
+        bool converged = false;
+
+        if (trial.count > 0 && trial_cost < current_cost)
+        {
+            // accept the step and widen the trust region
+            converged = xi.tail<3>().norm() < translation_epsilon_ && xi.head<3>().norm() < rotation_epsilon_;
+            pose = trial_pose;
+            std::swap(current, trial);
+            current_cost = trial_cost;
+            damping = std::max(damping / DAMPING_FACTOR, MIN_DAMPING);
+        }
+        else
+        {
+            // reject the step and narrow the trust region
+            damping = std::max(damping, MIN_DAMPING) * DAMPING_FACTOR;
+            if (damping > MAX_DAMPING)
+            {
+                stopped = true;
+            }
+        }
+
+        if (stats)
+        {
+            stats->errors_.push_back(static_cast<float>(current.error / current.count));
+        }
+
+        if (stopped || converged || !xi.allFinite())
+        {
+            stopped = true;
+            break;
+        }
+    }
+
+    error = static_cast<float>(current.error / current.count);
+
+    if (stats)
+    {
+        stats->iterations_ = iteration;
+        stats->cap_hit_ = !stopped;
+        stats->num_hits_ = current.count;
+        stats->set_condition(current.h);
+        stats->point_time_ = std::chrono::duration<float, std::milli>(point_time).count();
+        stats->solve_time_ = std::chrono::duration<float, std::milli>(clock::now() - start - point_time).count();
+    }
+
+    return iteration;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+/**
+ * @file lm_solver.h
+ */
+
+#include <map/local_map.h>
+#include <util/point_hw.h>
+#include <msg/registration_stats.h>
+
+namespace fastsense::registration
+{
+
+/**
+ * @brief Levenberg-Marquardt registration of a scan against the TSDF map on the CPU
+ *
+ * The H/g system is built the same way as in the registration kernel (TSDF value as residual,
+ * Jacobian [p x gradient, gradient]). Instead of the fixed ramp on the diagonal, the damping is adapted
+ * like a trust region: a step is only accepted if it reduces the squared TSDF error. Accepted steps
+ * shrink the damping, rejected steps increase it. The iteration stops as soon as an accepted update becomes small.
+ *
+ * Optionally, the initial pose (e.g. the prediction of the motion model) is added as a prior to the system,
+ * which keeps the solution close to it in directions the map does not constrain well.
+ */
+class LMSolver
+{
+public:
+    using Matrix6d = Eigen::Matrix<double, 6, 6>;
+    using Vector6d = Eigen::Matrix<double, 6, 1>;
+
+    /**
+     * @brief Linear system of one registration step
+     */
+    struct System
+    {
+        /// sum of J * J^T
+        Matrix6d h;
+        /// sum of J * residual
+        Vector6d g;
+        /// sum of the squared residuals
+        double squared_error;
+        /// sum of the absolute residuals, same as the error in the kernel
+        double error;
+        /// number of points that hit an observed cell
+        long count;
+
+        /// mean squared residual, which is minimized
+        inline double cost() const
+        {
+            return count > 0 ? squared_error / count : std::numeric_limits<double>::infinity();
+        }
+    };
+
+    /**
+     * @brief Construct a new LMSolver object
+     *
+     * @param max_iterations Maximum number of solved systems per scan
+     * @param initial_damping Damping of the first step relative to the diagonal of H
+     * @param translation_epsilon Stop if the translation of an update is smaller (in mm)
+     * @param rotation_epsilon Stop if the rotation of an update is smaller (in rad)
+     * @param prior_weight Weight of the initial pose as prior per point that hits the map. 0 disables the prior
+     */
+    LMSolver(unsigned int max_iterations, float initial_damping, float translation_epsilon, float rotation_epsilon, float prior_weight = 0.0f);
+
+    /// default destructor
+    ~LMSolver() = default;
+
+    /// delete copy assignment operator
+    LMSolver& operator=(const LMSolver& other) = delete;
+
+    /// delete move assignment operator
+    LMSolver& operator=(LMSolver&&) noexcept = delete;
+
+    /// delete copy constructor
+    LMSolver(const LMSolver&) = delete;
+
+    /// delete move constructor
+    LMSolver(LMSolver&&) = delete;
+
+    /**
+     * @brief Register the cloud against the map
+     *
+     * @param map Local map
+     * @param cloud Untransformed scan points
+     * @param num_points Number of valid points in cloud
+     * @param pose Initial estimate of the pose and center of the prior, overwritten with the result
+     * @param error Mean absolute TSDF value of the points at the resulting pose
+     * @param max_iterations Cap on the iterations of this scan, 0 uses the configured maximum
+     * @param stats Optional convergence record of this registration
+     * @return int Number of iterations
+     */
+    int solve(const map::LocalMap& map,
+              const buffer::InputBuffer<PointHW>& cloud,
+              int num_points,
+              Matrix4f& pose,
+              float& error,
+              unsigned int max_iterations = 0,
+              msg::RegistrationStats* stats = nullptr);
+
+    /**
+     * @brief Build the H/g system of the cloud at the given pose
+     *
+     * @param map Local map
+     * @param cloud Untransformed scan points
+     * @param num_points Number of valid points in cloud
+     * @param pose Pose the points are transformed with
+     * @param system Resulting system
+     */
+    static void build_system(const map::LocalMap& map,
+                             const buffer::InputBuffer<PointHW>& cloud,
+                             int num_points,
+                             const Matrix4f& pose,
+                             System& system);
+
+    /**
+     * @brief Convert the motion xi (angular and linear velocity) into a transformation matrix,
+     *        that rotates around the given center
+     *
+     * @param xi Motion with the rotation in the first and the translation in the last three entries
+     * @param center Center of the rotation (the scanner position)
+     */
+    static Matrix4f xi_to_transform(const Vector6d& xi, const Vector3f& center);
+
+private:
+    /**
+     * @brief Add the prior to the system
+     *
+     * @param pose Current pose
+     * @param prior Center of the prior
+     * @param system System of the points, the prior is added to h and g
+     * @return double Squared error of the prior
+     */
+    double add_prior(const Matrix4f& pose, const Matrix4f& prior, System& system) const;
+
+    /// Maximum number of solved systems per scan
+    unsigned int max_iterations_;
+    /// Damping of the first step relative to the diagonal of H
+    double initial_damping_;
+    /// Translation of an update (in mm) below which the registration stops
+    double translation_epsilon_;
+    /// Rotation of an update (in rad) below which the registration stops
+    double rotation_epsilon_;
+    /// Weight of the prior per point
+    double prior_weight_;
+};
+
+} // namespace fastsense::registration
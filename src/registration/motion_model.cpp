@@ -0,0 +1,79 @@
+/**
+ * @file motion_model.cpp
+ */
+
+#include <registration/motion_model.h>
+
+#include <eigen3/Eigen/Geometry>
+
+using namespace fastsense;
+using namespace fastsense::registration;
+
+MotionModel::MotionModel(size_t history, float imu_weight)
+    : history_{history},
+      imu_weight_{std::min(std::max(imu_weight, 0.0f), 1.0f)},
+      poses_{}
+{
+}
+
+Matrix4f MotionModel::predict(const Matrix4f& last_pose, const Matrix4f& imu_estimate, const util::HighResTimePoint& timestamp) const
+{
+    Matrix4f prediction = last_pose;
+    Eigen::Matrix3f imu_rotation = imu_estimate.block<3, 3>(0, 0);
+
+    if (!ready())
+    {
+        // apply rotation and possible transform separate because the rotation happens around the scanner, not the origin
+        prediction.block<3, 3>(0, 0) = imu_rotation * last_pose.block<3, 3>(0, 0);
+        prediction.block<3, 1>(0, 3) += imu_estimate.block<3, 1>(0, 3);
+        return prediction;
+    }
+
+    const auto& oldest = poses_.front();
+    const auto& newest = poses_.back();
+
+    double history_time = std::chrono::duration_cast<util::time::secs_double>(newest.first - oldest.first).count();
+    double prediction_time = std::chrono::duration_cast<util::time::secs_double>(timestamp - newest.first).count();
+    if (history_time <= 0.0 || prediction_time < 0.0)
+    {
+        prediction.block<3, 3>(0, 0) = imu_rotation * last_pose.block<3, 3>(0, 0);
+        prediction.block<3, 1>(0, 3) += imu_estimate.block<3, 1>(0, 3);
+        return prediction;
+    }
+    float scale = prediction_time / history_time;
+
+    // translation with constant velocity
+    Vector3f translation = newest.second.block<3, 1>(0, 3) - oldest.second.block<3, 1>(0, 3);
+    prediction.block<3, 1>(0, 3) = last_pose.block<3, 1>(0, 3) + translation * scale + imu_estimate.block<3, 1>(0, 3);
+
+    // rotation with constant angular velocity, blended with the IMU
+    Eigen::AngleAxisf rotation(newest.second.block<3, 3>(0, 0) * oldest.second.block<3, 3>(0, 0).transpose());
+    rotation.angle() *= scale;
+
+    Quaternionf model_delta(rotation);
+    Quaternionf imu_delta(imu_rotation);
+    Quaternionf delta = model_delta.slerp(imu_weight_, imu_delta);
+
+    prediction.block<3, 3>(0, 0) = delta.toRotationMatrix() * last_pose.block<3, 3>(0, 0);
+
+    return prediction;
+}
+
+void MotionModel::update(const Matrix4f& pose, const util::HighResTimePoint& timestamp)
+{
+    if (history_ < 2 || !pose.allFinite())
+    {
+        return;
+    }
+
+    poses_.emplace_back(timestamp, pose);
+    while (poses_.size() > history_)
+    {
+        poses_.pop_front();
+    }
+}
+
+void MotionModel::reset()
+{
+    poses_.clear();
+}
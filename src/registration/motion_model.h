@@ -0,0 +1,91 @@
+#pragma once
+
+/**
+ * @file motion_model.h
+ */
+
+#include <deque>
+
+#include <util/point.h>
+#include <util/time.h>
+
+namespace fastsense::registration
+{
+
+/**
+ * @brief Constant velocity model, that predicts the pose of the next scan from the recent registration results
+ *
+ * The translation is extrapolated from the last poses. The extrapolated rotation is blended with the rotation measured
+ * by the IMU, so that the IMU keeps the upper hand, but the prediction still works without IMU data.
+ */
+class MotionModel
+{
+public:
+    /**
+     * @brief Construct a new Motion Model object
+     *
+     * @param history Number of poses the velocity is estimated from. Values below 2 disable the model
+     * @param imu_weight Weight of the IMU rotation in [0, 1] when blended with the extrapolated rotation
+     */
+    MotionModel(size_t history, float imu_weight);
+
+    /// default destructor
+    ~MotionModel() = default;
+
+    /// delete copy assignment operator
+    MotionModel& operator=(const MotionModel& other) = delete;
+
+    /// delete move assignment operator
+    MotionModel& operator=(MotionModel&&) noexcept = delete;
+
+    /// delete copy constructor
+    MotionModel(const MotionModel&) = delete;
+
+    /// delete move constructor
+    MotionModel(MotionModel&&) = delete;
+
+    /**
+     * @brief Predict the pose at the given time
+     *
+     * Without enough history (or if the model is disabled) only the IMU rotation is applied to the last pose.
+     *
+     * @param last_pose Result of the last registration
+     * @param imu_estimate Rotation measured by the IMU since the last scan
+     * @param timestamp Time of the new scan
+     * @return Matrix4f the predicted pose
+     */
+    Matrix4f predict(const Matrix4f& last_pose, const Matrix4f& imu_estimate, const util::HighResTimePoint& timestamp) const;
+
+    /**
+     * @brief Add a registered pose to the history
+     *
+     * @param pose Result of the registration
+     * @param timestamp Time of the registered scan
+     */
+    void update(const Matrix4f& pose, const util::HighResTimePoint& timestamp);
+
+    /**
+     * @brief Forget the history, e.g. after the pose was reset
+     */
+    void reset();
+
+    /**
+     * @brief Checks if the model has enough poses for a prediction
+     */
+    inline bool ready() const
+    {
+        return history_ >= 2 && poses_.size() >= 2;
+    }
+
+private:
+    /// Number of poses the velocity is estimated from
+    size_t history_;
+
+    /// Weight of the IMU rotation
+    float imu_weight_;
+
+    /// Last registered poses with their timestamps, oldest first
+    std::deque<std::pair<util::HighResTimePoint, Matrix4f>> poses_;
+};
+
+} // namespace fastsense::registration
@@ -0,0 +1,127 @@
+/**
+ * @file point_selection.cpp
+ */
+
+#include <registration/point_selection.h>
+#include <registration/tsdf_gradient.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace fastsense;
+using namespace fastsense::registration;
+
+PointSelection::PointSelection(size_t budget)
+    : budget_{budget},
+      bins_{},
+      fill_{}
+{
+}
+
+int PointSelection::select(const map::LocalMap& map,
+                           const buffer::InputBuffer<PointHW>& cloud,
+                           int num_points,
+                           const Matrix4f& pose,
+                           buffer::InputBuffer<PointHW>& out,
+                           size_t limit)
+{
+    const size_t budget = limit > 0 ? limit : budget_;
+
+    for (auto& bin : bins_)
+    {
+        bin.clear();
+    }
+    fill_.clear();
+
+    const Eigen::Matrix3f rotation = pose.block<3, 3>(0, 0);
+    const Vector3f center = pose.block<3, 1>(0, 3);
+
+    for (int i = 0; i < num_points; i++)
+    {
+        const auto& point = cloud[i];
+        Vector3f transformed = rotation * Vector3f(point.x, point.y, point.z) + center;
+
+        int value;
+        Vector3i int_gradient;
+        if (!tsdf_gradient(map, transformed.cast<int>(), value, int_gradient))
+        {
+            continue;
+        }
+        Vector3f gradient = int_gradient.cast<float>();
+
+        Vector3f lever = transformed - center;
+        float lever_norm = lever.norm();
+        if (gradient.isZero() || lever_norm == 0.0f)
+        {
+            fill_.push_back(i);
+            continue;
+        }
+
+        Vector3f rot_part = lever.cross(gradient);
+
+        // The rotational part grows with the lever arm. Divide it by the lever arm to find the dominating degree of freedom,
+        // but keep the unscaled value as score, because a longer lever arm constrains the rotation better
+        int bin = 0;
+        float best = 0.0f;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float rot = std::abs(rot_part[axis]) / lever_norm;
+            if (rot > best)
+            {
+                best = rot;
+                bin = axis;
+            }
+            float trans = std::abs(gradient[axis]);
+            if (trans > best)
+            {
+                best = trans;
+                bin = axis + 3;
+            }
+        }
+
+        float score = bin < 3 ? std::abs(rot_part[bin]) : std::abs(gradient[bin - 3]);
+        bins_[bin].push_back(Candidate{i, score});
+    }
+
+    // only the best points of every bin can be selected
+    for (auto& bin : bins_)
+    {
+        size_t keep = std::min(bin.size(), budget);
+        std::partial_sort(bin.begin(), bin.begin() + keep, bin.end(), [](const Candidate & a, const Candidate & b)
+        {
+            return a.score > b.score;
+        });
+        bin.resize(keep);
+    }
+
+    size_t count = 0;
+    std::array<size_t, NUM_BINS> next{};
+    bool remaining = true;
+
+    // round robin, so that a bin with few points is not starved by the large ones
+    while (count < budget && remaining)
+    {
+        remaining = false;
+        for (int bin = 0; bin < NUM_BINS && count < budget; bin++)
+        {
+            if (next[bin] < bins_[bin].size())
+            {
+                out[count++] = cloud[bins_[bin][next[bin]++].index];
+                remaining = true;
+            }
+        }
+    }
+
+    if (count < budget && !fill_.empty())
+    {
+        // spread the remaining budget evenly over the uninformative points
+        size_t remaining_budget = std::min(budget - count, fill_.size());
+        float step = static_cast<float>(fill_.size()) / remaining_budget;
+        for (size_t i = 0; i < remaining_budget; i++)
+        {
+            out[count++] = cloud[fill_[static_cast<size_t>(i * step)]];
+        }
+    }
+
+    return static_cast<int>(count);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+/**
+ * @file point_selection.h
+ */
+
+#include <array>
+#include <vector>
+
+#include <map/local_map.h>
+#include <util/point_hw.h>
+
+namespace fastsense::registration
+{
+
+/**
+ * @brief Chooses a bounded subset of scan points that carries the most information for the registration.
+ *
+ * Every point that hits an observed TSDF cell contributes the Jacobian j = [p x g, g] to H, where g is the TSDF gradient
+ * and p the lever arm to the scanner. Points in flat, well constrained directions only add to entries of H that are
+ * already large, so they are cheap to drop.
+ *
+ * The points are binned by the degree of freedom (three rotations and three translations) they constrain the most.
+ * To make the rotational and translational parts comparable, the rotational part is divided by the lever arm.
+ * Inside a bin, points with a stronger constraint are preferred and the budget is distributed round robin over all bins,
+ * so weakly constrained directions keep as many points as possible.
+ */
+class PointSelection
+{
+public:
+    /**
+     * @brief Construct a new Point Selection object
+     *
+     * @param budget Maximum number of selected points, 0 disables the selection
+     */
+    explicit PointSelection(size_t budget);
+
+    /// default destructor
+    ~PointSelection() = default;
+
+    /// delete copy assignment operator
+    PointSelection& operator=(const PointSelection& other) = delete;
+
+    /// delete move assignment operator
+    PointSelection& operator=(PointSelection&&) noexcept = delete;
+
+    /// delete copy constructor
+    PointSelection(const PointSelection&) = delete;
+
+    /// delete move constructor
+    PointSelection(PointSelection&&) = delete;
+
+    /**
+     * @brief Select at most budget() (or limit) points from the given cloud
+     *
+     * If the map does not hold enough information (e.g. directly after the start), the remaining budget is
+     * filled with the uninformative points, so that the registration error stays comparable.
+     *
+     * @param map Local map the cloud is registered against
+     * @param cloud Untransformed scan points
+     * @param num_points Number of valid points in cloud
+     * @param pose Current estimate of the scanner pose
+     * @param out Buffer for the selected (untransformed) points. Needs a size of at least the number of selected points
+     * @param limit Number of points that is selected instead of budget(), 0 uses budget()
+     * @return int Number of points written into out
+     */
+    int select(const map::LocalMap& map,
+               const buffer::InputBuffer<PointHW>& cloud,
+               int num_points,
+               const Matrix4f& pose,
+               buffer::InputBuffer<PointHW>& out,
+               size_t limit = 0);
+
+    /**
+     * @brief Maximum number of selected points
+     */
+    inline size_t budget() const
+    {
+        return budget_;
+    }
+
+    /**
+     * @brief Checks if a cloud with the given number of points has to be reduced
+     */
+    inline bool active(int num_points) const
+    {
+        return budget_ > 0 && static_cast<size_t>(num_points) > budget_;
+    }
+
+private:
+    /// Number of bins: one per degree of freedom
+    static constexpr int NUM_BINS = 6;
+
+    /// Index of a scan point and how strongly it constrains the degree of freedom of its bin
+    struct Candidate
+    {
+        int index;
+        float score;
+    };
+
+    /// Maximum number of selected points
+    size_t budget_;
+
+    /// Informative points, binned by the degree of freedom they constrain the most
+    std::array<std::vector<Candidate>, NUM_BINS> bins_;
+
+    /// Points that hit an observed cell, but have no usable gradient
+    std::vector<int> fill_;
+};
+
+} // namespace fastsense::registration
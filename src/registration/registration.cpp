@@ -7,25 +7,54 @@
 #include <util/point.h>
 #include <registration/registration.h>
 #include <util/runtime_evaluator.h>
+#include <util/logging/logger.h>
+#include <util/thread_pool.h>
+
+#include <chrono>
 
 using namespace fastsense;
 using namespace fastsense::registration;
 using namespace fastsense::util;
+using fastsense::util::logging::Logger;
+
+/// Minimum number of points per chunk of the transformation, smaller chunks cost more than they save
+constexpr size_t TRANSFORM_GRAIN = 1024;
 
-Registration::Registration(fastsense::CommandQueuePtr q, msg::ImuStampedBuffer::Ptr& buffer, unsigned int max_iterations, float it_weight_gradient, float epsilon)
+Registration::Registration(fastsense::CommandQueuePtr q,
+                           msg::ImuStampedBuffer::Ptr& buffer,
+                           const RegistrationOptions& options)
     :
-    max_iterations_(max_iterations),
-    it_weight_gradient_(it_weight_gradient),
-    epsilon_(epsilon),
+    max_iterations_(options.max_iterations),
+    it_weight_gradient_(options.it_weight_gradient),
+    epsilon_(options.epsilon),
     imu_accumulator_(buffer),
-    krnl{q}
+    point_selection_(options.point_budget),
+    q_{q},
+    selected_points_{},
+    krnl{q},
+    solver_(options.solver),
+    lm_solver_(options.max_iterations, options.lm_damping, options.lm_translation_epsilon, options.lm_rotation_epsilon, options.prior_weight),
+    motion_model_(options.motion_history, options.motion_imu_weight),
+    scan_policy_(options.skip_translation, options.skip_rotation, options.max_skipped, options.refine_iterations),
+    latency_budget_(options.latency_budget, options.latency_min_iterations, options.latency_min_points),
+    last_iterations_(0),
+    stats_buffer_{},
+    iteration_filter_(100, true),
+    time_filter_(100, true),
+    error_filter_(100, true),
+    registration_count_(0),
+    scan_age_("registration"),
+    overwritten_(0)
 {
+    if (options.point_budget > 0)
+    {
+        selected_points_.reset(new fastsense::buffer::InputBuffer<PointHW>(q, options.point_budget));
+    }
 }
 
 void Registration::transform_point_cloud(fastsense::ScanPoints_t& in_cloud, const Matrix4f& mat)
 {
-    #pragma omp parallel for schedule(static)
-    for (auto index = 0u; index < in_cloud.size(); ++index)
+    ThreadPool::get_instance().parallel_for(0, in_cloud.size(), [&](size_t index)
     {
         auto& point = in_cloud[index];
         Vector3f tmp = (mat.block<3, 3>(0, 0) * point.cast<float>() + mat.block<3, 1>(0, 3));
@@ -34,13 +63,12 @@ void Registration::transform_point_cloud(fastsense::ScanPoints_t& in_cloud, cons
         tmp[2] < 0 ? tmp[2] -= 0.5 : tmp[2] += 0.5;
 
         point = tmp.cast<int>();
-    }
+    }, TRANSFORM_GRAIN);
 }
 
 void Registration::transform_point_cloud(fastsense::buffer::InputBuffer<PointHW>& in_cloud, const Matrix4f& mat)
 {
-    #pragma omp parallel for schedule(static)
-    for (auto index = 0u; index < in_cloud.size(); ++index)
+    ThreadPool::get_instance().parallel_for(0, in_cloud.size(), [&](size_t index)
     {
         auto& point = in_cloud[index];
         Vector3f eigen_point(point.x, point.y, point.z);
@@ -52,24 +80,167 @@ void Registration::transform_point_cloud(fastsense::buffer::InputBuffer<PointHW>
         point.x = static_cast<int>(tmp.x());
         point.y = static_cast<int>(tmp.y());
         point.z = static_cast<int>(tmp.z());
-    }
+    }, TRANSFORM_GRAIN);
 }
 
-void Registration::register_cloud(fastsense::map::LocalMap& localmap,
+bool Registration::register_cloud(fastsense::map::LocalMap& localmap,
                                   fastsense::buffer::InputBuffer<PointHW>& cloud,
                                   int num_points,
                                   const util::HighResTimePoint& cloud_timestamp,
-                                  Matrix4f& pose)
+                                  Matrix4f& pose,
+                                  size_t backlog,
+                                  const util::SteadyTimePoint& arrival)
 {
+    auto& eval = RuntimeEvaluator::get_instance();
+
+    // decided first, a dropped scan must not change the IMU accumulation or the motion history
+    ScanBudget budget = latency_budget_.plan(ScanAge::since(arrival), backlog, num_points, max_iterations_);
+    eval.start(LatencyBudget::name(budget.level));
+    if (budget.level == DeadlineLevel::DROP)
+    {
+        eval.stop(LatencyBudget::name(budget.level));
+        return false;
+    }
+    scan_age_.add(arrival);
+
     Matrix4f imu_estimate = imu_accumulator_.acc_transform(cloud_timestamp);
+    Matrix4f last_pose = pose;
+    pose = motion_model_.predict(pose, imu_estimate, cloud_timestamp);
+
+    ScanDecision decision = scan_policy_.decide(imu_estimate, backlog);
+    eval.start(ScanPolicy::name(decision));
+
+    if (decision == ScanDecision::SKIP)
+    {
+        // the predicted pose is used as it is, but is not added to the motion history of the policy
+        last_iterations_ = 0;
+        motion_model_.update(pose, cloud_timestamp);
+        transform_point_cloud(cloud, pose);
+        eval.stop(ScanPolicy::name(decision));
+        eval.stop(LatencyBudget::name(budget.level));
+        return true;
+    }
+
+    unsigned int max_iterations = decision == ScanDecision::REFINE ? std::min<size_t>(scan_policy_.refine_iterations(), max_iterations_) : max_iterations_;
+    if (budget.iterations > 0)
+    {
+        max_iterations = std::min(max_iterations, budget.iterations);
+    }
+
+    // the configured point budget, further reduced to meet the deadline
+    size_t point_limit = point_selection_.budget();
+    if (budget.points > 0 && (point_limit == 0 || budget.points < point_limit))
+    {
+        point_limit = budget.points;
+    }
+
+    int num_selected = 0;
+    if (point_limit > 0 && static_cast<size_t>(num_points) > point_limit)
+    {
+        if (!selected_points_ || selected_points_->size() < point_limit)
+        {
+            // only happens without a configured point budget, leave room for larger reductions
+            selected_points_.reset(new fastsense::buffer::InputBuffer<PointHW>(q_, point_limit * 3 / 2));
+        }
+        eval.start("select");
+        num_selected = point_selection_.select(localmap, cloud, num_points, pose, *selected_points_, point_limit);
+        eval.stop("select");
+    }
 
-    // apply rotation and possible transform separate because the rotation happens around the scanner, not the origin
-    Eigen::Matrix3f rotation = imu_estimate.block<3, 3>(0, 0) * pose.block<3, 3>(0, 0);
-    pose.block<3, 3>(0, 0) = rotation;
-    pose.block<3, 1>(0, 3) += imu_estimate.block<3, 1>(0, 3); 
+    // without any information in the map, fall back to the whole cloud
+    auto& points = num_selected > 0 ? *selected_points_ : cloud;
+    int points_used = num_selected > 0 ? num_selected : num_points;
+
+    int iterations;
+    float error;
+    auto start = std::chrono::steady_clock::now();
+
+    // the convergence record is only filled if someone listens
+    msg::RegistrationStatsStamped record{msg::RegistrationStats{}, cloud_timestamp};
+    msg::RegistrationStats* stats = stats_buffer_ ? &record.data_ : nullptr;
+
+    if (solver_ == SolverMode::LM)
+    {
+        iterations = lm_solver_.solve(localmap, points, points_used, pose, error, max_iterations, stats);
+    }
+    else
+    {
+        iterations = krnl.synchronized_run(localmap, points, points_used, max_iterations, it_weight_gradient_, epsilon_, pose, error, stats);
+    }
 
-    krnl.synchronized_run(localmap, cloud, num_points, max_iterations_, it_weight_gradient_, epsilon_, pose);
+    float time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    latency_budget_.update(time, points_used, iterations);
+    update_statistics(iterations, time, error);
+    if (stats_buffer_)
+    {
+        stats_buffer_->push_nb(record, true);
+    }
+    last_iterations_ = iterations;
+    motion_model_.update(pose, cloud_timestamp);
+    if (pose.allFinite())
+    {
+        scan_policy_.update(last_pose, pose);
+    }
 
     // apply final transformation
     transform_point_cloud(cloud, pose);
-}
\ No newline at end of file
+    eval.stop(ScanPolicy::name(decision));
+    eval.stop(LatencyBudget::name(budget.level));
+    return true;
+}
+
+void Registration::update_statistics(int iterations, float time, float error)
+{
+    iteration_filter_.update(iterations);
+    time_filter_.update(time);
+    error_filter_.update(error);
+    registration_count_++;
+
+    if (registration_count_ > 100 && registration_count_ % 20 == 0)
+    {
+        Logger::info("Registration (", solver_ == SolverMode::LM ? "lm" : "kernel", "): ",
+                     "Average Iterations: ", (int)iteration_filter_.get_mean(), " / ", max_iterations_,
+                     ", Average Time: ", time_filter_.get_mean(), " ms",
+                     ", Average Error: ", error_filter_.get_mean(),
+                     ", ", scan_age_.to_string(),
+                     ", Overwritten Scans: ", overwritten_);
+        scan_age_.reset();
+        overwritten_ = 0;
+    }
+}
+
+void Registration::set_stats_buffer(const msg::RegistrationStatsStampedBuffer::Ptr& stats_buffer)
+{
+    stats_buffer_ = stats_buffer;
+}
+
+void Registration::reset_motion()
+{
+    motion_model_.reset();
+}
+
+void Registration::count_overwritten(size_t scans)
+{
+    auto& eval = RuntimeEvaluator::get_instance();
+    overwritten_ += scans;
+
+    // a measurement without work per scan, like a dropped scan, so the count appears in the statistics
+    for (size_t i = 0; i < scans; i++)
+    {
+        eval.start("deadline_overwrite");
+        eval.stop("deadline_overwrite");
+    }
+}
+
+SolverMode Registration::parse_solver_mode(const std::string& name)
+{
+    if (name.empty() || name == "kernel")
+    {
+        return SolverMode::KERNEL;
+    }
+    if (name == "lm")
+    {
+        return SolverMode::LM;
+    }
+    throw std::runtime_error("Unknown solver '" + name + "' in config.json/registration/solver");
+}
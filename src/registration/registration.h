@@ -13,12 +13,76 @@
 #include <algorithm>
 
 #include "imu_accumulator.h"
+#include "point_selection.h"
+#include "lm_solver.h"
+#include "motion_model.h"
+#include "scan_policy.h"
+#include "latency_budget.h"
 #include <msg/imu.h>
+#include <msg/registration_stats.h>
 #include <hw/kernels/reg_kernel.h>
+#include <util/filter.h>
+#include <util/scan_age.h>
 
 namespace fastsense::registration
 {
 
+/**
+ * @brief Algorithm used to determine the pose
+ */
+enum class SolverMode
+{
+    /// Registration kernel on the FPGA with a fixed damping ramp
+    KERNEL,
+    /// Levenberg-Marquardt on the CPU with adaptive damping
+    LM
+};
+
+/**
+ * @brief Parameters of the Registration, see the registration section of the configuration
+ *
+ * The defaults use every point, no motion prediction, no skipping and no latency budget.
+ */
+struct RegistrationOptions
+{
+    /// max convergence iterations
+    unsigned int max_iterations = 50;
+    /// learning rate weight gradient
+    float it_weight_gradient = 0.0;
+    /// minimum error change between two iterations to stop
+    float epsilon = 0.01;
+    /// maximum number of points used for the registration, 0 uses all points
+    unsigned int point_budget = 0;
+    /// algorithm used to determine the pose
+    SolverMode solver = SolverMode::KERNEL;
+    /// initial damping of the LM solver relative to the diagonal of H
+    float lm_damping = 0.001;
+    /// the LM solver stops if the translation of an update is smaller (in mm)...
+    float lm_translation_epsilon = 1.0;
+    /// ...and the rotation of the update is smaller (in rad)
+    float lm_rotation_epsilon = 0.001;
+    /// number of poses for the constant velocity prediction of the initial pose, values below 2 only use the IMU
+    unsigned int motion_history = 0;
+    /// weight of the IMU rotation when blended with the predicted rotation
+    float motion_imu_weight = 1.0;
+    /// weight of the predicted pose as prior in the LM solver, 0 disables the prior
+    float prior_weight = 0.0;
+    /// translation (in mm) per scan below which the registration may be skipped
+    float skip_translation = 0.0;
+    /// rotation (in rad) per scan below which the registration may be skipped
+    float skip_rotation = 0.0;
+    /// maximum number of scans without registration in a row, 0 never skips
+    unsigned int max_skipped = 0;
+    /// iterations for scans with low motion or while scans are waiting, 0 always uses max_iterations
+    unsigned int refine_iterations = 0;
+    /// time (in ms) from the arrival of a scan until its registration is finished, 0 disables the budget
+    float latency_budget = 0.0;
+    /// iterations below which a registration that is reduced to meet the latency budget loses points instead, at least 1
+    unsigned int latency_min_iterations = 0;
+    /// minimum number of points of a registration that is reduced to meet the latency budget
+    unsigned int latency_min_points = 0;
+};
+
 /**
  * @brief
  *
@@ -37,29 +101,65 @@ private:
 
     ImuAccumulator imu_accumulator_;
 
+    PointSelection point_selection_;
+
+    /// Command queue of the buffer for the selected points
+    fastsense::CommandQueuePtr q_;
+
+    /// Points chosen by the point selection, only allocated if a point budget is set or a scan is degraded
+    std::unique_ptr<fastsense::buffer::InputBuffer<PointHW>> selected_points_;
 
     fastsense::kernels::RegistrationKernel krnl;
 
+    SolverMode solver_;
+
+    LMSolver lm_solver_;
+
+    MotionModel motion_model_;
+
+    ScanPolicy scan_policy_;
+
+    LatencyBudget latency_budget_;
+
+    /// Number of iterations of the last registration
+    int last_iterations_;
+
+    /// Receives a convergence record of every registration, if set
+    msg::RegistrationStatsStampedBuffer::Ptr stats_buffer_;
+
+    /// Statistics of the last registrations for the log
+    util::SlidingWindowFilter<float> iteration_filter_;
+    util::SlidingWindowFilter<float> time_filter_;
+    util::SlidingWindowFilter<float> error_filter_;
+    int registration_count_;
+
+    /// Time from the arrival of the scans to their registration
+    util::ScanAge scan_age_;
+
+    /// Scans that were overwritten in the input buffer since the last log
+    size_t overwritten_;
+
     /**
-     * @brief transforms xi vector 6x1 (angular and linear velocity) to transformation matrix 4x4
+     * @brief Add the results of one registration to the statistics and log them from time to time
      *
-     * @param xi vector
+     * @param iterations number of iterations
+     * @param time runtime of the solver in ms
+     * @param error remaining error of the registration
      */
-    Matrix4f xi_to_transform(Vector6f xi);
+    void update_statistics(int iterations, float time, float error);
 
 public:
 
     /**
      * @brief Construct a new Registration object
      *
-     * TODO
-     *
      * @param q xilinx command queue
      * @param buffer imu buffer stamped shared ptr
-     * @param max_iterations max convergence iterations
-     * @param it_weight_gradient learning rate weight gradient
+     * @param options parameters of the solver, the motion prediction, the skipping and the latency budget
      */
-    Registration(fastsense::CommandQueuePtr q, msg::ImuStampedBuffer::Ptr& buffer, unsigned int max_iterations = 50, float it_weight_gradient = 0.0, float epsilon = 0.01);
+    Registration(fastsense::CommandQueuePtr q,
+                 msg::ImuStampedBuffer::Ptr& buffer,
+                 const RegistrationOptions& options = RegistrationOptions{});
 
     /**
      * Destructor of the registration.
@@ -81,15 +181,31 @@ public:
     /**
      * @brief Registers the given pointcloud with the local ring buffer. Transforms the cloud
      *
+     * The initial pose is predicted from the IMU and the motion model.
+     * If a point budget is set, only the most informative points are used to determine the pose,
+     * but the whole cloud is transformed.
+     * Depending on the motion and the backlog, the registration is skipped or only refines the predicted pose.
+     * The decisions are counted in the runtime statistics as reg_full, reg_refine and reg_skip.
+     * If a latency budget is set, the iterations and then the points are reduced, so that the registration
+     * is finished within the budget after the arrival of the scan. A scan that already missed its deadline
+     * is dropped if a newer one is waiting. The levels are counted as deadline_full, deadline_iterations,
+     * deadline_points and deadline_drop, scans lost in the input buffer as deadline_overwrite (see count_overwritten).
+     *
      * @param cur_buffer
      * @param cloud
-     * @return Matrix4f
+     * @param cloud_timestamp sensor time of the scan, for the IMU and the motion model
+     * @param backlog number of scans waiting for the registration
+     * @param arrival time the scan entered the pipeline, for the latency budget
+     * @return true the cloud was registered and transformed
+     * @return false the scan was dropped, neither the pose nor the cloud were changed
      */
-    void register_cloud(fastsense::map::LocalMap& localmap,
+    bool register_cloud(fastsense::map::LocalMap& localmap,
                         fastsense::buffer::InputBuffer<PointHW>& cloud,
                         int num_points,
                         const util::HighResTimePoint& cloud_timestamp,
-                        Matrix4f& pose);
+                        Matrix4f& pose,
+                        size_t backlog = 0,
+                        const util::SteadyTimePoint& arrival = util::SteadyTime::now());
 
     /**
      * @brief Transforms a given pointcloud with the transform
@@ -106,6 +222,45 @@ public:
      * @param transform
      */
     static void transform_point_cloud(fastsense::buffer::InputBuffer<PointHW>& in_cloud, const Matrix4f& transform);
+
+    /**
+     * @brief Parse the name of a solver from the config
+     *
+     * @param name "kernel" (or empty) or "lm"
+     * @return SolverMode the solver
+     * @throw std::runtime_error if the name is unknown
+     */
+    static SolverMode parse_solver_mode(const std::string& name);
+
+    /**
+     * @brief Number of iterations of the last registration
+     */
+    inline int last_iterations() const
+    {
+        return last_iterations_;
+    }
+
+    /**
+     * @brief Publish a convergence record of every registered scan into the given buffer
+     *
+     * Skipped scans do not produce a record. If the buffer is full, the oldest record is dropped.
+     *
+     * @param stats_buffer buffer for the records, nullptr disables the records
+     */
+    void set_stats_buffer(const msg::RegistrationStatsStampedBuffer::Ptr& stats_buffer);
+
+    /**
+     * @brief Forget the pose history of the motion model, e.g. after the pose was reset
+     */
+    void reset_motion();
+
+    /**
+     * @brief Count scans that never reached the registration, because a newer scan replaced them in the input buffer.
+     *        They are counted as deadline_overwrite next to the levels of the latency budget and logged with the scan age.
+     *
+     * @param scans number of overwritten scans since the last call
+     */
+    void count_overwritten(size_t scans);
 };
 
 
@@ -0,0 +1,81 @@
+/**
+ * @file scan_policy.cpp
+ */
+
+#include <registration/scan_policy.h>
+
+#include <eigen3/Eigen/Geometry>
+
+using namespace fastsense;
+using namespace fastsense::registration;
+
+/// Factor on the thresholds, below which the motion is low enough for a refinement
+constexpr float REFINE_FACTOR = 4.0f;
+
+ScanPolicy::ScanPolicy(float skip_translation, float skip_rotation, unsigned int max_skipped, unsigned int refine_iterations)
+    : skip_translation_{skip_translation},
+      skip_rotation_{skip_rotation},
+      max_skipped_{max_skipped},
+      refine_iterations_{refine_iterations},
+      skipped_{0},
+      deltas_{}
+{
+}
+
+bool ScanPolicy::below(float translation, float rotation, float factor) const
+{
+    return translation < skip_translation_ * factor && rotation < skip_rotation_ * factor;
+}
+
+ScanDecision ScanPolicy::decide(const Matrix4f& imu_estimate, size_t backlog)
+{
+    float imu_translation = imu_estimate.block<3, 1>(0, 3).norm();
+    float imu_rotation = Eigen::AngleAxisf(imu_estimate.block<3, 3>(0, 0)).angle();
+
+    bool stationary = deltas_.size() == HISTORY && below(imu_translation, imu_rotation, 1.0f);
+    bool slow = deltas_.size() == HISTORY && below(imu_translation, imu_rotation, REFINE_FACTOR);
+    for (const auto& delta : deltas_)
+    {
+        stationary = stationary && below(delta.first, delta.second, 1.0f);
+        slow = slow && below(delta.first, delta.second, REFINE_FACTOR);
+    }
+
+    if (stationary && skipped_ < max_skipped_)
+    {
+        skipped_++;
+        return ScanDecision::SKIP;
+    }
+    skipped_ = 0;
+
+    if (refine_iterations_ > 0 && (slow || backlog > 0))
+    {
+        return ScanDecision::REFINE;
+    }
+
+    return ScanDecision::FULL;
+}
+
+void ScanPolicy::update(const Matrix4f& last_pose, const Matrix4f& pose)
+{
+    float translation = (pose.block<3, 1>(0, 3) - last_pose.block<3, 1>(0, 3)).norm();
+    float rotation = Eigen::AngleAxisf(Eigen::Matrix3f(pose.block<3, 3>(0, 0) * last_pose.block<3, 3>(0, 0).transpose())).angle();
+
+    deltas_.emplace_back(translation, rotation);
+    while (deltas_.size() > HISTORY)
+    {
+        deltas_.pop_front();
+    }
+}
+
+const char* ScanPolicy::name(ScanDecision decision)
+{
+    switch (decision)
+    {
+    case ScanDecision::SKIP:
+        return "reg_skip";
+    case ScanDecision::REFINE:
+        return "reg_refine";
+    default:
+        return "reg_full";
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+/**
+ * @file scan_policy.h
+ */
+
+#include <deque>
+
+#include <util/point.h>
+
+namespace fastsense::registration
+{
+
+/**
+ * @brief How much effort is spent on the registration of a scan
+ */
+enum class ScanDecision
+{
+    /// Registration with the full number of iterations
+    FULL,
+    /// Registration with a reduced number of iterations
+    REFINE,
+    /// No registration, the predicted pose is used
+    SKIP
+};
+
+/**
+ * @brief Decides per scan whether it is registered fully, only refined or skipped
+ *
+ * If the IMU and the last registrations show (almost) no motion, the predicted pose is good enough and the
+ * registration is skipped. To limit the drift, only a limited number of scans is skipped in a row.
+ * If the motion is low or scans are waiting in the queue, the registration only gets a few iterations
+ * to refine the predicted pose.
+ */
+class ScanPolicy
+{
+public:
+    /**
+     * @brief Construct a new Scan Policy object
+     *
+     * @param skip_translation Translation (in mm) per scan below which the platform counts as stationary
+     * @param skip_rotation Rotation (in rad) per scan below which the platform counts as stationary
+     * @param max_skipped Maximum number of skipped scans in a row. 0 never skips
+     * @param refine_iterations Iterations of a refinement. 0 always registers fully
+     */
+    ScanPolicy(float skip_translation, float skip_rotation, unsigned int max_skipped, unsigned int refine_iterations);
+
+    /// default destructor
+    ~ScanPolicy() = default;
+
+    /// delete copy assignment operator
+    ScanPolicy& operator=(const ScanPolicy& other) = delete;
+
+    /// delete move assignment operator
+    ScanPolicy& operator=(ScanPolicy&&) noexcept = delete;
+
+    /// delete copy constructor
+    ScanPolicy(const ScanPolicy&) = delete;
+
+    /// delete move constructor
+    ScanPolicy(ScanPolicy&&) = delete;
+
+    /**
+     * @brief Decide how the next scan is registered
+     *
+     * @param imu_estimate Transformation measured by the IMU since the last scan
+     * @param backlog Number of scans waiting in the queue
+     * @return ScanDecision the decision
+     */
+    ScanDecision decide(const Matrix4f& imu_estimate, size_t backlog);
+
+    /**
+     * @brief Add the motion between the last two poses
+     *
+     * @param last_pose Pose of the previous scan
+     * @param pose Pose of the current scan
+     */
+    void update(const Matrix4f& last_pose, const Matrix4f& pose);
+
+    /**
+     * @brief Iterations of a refinement
+     */
+    inline unsigned int refine_iterations() const
+    {
+        return refine_iterations_;
+    }
+
+    /**
+     * @brief Name of a decision for the logs and the runtime statistics
+     */
+    static const char* name(ScanDecision decision);
+
+private:
+    /// Number of registration deltas that need to be stationary
+    static constexpr size_t HISTORY = 3;
+
+    float skip_translation_;
+    float skip_rotation_;
+    unsigned int max_skipped_;
+    unsigned int refine_iterations_;
+
+    /// Number of scans skipped in a row
+    unsigned int skipped_;
+
+    /// Translation and rotation of the last registrations
+    std::deque<std::pair<float, float>> deltas_;
+
+    /**
+     * @brief Checks if the motion is below the given factor of the thresholds
+     */
+    bool below(float translation, float rotation, float factor) const;
+};
+
+} // namespace fastsense::registration
@@ -0,0 +1,64 @@
+#pragma once
+
+/**
+ * @file tsdf_gradient.h
+ */
+
+#include <map/local_map.h>
+
+namespace fastsense::registration
+{
+
+/**
+ * @brief Software version of the map lookup in the registration kernel
+ *
+ * Looks up the TSDF value of the cell the (already transformed) point lies in and
+ * builds the TSDF gradient from the neighbouring cells, exactly like registration_step in krnl_reg.
+ *
+ * @param map Local map the point is registered against
+ * @param point Transformed point in global coordinates
+ * @param value TSDF value of the cell the point lies in
+ * @param gradient TSDF gradient of the cell. Axes without usable neighbours are 0
+ * @return true if the cell was observed, false if the point cannot be used for the registration
+ */
+inline bool tsdf_gradient(const map::LocalMap& map, const Vector3i& point, int& value, Vector3i& gradient)
+{
+    // integer division like in the kernel
+    Vector3i cell = point / MAP_RESOLUTION;
+
+    if (!map.in_bounds(cell))
+    {
+        return false;
+    }
+
+    const auto& current = map.value(cell);
+    if (current.weight() == 0)
+    {
+        return false;
+    }
+    value = current.value();
+
+    gradient = Vector3i::Zero();
+    for (int axis = 0; axis < 3; axis++)
+    {
+        Vector3i last_cell = cell;
+        Vector3i next_cell = cell;
+        last_cell[axis] -= 1;
+        next_cell[axis] += 1;
+        if (!map.in_bounds(last_cell) || !map.in_bounds(next_cell))
+        {
+            continue;
+        }
+
+        const auto& last = map.value(last_cell);
+        const auto& next = map.value(next_cell);
+        if (last.weight() != 0 && next.weight() != 0 && (next.value() > 0) == (last.value() > 0))
+        {
+            gradient[axis] = (next.value() - last.value()) / 2;
+        }
+    }
+
+    return true;
+}
+
+} // namespace fastsense::registration
@@ -66,6 +66,25 @@ public:
                           const buffer::InputBuffer<PointHW>& scan_points,
                           int num_points,
                           PointHW up = PointHW(0, 0, MATRIX_RESOLUTION))
+    {
+        start(map, scan_points, num_points, up).wait();
+    }
+
+    /**
+     * @brief Starts the Kernel with the parameters of the configuration without waiting
+     *
+     * The map and the points must not be used until the returned handle was waited for.
+     *
+     * @param map The local map
+     * @param scan_points The points to update with
+     * @param num_points The number of Points in `scan_points`
+     * @param up A Vector pointing in the up direction of the Scanner
+     * @return kernels::KernelHandle handle to wait for the update
+     */
+    kernels::KernelHandle start(map::LocalMap& map,
+                                const buffer::InputBuffer<PointHW>& scan_points,
+                                int num_points,
+                                PointHW up = PointHW(0, 0, MATRIX_RESOLUTION))
     {
         auto& config = util::config::ConfigManager::config();
 
@@ -83,7 +102,7 @@ public:
             dz_per_distance,
             up);
 
-        waitComplete();
+        return handle();
     }
 
     /**
@@ -7,10 +7,14 @@
  * @author Pascal Buschermoeller
  */
 
+#include <atomic>
 #include <mutex>
 #include <vector>
 #include <condition_variable>
 #include <functional>
+#include <utility>
+
+#include <util/stop_token.h>
 
 constexpr uint32_t DEFAULT_POP_TIMEOUT = 100;
 
@@ -37,7 +41,7 @@ public:
      * @brief Push element non-blocking to the ring buffer.
      *
      * @param val Element to push.
-     * @param force When true, the oldest element will be deleted if the buffer is full.
+     * @param force When true, the oldest element will be deleted if the buffer is full. The deletions are counted by overwritten().
      * @return true Element was sucessfully pushed.
      * @return false The buffer is full.
      */
@@ -50,16 +54,49 @@ public:
      */
     void push(const T& val);
 
+    /**
+     * @brief Push element to the ring buffer. Blocks until an element is popped, the buffer is cleared or the stop is requested.
+     *
+     * @param val Element to push.
+     * @param token Token that cancels the wait.
+     * @return true Element was pushed.
+     * @return false The stop was requested while the buffer was full.
+     */
+    bool push(const T& val, const StopToken& token);
+
+    /**
+     * @brief Block until the ring buffer has a free slot, without pushing. Wakes up on a pop, a clear or the stop.
+     *
+     * Lets a producer that pushes with push_nb hold back until it would not overwrite anything.
+     *
+     * @param token Token that cancels the wait.
+     * @return true The buffer has a free slot.
+     * @return false The stop was requested while the buffer was full.
+     */
+    bool wait_for_space(const StopToken& token);
+
     /**
      * @brief Pop element from the ring buffer
      *
      * @param val Pointer to element to fill with popped value. If val is a nullptr no value is assigned, but an element is popped nonetheless.
-     * @param timeout_ms Time to wait for element to pop.
+     * @param timeout_ms Time to wait for element to pop. A clear ends the wait early.
      * @return true Element popped successfully.
      * @return false The ring buffer is empty.
      */
     bool pop_nb(T* val, uint32_t timeout_ms = 0);
 
+    /**
+     * @brief Pop element from the ring buffer. Blocks until an element is pushed, the buffer is cleared or the stop is requested.
+     *
+     * Waiting consumers need no timeout to notice a stop, so they do not wake up while the buffer is empty.
+     *
+     * @param val Pointer to element to fill with popped value. If val is a nullptr no value is assigned, but an element is popped nonetheless.
+     * @param token Token that cancels the wait.
+     * @return true Element popped successfully.
+     * @return false The stop was requested or the buffer was cleared while it was empty.
+     */
+    bool pop(T* val, const StopToken& token);
+
     /**
      * @brief Pop element from the ring buffer. Blocks until an element is pushed.
      *
@@ -103,7 +140,31 @@ public:
     void peek(T* val);
 
     /**
-     * @brief Clear the buffer
+     * @brief Move out the elements at the front of the buffer as long as they fulfill the predicate.
+     *
+     * All elements are taken in a single critical section, so a consumer that processes every
+     * waiting element pays for the lock once per batch instead of once per element.
+     *
+     * @param pred predicate that is called with each front element, draining stops at the first element it rejects
+     * @param out array to move the drained elements to, in the order of the buffer
+     * @param max_count size of out, at most this many elements are drained
+     * @return size_t number of drained elements
+     */
+    template<typename PRED>
+    size_t drain_until(PRED pred, T* out, size_t max_count);
+
+    /**
+     * @brief Look at the front element without copying or popping it.
+     *
+     * @param func function that is called with the front element while the buffer is locked
+     * @return true if the function was called
+     * @return false if the buffer is empty
+     */
+    template<typename FUNC>
+    bool peek_front(FUNC func);
+
+    /**
+     * @brief Clear the buffer. Wakes up all threads that wait to push or pop.
      *
      */
     void clear();
@@ -148,6 +209,14 @@ public:
         return size_ == buffer_.size();
     }
 
+    /**
+     * @brief Number of elements that were deleted by a forced push_nb before they were popped
+     */
+    size_t overwritten() const
+    {
+        return overwritten_.load(std::memory_order_relaxed);
+    }
+
     using Ptr = std::shared_ptr<ConcurrentRingBuffer<T>>;
 
 private:
@@ -177,6 +246,12 @@ private:
     /// Current pop position
     size_t popIdx_;
 
+    /// Number of clears, to end the waits of consumers
+    size_t clears_;
+
+    /// Number of elements deleted by forced pushes
+    std::atomic<size_t> overwritten_;
+
     /// Mutex for locking
     std::mutex mutex_;
 
@@ -14,6 +14,8 @@ ConcurrentRingBuffer<T>::ConcurrentRingBuffer(size_t capacity)
       size_(0),
       pushIdx_(0),
       popIdx_(0),
+      clears_(0),
+      overwritten_(0),
       mutex_({}),
       cvEmpty_({}),
       cvFull_({})
@@ -29,6 +31,7 @@ bool ConcurrentRingBuffer<T>::push_nb(const T& val, bool force)
         if (force)
         {
             doPop(nullptr);
+            overwritten_.fetch_add(1, std::memory_order_relaxed);
         }
         else
         {
@@ -54,13 +57,61 @@ void ConcurrentRingBuffer<T>::push(const T& val)
     cvEmpty_.notify_one();
 }
 
+template<typename T>
+bool ConcurrentRingBuffer<T>::push(const T& val, const StopToken& token)
+{
+    // destroyed after the lock is released, a running invocation locks the mutex
+    StopCallback wake{token, [this]()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cvFull_.notify_all();
+    }};
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (full())
+    {
+        cvFull_.wait(lock, [&] { return size_ < buffer_.size() || token.stop_requested(); });
+        if (full())
+        {
+            return false;
+        }
+    }
+
+    doPush(val);
+    cvEmpty_.notify_one();
+    return true;
+}
+
+template<typename T>
+bool ConcurrentRingBuffer<T>::wait_for_space(const StopToken& token)
+{
+    // destroyed after the lock is released, a running invocation locks the mutex
+    StopCallback wake{token, [this]()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cvFull_.notify_all();
+    }};
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    cvFull_.wait(lock, [&] { return size_ < buffer_.size() || token.stop_requested(); });
+    if (full())
+    {
+        return false;
+    }
+
+    // the slot is not taken here, so a pop that woke this wait instead of a blocked push passes it on
+    cvFull_.notify_one();
+    return true;
+}
+
 template<typename T>
 bool ConcurrentRingBuffer<T>::pop_nb(T* val, uint32_t timeout_ms)
 {
     std::unique_lock<std::mutex> lock(mutex_);
     if (empty())
     {
-        if(timeout_ms == 0 || !cvEmpty_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] { return size_ != 0; }))
+        size_t clears = clears_;
+        if(timeout_ms == 0 || !cvEmpty_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] { return size_ != 0 || clears_ != clears; }) || empty())
         {
             return false;
         }
@@ -84,6 +135,32 @@ void ConcurrentRingBuffer<T>::pop(T* val)
     cvFull_.notify_one();
 }
 
+template<typename T>
+bool ConcurrentRingBuffer<T>::pop(T* val, const StopToken& token)
+{
+    // destroyed after the lock is released, a running invocation locks the mutex
+    StopCallback wake{token, [this]()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cvEmpty_.notify_all();
+    }};
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (empty())
+    {
+        size_t clears = clears_;
+        cvEmpty_.wait(lock, [&] { return size_ != 0 || clears_ != clears || token.stop_requested(); });
+        if (empty())
+        {
+            return false;
+        }
+    }
+
+    doPop(val);
+    cvFull_.notify_one();
+    return true;
+}
+
 template<typename T>
 bool ConcurrentRingBuffer<T>::pop_nb_if(T* val, std::function<bool(T&)> func, uint32_t timeout_ms)
 {
@@ -162,6 +239,45 @@ void ConcurrentRingBuffer<T>::peek(T* val)
     *val = buffer_[popIdx_];
 }
 
+template<typename T>
+template<typename PRED>
+size_t ConcurrentRingBuffer<T>::drain_until(PRED pred, T* out, size_t max_count)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t count = 0;
+    while (count < max_count && size_ > 0 && pred(std::as_const(buffer_[popIdx_])))
+    {
+        out[count++] = std::move(buffer_[popIdx_]);
+        size_--;
+        popIdx_++;
+
+        if (popIdx_ == buffer_.size())
+        {
+            popIdx_ = 0;
+        }
+    }
+
+    if (count > 0)
+    {
+        cvFull_.notify_all();
+    }
+    return count;
+}
+
+template<typename T>
+template<typename FUNC>
+bool ConcurrentRingBuffer<T>::peek_front(FUNC func)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (empty())
+    {
+        return false;
+    }
+
+    func(std::as_const(buffer_[popIdx_]));
+    return true;
+}
+
 template<typename T>
 void ConcurrentRingBuffer<T>::clear()
 {
@@ -170,7 +286,9 @@ void ConcurrentRingBuffer<T>::clear()
     size_ = 0;
     pushIdx_ = 0;
     popIdx_ = 0;
+    clears_++;
     cvFull_.notify_all();
+    cvEmpty_.notify_all();
 }
 
 template<typename T>
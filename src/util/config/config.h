@@ -23,12 +23,31 @@ struct LidarConfig : public ConfigGroup
     using ConfigGroup::ConfigGroup;
 
     DECLARE_CONFIG_ENTRY(size_t, bufferSize, "Size of the Buffer for incoming values");
+    DECLARE_CONFIG_ENTRY(std::string, source, "Source of the packets: 'velodyne' for the sensor or 'pcap' for a recording");
+    DECLARE_CONFIG_ENTRY(std::string, pcap_file, "Recording that is replayed when 'source' is 'pcap'");
+    DECLARE_CONFIG_ENTRY(float, replay_speed, "Speed factor of the replay of the recording, 0 replays as fast as possible");
     DECLARE_CONFIG_ENTRY(uint16_t, port, "The Port to listen to");
+    DECLARE_CONFIG_ENTRY(int, receive_buffer, "Size of the socket receive buffer in bytes, 0 keeps the system default");
+    DECLARE_CONFIG_ENTRY(size_t, packet_ring_size, "Number of packets between the receive and the decode thread");
     DECLARE_CONFIG_ENTRY(float, pointScale, "A Factor to apply to the entire Cloud");
     DECLARE_CONFIG_ENTRY(int, rings, "The number of rings that the lidar has");
     DECLARE_CONFIG_ENTRY(float, vertical_fov_angle, "The field of view in vertical direction in degrees");
 };
 
+struct PreprocessingConfig : public ConfigGroup
+{
+    using ConfigGroup::ConfigGroup;
+
+    DECLARE_CONFIG_ENTRY(unsigned int, threads, "Number of partitions of the reduction filter, processed by the worker pool. 0 uses one per thread of the pool");
+    DECLARE_CONFIG_ENTRY(int, median_window, "Window size of the ring-wise median filter. Has to be odd, 0 disables the filter");
+    DECLARE_CONFIG_ENTRY(float, outlier_distance, "Maximum range difference of a neighbour in the outlier filter");
+    DECLARE_CONFIG_ENTRY(int, outlier_neighbors, "Minimum number of neighbours to keep a point. 0 disables the outlier filter");
+    DECLARE_CONFIG_ENTRY(int, column_step, "Number of columns of a ring merged into one point. 1 disables the downsampling");
+    DECLARE_CONFIG_ENTRY(int, target_points, "Point budget per reduced scan, the voxel size is adapted to it. 0 keeps the voxel size at the map resolution");
+    DECLARE_CONFIG_ENTRY(float, target_tolerance, "Relative deviation from the point budget that starts an adaption of the voxel size");
+    DECLARE_CONFIG_ENTRY(int, max_voxel_size, "Largest voxel size (in mm) of the adaption");
+};
+
 struct BridgeConfig : public ConfigGroup
 {
     using ConfigGroup::ConfigGroup;
@@ -41,7 +60,6 @@ struct BridgeConfig : public ConfigGroup
     DECLARE_CONFIG_ENTRY(bool, send_after_registration, "send PointCloud after Registration. Only one send_* option can be active");
 
     DECLARE_CONFIG_ENTRY(std::string, host_from, "IP Address of the PC when 'use_from' is true");
-    DECLARE_CONFIG_ENTRY(uint16_t, recv_timeout, "Timeout for the receiver");
 
     DECLARE_CONFIG_ENTRY(uint16_t, imu_port_from, "Port of the from bridge for imu");
     DECLARE_CONFIG_ENTRY(uint16_t, imu_port_to, "Port of the to bridge for imu");
@@ -51,6 +69,8 @@ struct BridgeConfig : public ConfigGroup
 
     DECLARE_CONFIG_ENTRY(uint16_t, transform_port_to, "Port of the to bridge for transform");
     DECLARE_CONFIG_ENTRY(uint16_t, tsdf_port_to, "Port of the to bridge for tsdf");
+    DECLARE_CONFIG_ENTRY(uint16_t, registration_port_to, "Port of the to bridge for the registration statistics");
+    DECLARE_CONFIG_ENTRY(uint16_t, preprocessing_port_to, "Port of the to bridge for the preprocessing statistics");
 };
 
 struct GPIOConfig : public ConfigGroup
@@ -71,6 +91,22 @@ struct RegistrationConfig : public ConfigGroup
     DECLARE_CONFIG_ENTRY(unsigned int, max_iterations, "Maximum number of iterations for the Registration");
     DECLARE_CONFIG_ENTRY(float, it_weight_gradient, "Factor to reduce Registration influence on later iterations");
     DECLARE_CONFIG_ENTRY(float, epsilon, "Minimum change between two iterations to stop Registration");
+    DECLARE_CONFIG_ENTRY(unsigned int, point_budget, "Maximum number of points used for the Registration. 0 uses all points");
+    DECLARE_CONFIG_ENTRY(std::string, solver, "Solver for the Registration: 'kernel' (FPGA) or 'lm' (Levenberg-Marquardt on the CPU)");
+    DECLARE_CONFIG_ENTRY(float, lm_damping, "Initial damping of the LM solver relative to the diagonal of H");
+    DECLARE_CONFIG_ENTRY(float, lm_translation_epsilon, "The LM solver stops if the translation of an update is smaller (in mm)");
+    DECLARE_CONFIG_ENTRY(float, lm_rotation_epsilon, "The LM solver stops if the rotation of an update is smaller (in rad)");
+    DECLARE_CONFIG_ENTRY(unsigned int, motion_history, "Number of poses for the constant velocity prediction of the initial pose. Below 2 only the IMU is used");
+    DECLARE_CONFIG_ENTRY(float, motion_imu_weight, "Weight of the IMU rotation when blended with the predicted rotation (0 to 1)");
+    DECLARE_CONFIG_ENTRY(float, prior_weight, "Weight of the predicted pose as prior in the LM solver. 0 disables the prior");
+    DECLARE_CONFIG_ENTRY(float, skip_translation, "Translation per scan (in mm) below which the registration may be skipped");
+    DECLARE_CONFIG_ENTRY(float, skip_rotation, "Rotation per scan (in rad) below which the registration may be skipped");
+    DECLARE_CONFIG_ENTRY(unsigned int, max_skipped, "Maximum number of skipped registrations in a row. 0 never skips");
+    DECLARE_CONFIG_ENTRY(unsigned int, refine_iterations, "Iterations for scans with low motion or a backlog. 0 always uses max_iterations");
+    DECLARE_CONFIG_ENTRY(float, latency_budget, "Time (in ms) from the arrival of a scan until its registration is finished. 0 disables the budget");
+    DECLARE_CONFIG_ENTRY(unsigned int, latency_min_iterations, "Iterations below which a registration that is reduced to meet the latency budget loses points instead");
+    DECLARE_CONFIG_ENTRY(unsigned int, latency_min_points, "Minimum number of points of a registration that is reduced to meet the latency budget");
+    DECLARE_CONFIG_ENTRY(size_t, queue_size, "Number of preprocessed scans that can wait for the registration");
 };
 
 struct SlamConfig : public ConfigGroup
@@ -87,20 +123,49 @@ struct SlamConfig : public ConfigGroup
 
     DECLARE_CONFIG_ENTRY(unsigned int, map_update_period, "Number of Scans before a TSDF Update happens");
     DECLARE_CONFIG_ENTRY(float, map_update_position_threshold, "Distance since the last TSDF Update before a new one happens");
+    DECLARE_CONFIG_ENTRY(unsigned int, map_update_max_batch, "Maximum number of scans that are integrated by one TSDF Update");
 
     DECLARE_CONFIG_ENTRY(std::string, map_path, "Path where the global map should be saved");
 };
 
+struct ThreadConfig : public ConfigGroup
+{
+    using ConfigGroup::ConfigGroup;
+
+    DECLARE_CONFIG_ENTRY(std::string, name, "Name of the thread (at most 15 characters)");
+    DECLARE_CONFIG_ENTRY(std::string, cpus, "CPU cores the thread may run on, e.g. '2', '0,1' or '1-3'. Empty runs on all cores");
+    DECLARE_CONFIG_ENTRY(int, priority, "SCHED_FIFO priority from 1 to 99. 0 keeps the default scheduling");
+    DECLARE_CONFIG_ENTRY(int, pool_priority, "Priority of the parallel loops of the thread in the worker pool. Higher runs first");
+};
+
+struct ThreadsConfig : public ConfigGroup
+{
+    using ConfigGroup::ConfigGroup;
+
+    DECLARE_CONFIG_ENTRY(unsigned int, pool_size, "Number of worker threads for the parallel loops. 0 runs every loop on the thread that starts it");
+    DECLARE_CONFIG_GROUP(ThreadConfig, pool);
+    DECLARE_CONFIG_GROUP(ThreadConfig, lidar);
+    DECLARE_CONFIG_GROUP(ThreadConfig, lidar_decode);
+    DECLARE_CONFIG_GROUP(ThreadConfig, imu_bridge);
+    DECLARE_CONFIG_GROUP(ThreadConfig, preprocessing);
+    DECLARE_CONFIG_GROUP(ThreadConfig, registration);
+    DECLARE_CONFIG_GROUP(ThreadConfig, map);
+    DECLARE_CONFIG_GROUP(ThreadConfig, map_export);
+    DECLARE_CONFIG_GROUP(ThreadConfig, bridges);
+};
+
 struct Config : public ConfigGroup
 {
     using ConfigGroup::ConfigGroup;
 
     DECLARE_CONFIG_GROUP(ImuConfig, imu);
     DECLARE_CONFIG_GROUP(LidarConfig, lidar);
+    DECLARE_CONFIG_GROUP(PreprocessingConfig, preprocessing);
     DECLARE_CONFIG_GROUP(RegistrationConfig, registration);
     DECLARE_CONFIG_GROUP(GPIOConfig, gpio);
     DECLARE_CONFIG_GROUP(BridgeConfig, bridge);
     DECLARE_CONFIG_GROUP(SlamConfig, slam);
+    DECLARE_CONFIG_GROUP(ThreadsConfig, threads);
 };
 
 } // namespace fastsense::util::config
@@ -26,3 +26,10 @@ constexpr int MATRIX_RESOLUTION = 1 << 15; // == pow(2, 15)
  * // MARKER: TSDF SPLIT
  */
 constexpr int TSDF_SPLIT_FACTOR = 4;
+
+/**
+ * @brief Entries of the output buffer of the registration kernel in front of the errors per iteration
+ *
+ * 4x4 Matrix, number of iterations, error, number of points that hit the map and the 6x6 H matrix
+ */
+constexpr int REG_OUT_HEADER_SIZE = 16 + 3 + 36;
@@ -5,7 +5,9 @@
  * @author Julian Gaal
  */
 
-#include <queue>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
 
 namespace fastsense::util
 {
@@ -44,10 +46,117 @@ protected:
     virtual const T &update(const T &new_value) = 0;
 };
 
+/**
+ * Fixed capacity window of the last values of a filter
+ *
+ * The values are stored in a ring array that is allocated once in the constructor,
+ * so pushing a value never allocates. When the window is full, the oldest value is overwritten.
+ *
+ * @tparam T Datatype of the values
+ */
+template<typename T>
+class FilterWindow
+{
+public:
+    /**
+     * Construct a Filter Window
+     * @param capacity maximum number of values
+     */
+    explicit FilterWindow(size_t capacity)
+    : values_(capacity)
+    , head_{0}
+    , tail_{0}
+    , size_{0}
+    {}
+
+    /**
+     * Add a value. Overwrites the oldest value if the window is full
+     * @param value new value
+     */
+    void push(const T& value)
+    {
+        if (values_.empty())
+        {
+            return;
+        }
+
+        values_[tail_] = value;
+        tail_ = next(tail_);
+        if (full())
+        {
+            head_ = tail_;
+        }
+        else
+        {
+            size_++;
+        }
+    }
+
+    /// Get the value at the given position, 0 is the oldest value
+    const T& operator[](size_t index) const
+    {
+        size_t position = head_ + index;
+        return values_[position < values_.size() ? position : position - values_.size()];
+    }
+
+    /// Get the oldest value
+    const T& front() const
+    {
+        return (*this)[0];
+    }
+
+    /// Get the newest value
+    const T& back() const
+    {
+        return (*this)[size_ - 1];
+    }
+
+    /// Get the number of values
+    size_t size() const
+    {
+        return size_;
+    }
+
+    /// Get the maximum number of values
+    size_t capacity() const
+    {
+        return values_.size();
+    }
+
+    /// Check if the window has reached its capacity
+    bool full() const
+    {
+        return size_ == values_.size();
+    }
+
+private:
+    /// Position after the given one, without a division
+    size_t next(size_t position) const
+    {
+        return position + 1 < values_.size() ? position + 1 : 0;
+    }
+
+    /// Ring array of the values
+    std::vector<T> values_;
+
+    /// Position of the oldest value
+    size_t head_;
+
+    /// Position of the next value
+    size_t tail_;
+
+    /// Number of values
+    size_t size_;
+};
+
 /**
  * Performs Average calculation across a dynamic window
  * https://de.wikipedia.org/wiki/Gleitender_Mittelwert#Gleitender_Durchschnitt_mit_dynamischem_Fenster
  *
+ * The mean is kept as a running sum of value / window_size, updated by the value that enters and the one
+ * that leaves the window. The rounding errors of these updates add up over a long run. With compensated
+ * summation (Kahan), the lost low order bits are carried into the next update instead.
+ *
  * @tparam T Datatype to be filtered
  */
 template<typename T>
@@ -57,12 +166,15 @@ public:
     /**
      * Construct a Sliding Window Filter
      * @param window_size size of window
+     * @param compensated use compensated summation for the running mean
      */
-    explicit SlidingWindowFilter(size_t window_size)
+    explicit SlidingWindowFilter(size_t window_size, bool compensated = false)
     : Filter<T>{}
     , window_size_{static_cast<double>(window_size)}
-    , buffer_{}
+    , compensated_{compensated}
+    , buffer_{window_size}
     , mean_{}
+    , compensation_{}
     {}
 
     /**
@@ -79,23 +191,22 @@ public:
             return new_value;
         }
 
-        buffer_.push(new_value);
-
         /// Fill buffer until window_size is reached (initialization)
-        if (buffer_.size() <= window_size_)
+        if (!buffer_.full())
         {
-            mean_ += (new_value / window_size_);
+            buffer_.push(new_value);
+            add(new_value / window_size_);
             return new_value;
         }
 
-        /// Calculate mean and throw away head of queue
-        mean_ += (buffer_.back() - buffer_.front())/window_size_;
-        buffer_.pop();
+        /// Calculate mean and overwrite the oldest value
+        add((new_value - buffer_.front()) / window_size_);
+        buffer_.push(new_value);
         return mean_;
     }
 
     /// Get const reference to underlying buffer
-    const std::queue<T>& get_buffer() const
+    const FilterWindow<T>& get_buffer() const
     {
         return buffer_;
     }
@@ -107,14 +218,180 @@ public:
     }
 
 private:
+    /**
+     * Add a change to the running mean
+     * @param delta change of the mean
+     */
+    template<typename D>
+    void add(const D& delta)
+    {
+        if (!compensated_)
+        {
+            mean_ += delta;
+            return;
+        }
+
+        // keeps the precision of delta, so the compensation also covers its rounding to T
+        auto corrected = delta - compensation_;
+        T sum = mean_ + corrected;
+        compensation_ = (sum - mean_) - corrected;
+        mean_ = sum;
+    }
+
     /// Window size: to not risk
     double window_size_;
 
-    /// Queue thats used to implement the dynamic window
-    std::queue<T> buffer_;
+    /// Use compensated summation for the mean
+    bool compensated_;
+
+    /// Ring array thats used to implement the dynamic window
+    FilterWindow<T> buffer_;
+
+    /// The current mean
+    T mean_;
+
+    /// Low order bits that were lost in the last update of the mean
+    T compensation_;
+};
+
+/**
+ * Performs Median calculation across a sliding window
+ *
+ * Besides the window, the values are kept sorted in an array of the same capacity.
+ * An update removes the oldest and inserts the new value by shifting, so it neither allocates nor sorts.
+ * For an even number of values, the upper one of the two middle values is the median.
+ *
+ * @tparam T Datatype to be filtered, has to be ordered by operator<
+ */
+template<typename T>
+class SlidingMedianFilter : public Filter<T>
+{
+public:
+    /**
+     * Construct a Sliding Median Filter
+     * @param window_size size of window
+     */
+    explicit SlidingMedianFilter(size_t window_size)
+    : Filter<T>{}
+    , buffer_{window_size}
+    , sorted_{}
+    , median_{}
+    {
+        sorted_.reserve(window_size);
+    }
+
+    /**
+     * Performs update of median with new data across the sliding window
+     *
+     * @param new_value type T
+     * @return median of the values in the window
+     */
+    const T &update(const T &new_value)
+    {
+        /// Window too small for sensible results
+        if (buffer_.capacity() < 2)
+        {
+            median_ = new_value;
+            return median_;
+        }
+
+        if (buffer_.full())
+        {
+            sorted_.erase(std::lower_bound(sorted_.begin(), sorted_.end(), buffer_.front()));
+        }
+        buffer_.push(new_value);
+        sorted_.insert(std::upper_bound(sorted_.begin(), sorted_.end(), new_value), new_value);
+
+        median_ = sorted_[sorted_.size() / 2];
+        return median_;
+    }
+
+    /// Get const reference to underlying buffer
+    const FilterWindow<T>& get_buffer() const
+    {
+        return buffer_;
+    }
+
+    /// Get const reference to current median
+    const T& get_median() const
+    {
+        return median_;
+    }
+
+private:
+    /// Ring array thats used to implement the sliding window
+    FilterWindow<T> buffer_;
+
+    /// The values of the window in ascending order
+    std::vector<T> sorted_;
+
+    /// The current median
+    T median_;
+};
+
+/**
+ * Performs an exponential moving average: mean += alpha * (new_value - mean)
+ *
+ * Needs no window at all. The first value initializes the mean.
+ *
+ * @tparam T Datatype to be filtered
+ */
+template<typename T>
+class ExponentialFilter : public Filter<T>
+{
+public:
+    /**
+     * Construct an Exponential Filter
+     * @param alpha weight of a new value, in (0, 1]. 1 disables the filter
+     */
+    explicit ExponentialFilter(double alpha)
+    : Filter<T>{}
+    , divisor_{}
+    , initialized_{false}
+    , mean_{}
+    {
+        if (!(alpha > 0.0 && alpha <= 1.0))
+        {
+            throw std::runtime_error("The weight of an exponential filter has to be in (0, 1]");
+        }
+        // the messages can only be divided by a scalar
+        divisor_ = 1.0 / alpha;
+    }
+
+    /**
+     * Performs update of the exponential average with new data
+     *
+     * @param new_value type T
+     * @return updated mean
+     */
+    const T &update(const T &new_value)
+    {
+        if (!initialized_)
+        {
+            mean_ = new_value;
+            initialized_ = true;
+            return mean_;
+        }
+
+        mean_ += (new_value - mean_) / divisor_;
+        return mean_;
+    }
+
+    /// Get const reference to current mean
+    const T& get_mean() const
+    {
+        return mean_;
+    }
+
+private:
+    /// 1 / alpha
+    double divisor_;
+
+    /// Whether the mean was initialized by a value
+    bool initialized_;
 
     /// The current mean
     T mean_;
 };
 
-} // namespace fastsense::driver
\ No newline at end of file
+} // namespace fastsense::driver
@@ -0,0 +1,101 @@
+#pragma once
+
+/**
+ * @file futex.h
+ */
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fastsense::util
+{
+
+/**
+ * @brief Event counter to sleep on without a mutex, built on the futex system call.
+ *
+ * A waiter reads the counter with value(), checks its condition and sleeps with wait() if the condition is not met.
+ * A notifier changes the condition and calls notify_all(). The system call is only made when someone sleeps,
+ * so notifying is a single atomic increment when nobody waits.
+ */
+class Futex
+{
+public:
+    /// default constructor
+    Futex() : word_{0}, waiters_{0}
+    {
+    }
+
+    /// default destructor
+    ~Futex() = default;
+
+    /// delete copy assignment operator
+    Futex& operator=(const Futex& other) = delete;
+
+    /// delete move assignment operator
+    Futex& operator=(Futex&&) noexcept = delete;
+
+    /// delete copy constructor
+    Futex(const Futex&) = delete;
+
+    /// delete move constructor
+    Futex(Futex&&) = delete;
+
+    /**
+     * @brief Current value of the counter. Read it before checking the condition.
+     */
+    uint32_t value() const
+    {
+        return word_.load(std::memory_order_seq_cst);
+    }
+
+    /**
+     * @brief Sleep as long as the counter has the given value, at most for the timeout. Wakes up spuriously.
+     *
+     * @param expected value of the counter before checking the condition
+     * @param timeout maximum time to sleep, nullptr to sleep until notified
+     */
+    void wait(uint32_t expected, const std::chrono::nanoseconds* timeout = nullptr)
+    {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        if (word_.load(std::memory_order_seq_cst) == expected)
+        {
+            timespec ts{};
+            if (timeout != nullptr)
+            {
+                ts.tv_sec = timeout->count() / 1000000000;
+                ts.tv_nsec = timeout->count() % 1000000000;
+            }
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word_), FUTEX_WAIT_PRIVATE, expected,
+                    timeout != nullptr ? &ts : nullptr, nullptr, 0);
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Change the counter and wake up all sleeping threads. Call it after the condition changed.
+     */
+    void notify_all()
+    {
+        word_.fetch_add(1, std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_seq_cst) > 0)
+        {
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+        }
+    }
+
+private:
+    /// Counter the threads sleep on
+    std::atomic<uint32_t> word_;
+    /// Number of threads that are about to sleep or sleep
+    std::atomic<uint32_t> waiters_;
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "the futex system call needs a plain 32 bit word");
+
+} // namespace fastsense::util
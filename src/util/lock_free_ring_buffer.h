@@ -0,0 +1,199 @@
+#pragma once
+
+/**
+ * @file lock_free_ring_buffer.h
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <util/futex.h>
+
+namespace fastsense::util
+{
+
+/// Number of retries, each giving up the time slice, before a blocking push or pop sleeps
+constexpr int SPIN_COUNT = 16;
+
+/**
+ * @brief Bounded ring buffer without locks, with the interface of the ConcurrentRingBuffer.
+ *
+ * Every slot carries a sequence number that tells producers and consumers whether it is free or filled
+ * (Vyukov's bounded queue), so a consumer reads its slot after claiming it without blocking the producers
+ * of the other slots. Elements are moved in and out, a popped slot keeps no copy of the element.
+ * Blocking calls retry a few times before they sleep on a futex, which is only woken when a thread actually sleeps.
+ *
+ * Consumers always claim the read position with a compare-and-swap, because a forced push lets the producer
+ * drop the oldest element while a consumer pops. With MULTI_PRODUCER = false, the write position is advanced
+ * without a compare-and-swap, which is only correct for a single producer thread.
+ *
+ * @tparam T Type of the buffer. Has to be default constructible and move assignable.
+ * @tparam MULTI_PRODUCER Whether several threads push concurrently.
+ */
+template<typename T, bool MULTI_PRODUCER>
+class LockFreeRingBuffer
+{
+public:
+    /**
+     * @brief Construct a new Lock Free Ring Buffer object with specified size.
+     *
+     * @param size Size of the buffer.
+     */
+    explicit LockFreeRingBuffer(size_t size);
+
+    /// default destructor
+    ~LockFreeRingBuffer() = default;
+
+    /// delete copy assignment operator
+    LockFreeRingBuffer& operator=(const LockFreeRingBuffer& other) = delete;
+
+    /// delete move assignment operator
+    LockFreeRingBuffer& operator=(LockFreeRingBuffer&&) noexcept = delete;
+
+    /// delete copy constructor
+    LockFreeRingBuffer(const LockFreeRingBuffer&) = delete;
+
+    /// delete move constructor
+    LockFreeRingBuffer(LockFreeRingBuffer&&) = delete;
+
+    /**
+     * @brief Push element non-blocking to the ring buffer.
+     *
+     * @param val Element to push. It is only moved from if it was pushed.
+     * @param force When true, the oldest element will be deleted if the buffer is full. A slot that is still
+     *              being popped by a consumer is waited for instead of dropping further elements.
+     * @return true Element was sucessfully pushed.
+     * @return false The buffer is full.
+     */
+    template<typename U>
+    bool push_nb(U&& val, bool force = false);
+
+    /**
+     * @brief Push element to the ring buffer. Blocks until an element is popped or the buffer is cleared.
+     *
+     * @param val Element to push.
+     */
+    template<typename U>
+    void push(U&& val);
+
+    /**
+     * @brief Pop element from the ring buffer
+     *
+     * @param val Pointer to element to move the popped value to. If val is a nullptr the element is popped and destroyed.
+     * @param timeout_ms Time to wait for element to pop.
+     * @return true Element popped successfully.
+     * @return false The ring buffer is empty.
+     */
+    bool pop_nb(T* val, uint32_t timeout_ms = 0);
+
+    /**
+     * @brief Pop element from the ring buffer. Blocks until an element is pushed.
+     *
+     * @param val Pointer to element to move the popped value to. If val is a nullptr the element is popped and destroyed.
+     */
+    void pop(T* val);
+
+    /**
+     * @brief Pop and destroy all elements
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Current number of elements. Only a snapshot while other threads push or pop.
+     * @return buffer size
+     */
+    size_t size() const;
+
+    /**
+     * @brief return total capacity of the ring buffer
+     * @return buffer capacity
+     */
+    inline size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    /**
+     * @brief Check if buffer is empty
+     *
+     * @return true if empty
+     * @return false if not empty
+     */
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Check if buffer is full
+     *
+     * @return true if full
+     * @return false if not full
+     */
+    bool full() const
+    {
+        return size() == capacity_;
+    }
+
+    using Ptr = std::shared_ptr<LockFreeRingBuffer<T, MULTI_PRODUCER>>;
+
+private:
+    /// Element with the sequence number of its state
+    struct Slot
+    {
+        /// position + 1 if filled, position if free for the push to position
+        std::atomic<size_t> sequence;
+        /// the element
+        T value;
+    };
+
+    /**
+     * @brief Push if there is a free slot
+     *
+     * @param val Element to push, only moved from on success.
+     * @return true if pushed
+     */
+    template<typename U>
+    bool try_push(U&& val);
+
+    /**
+     * @brief Pop if there is a filled slot
+     *
+     * @param val Pointer to element to move the popped value to, or nullptr.
+     * @return true if popped
+     */
+    bool try_pop(T* val);
+
+    /// Number of slots
+    size_t capacity_;
+
+    /// Slots containing the data
+    std::vector<Slot> slots_;
+
+    /// Next push position
+    alignas(64) std::atomic<size_t> head_;
+
+    /// Next pop position
+    alignas(64) std::atomic<size_t> tail_;
+
+    /// Signaled after every push, for threads that wait while the buffer is empty
+    alignas(64) Futex pushed_;
+
+    /// Signaled after every pop, for threads that wait while the buffer is full
+    alignas(64) Futex popped_;
+};
+
+/// Lock-free ring buffer for one producer thread. Any number of threads may pop.
+template<typename T>
+using SpscRingBuffer = LockFreeRingBuffer<T, false>;
+
+/// Lock-free ring buffer for any number of producer and consumer threads.
+template<typename T>
+using MpmcRingBuffer = LockFreeRingBuffer<T, true>;
+
+} // namespace fastsense::util
+
+#include "lock_free_ring_buffer.tcc"
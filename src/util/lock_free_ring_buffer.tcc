@@ -0,0 +1,231 @@
+#pragma once
+
+/**
+ * @file lock_free_ring_buffer.tcc
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace fastsense::util
+{
+
+template<typename T, bool MULTI_PRODUCER>
+LockFreeRingBuffer<T, MULTI_PRODUCER>::LockFreeRingBuffer(size_t size)
+    : capacity_{size},
+      slots_(size),
+      head_{0},
+      tail_{0},
+      pushed_{},
+      popped_{}
+{
+    if (size == 0)
+    {
+        throw std::runtime_error("ring buffer needs at least one slot");
+    }
+
+    for (size_t i = 0; i < capacity_; i++)
+    {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template<typename T, bool MULTI_PRODUCER>
+template<typename U>
+bool LockFreeRingBuffer<T, MULTI_PRODUCER>::try_push(U&& val)
+{
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &slots_[pos % capacity_];
+        auto diff = static_cast<std::ptrdiff_t>(slot->sequence.load(std::memory_order_acquire) - pos);
+        if (diff == 0)
+        {
+            if constexpr (MULTI_PRODUCER)
+            {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else
+            {
+                head_.store(pos + 1, std::memory_order_relaxed);
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // the slot of the last round was not popped yet
+            return false;
+        }
+        else
+        {
+            // another producer was faster
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->value = std::forward<U>(val);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    pushed_.notify_all();
+    return true;
+}
+
+template<typename T, bool MULTI_PRODUCER>
+bool LockFreeRingBuffer<T, MULTI_PRODUCER>::try_pop(T* val)
+{
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &slots_[pos % capacity_];
+        auto diff = static_cast<std::ptrdiff_t>(slot->sequence.load(std::memory_order_acquire) - (pos + 1));
+        if (diff == 0)
+        {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // the slot was not pushed yet
+            return false;
+        }
+        else
+        {
+            // another consumer was faster
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    if (val != nullptr)
+    {
+        *val = std::move(slot->value);
+    }
+    else
+    {
+        // release what the element holds, e.g. the last reference to a point cloud
+        slot->value = T();
+    }
+    slot->sequence.store(pos + capacity_, std::memory_order_release);
+    popped_.notify_all();
+    return true;
+}
+
+template<typename T, bool MULTI_PRODUCER>
+template<typename U>
+bool LockFreeRingBuffer<T, MULTI_PRODUCER>::push_nb(U&& val, bool force)
+{
+    static_assert(std::is_assignable_v<T&, U&&>, "element has to be assignable to the type of the buffer");
+
+    while (!try_push(std::forward<U>(val)))
+    {
+        if (!force)
+        {
+            return false;
+        }
+
+        // like ConcurrentRingBuffer, only the oldest element is dropped, and only if the buffer is really full.
+        // If a consumer has claimed the slot but not released it yet, the slot becomes free without a drop
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        if (head - tail < capacity_ || !try_pop(nullptr))
+        {
+            std::this_thread::yield();
+        }
+    }
+    return true;
+}
+
+template<typename T, bool MULTI_PRODUCER>
+template<typename U>
+void LockFreeRingBuffer<T, MULTI_PRODUCER>::push(U&& val)
+{
+    static_assert(std::is_assignable_v<T&, U&&>, "element has to be assignable to the type of the buffer");
+
+    for (int spin = 0; true; spin++)
+    {
+        uint32_t seen = popped_.value();
+        if (try_push(std::forward<U>(val)))
+        {
+            return;
+        }
+        if (spin < SPIN_COUNT)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        popped_.wait(seen);
+    }
+}
+
+template<typename T, bool MULTI_PRODUCER>
+bool LockFreeRingBuffer<T, MULTI_PRODUCER>::pop_nb(T* val, uint32_t timeout_ms)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (int spin = 0; true; spin++)
+    {
+        uint32_t seen = pushed_.value();
+        if (try_pop(val))
+        {
+            return true;
+        }
+        if (timeout_ms > 0 && spin < SPIN_COUNT)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::chrono::nanoseconds remaining = deadline - std::chrono::steady_clock::now();
+        if (timeout_ms == 0 || remaining.count() <= 0)
+        {
+            return false;
+        }
+        pushed_.wait(seen, &remaining);
+    }
+}
+
+template<typename T, bool MULTI_PRODUCER>
+void LockFreeRingBuffer<T, MULTI_PRODUCER>::pop(T* val)
+{
+    for (int spin = 0; true; spin++)
+    {
+        uint32_t seen = pushed_.value();
+        if (try_pop(val))
+        {
+            return;
+        }
+        if (spin < SPIN_COUNT)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        pushed_.wait(seen);
+    }
+}
+
+template<typename T, bool MULTI_PRODUCER>
+void LockFreeRingBuffer<T, MULTI_PRODUCER>::clear()
+{
+    while (try_pop(nullptr));
+}
+
+template<typename T, bool MULTI_PRODUCER>
+size_t LockFreeRingBuffer<T, MULTI_PRODUCER>::size() const
+{
+    size_t tail = tail_.load(std::memory_order_acquire);
+    size_t head = head_.load(std::memory_order_acquire);
+    if (head <= tail)
+    {
+        return 0;
+    }
+    return std::min(head - tail, capacity_);
+}
+
+} // namespace fastsense::util
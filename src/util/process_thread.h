@@ -6,8 +6,14 @@
  * @author Malte Hillmann
  */
 
+#include <atomic>
+#include <memory>
 #include <thread>
 
+#include <util/stop_token.h>
+#include <util/thread_pool.h>
+#include <util/thread_settings.h>
+
 namespace fastsense::util
 {
 
@@ -16,7 +22,7 @@ class ProcessThread
 public:
     using UPtr = std::unique_ptr<ProcessThread>;
 
-    ProcessThread() : worker{}, running{false} {}
+    ProcessThread() : worker{}, running{false}, stop_source{}, settings{} {}
 
     virtual ~ProcessThread()
     {
@@ -33,10 +39,14 @@ public:
         if (!running)
         {
             running = true;
+            stop_source = StopSource{};
             worker = std::thread([&]()
             {
+                // the parallel loops of the stage run with its priority in the shared pool
+                ThreadPool::set_priority(settings.pool_priority);
                 this->thread_run();
             });
+            settings.apply(worker);
         }
     }
 
@@ -44,19 +54,48 @@ public:
     {
         if (running && worker.joinable())
         {
-            running = false;
+            request_stop();
             worker.join();
         }
     }
 
+    /**
+     * @brief Set name, CPU affinity, priority and pool priority of the worker thread. Applied by the next start().
+     */
+    void configure(const ThreadSettings& thread_settings)
+    {
+        settings = thread_settings;
+    }
+
 protected:
 
     virtual void thread_run() = 0;
 
+    /**
+     * @brief Clear the running flag and wake up all waits with the stop token of the current run
+     */
+    void request_stop()
+    {
+        running = false;
+        stop_source.request_stop();
+    }
+
+    /**
+     * @brief Token of the current run for cancellable waits, e.g. the blocking pop of a buffer
+     */
+    StopToken stop_token() const
+    {
+        return stop_source.get_token();
+    }
+
     /// Worker thread
     std::thread worker;
     /// Flag if the thread is running
-    bool running;
+    std::atomic<bool> running;
+    /// Requests the stop of the current run, a new one is created by start()
+    StopSource stop_source;
+    /// Name, CPU affinity and priority of the worker thread
+    ThreadSettings settings;
 };
 
 } // namespace fastsense::util
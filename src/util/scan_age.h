@@ -0,0 +1,129 @@
+#pragma once
+
+/**
+ * @file scan_age.h
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include <util/time.h>
+
+namespace fastsense::util
+{
+
+/**
+ * @brief Age of the scans when they reach a stage of the pipeline, measured from their arrival
+ *
+ * The arrival is taken from the steady clock when the scan enters the pipeline, not from the sensor timestamp,
+ * which can be far in the past, e.g. for a replayed recording.
+ *
+ * Collects the mean and the maximum age since the last reset. Only used by the thread of its stage.
+ */
+class ScanAge
+{
+public:
+    /**
+     * @brief Construct a new Scan Age object
+     *
+     * @param name name of the stage in the report
+     */
+    explicit ScanAge(const std::string& name)
+        : name_{name},
+          sum_{0.0},
+          max_{0.0f},
+          count_{0}
+    {
+    }
+
+    /// default destructor
+    ~ScanAge() = default;
+
+    /// delete copy assignment operator
+    ScanAge& operator=(const ScanAge& other) = delete;
+
+    /// delete move assignment operator
+    ScanAge& operator=(ScanAge&&) noexcept = delete;
+
+    /// delete copy constructor
+    ScanAge(const ScanAge&) = delete;
+
+    /// delete move constructor
+    ScanAge(ScanAge&&) = delete;
+
+    /**
+     * @brief Time in ms since the given arrival
+     */
+    static float since(const SteadyTimePoint& arrival, const SteadyTimePoint& now = SteadyTime::now())
+    {
+        return std::chrono::duration<float, std::milli>(now - arrival).count();
+    }
+
+    /**
+     * @brief Add a scan that reached the stage now
+     *
+     * @param arrival arrival time of the scan
+     * @return float age of the scan in ms
+     */
+    float add(const SteadyTimePoint& arrival)
+    {
+        float age = since(arrival);
+        sum_ += age;
+        max_ = std::max(max_, age);
+        count_++;
+        return age;
+    }
+
+    /**
+     * @brief Mean age in ms since the last reset, 0 without scans
+     */
+    float mean() const
+    {
+        return count_ > 0 ? static_cast<float>(sum_ / count_) : 0.0f;
+    }
+
+    /**
+     * @brief Maximum age in ms since the last reset
+     */
+    float max() const
+    {
+        return max_;
+    }
+
+    /**
+     * @brief Number of scans since the last reset
+     */
+    size_t count() const
+    {
+        return count_;
+    }
+
+    /**
+     * @brief Start a new measurement period
+     */
+    void reset()
+    {
+        sum_ = 0.0;
+        max_ = 0.0f;
+        count_ = 0;
+    }
+
+    /**
+     * @brief Mean and maximum age for the log
+     */
+    std::string to_string() const
+    {
+        std::ostringstream out;
+        out << "Scan age at " << name_ << ": " << mean() << " ms (max " << max() << " ms, " << count() << " scans)";
+        return out.str();
+    }
+
+private:
+    std::string name_;
+    double sum_;
+    float max_;
+    size_t count_;
+};
+
+} // namespace fastsense::util
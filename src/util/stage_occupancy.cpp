@@ -0,0 +1,125 @@
+/**
+ * @file stage_occupancy.cpp
+ */
+
+#include <util/stage_occupancy.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace fastsense::util
+{
+
+StageOccupancy::StageOccupancy(const std::string& name)
+    : name_{name},
+      reset_time_{now()},
+      begin_time_{0},
+      busy_{0},
+      items_{0}
+{
+    PipelineOccupancy::get_instance().add(this);
+}
+
+StageOccupancy::~StageOccupancy()
+{
+    PipelineOccupancy::get_instance().remove(this);
+}
+
+int64_t StageOccupancy::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void StageOccupancy::begin()
+{
+    begin_time_ = now();
+}
+
+void StageOccupancy::end(size_t items)
+{
+    // an item that started before a reset only counts from the reset
+    int64_t begin = std::max(begin_time_, reset_time_.load(std::memory_order_relaxed));
+    busy_.fetch_add(std::max<int64_t>(now() - begin, 0), std::memory_order_relaxed);
+    items_.fetch_add(items, std::memory_order_relaxed);
+}
+
+void StageOccupancy::reset()
+{
+    reset_time_.store(now(), std::memory_order_relaxed);
+    busy_.store(0, std::memory_order_relaxed);
+    items_.store(0, std::memory_order_relaxed);
+}
+
+double StageOccupancy::occupancy() const
+{
+    int64_t elapsed = now() - reset_time_.load(std::memory_order_relaxed);
+    if (elapsed <= 0)
+    {
+        return 0.0;
+    }
+    return std::min(1.0, static_cast<double>(busy_.load(std::memory_order_relaxed)) / elapsed);
+}
+
+double StageOccupancy::throughput() const
+{
+    int64_t elapsed = now() - reset_time_.load(std::memory_order_relaxed);
+    if (elapsed <= 0)
+    {
+        return 0.0;
+    }
+    return items_.load(std::memory_order_relaxed) * 1e9 / elapsed;
+}
+
+std::string StageOccupancy::to_string() const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << std::setw(18) << name_ << " | "
+        << std::setw(6) << occupancy() * 100.0 << " % | "
+        << std::setw(8) << std::setprecision(2) << throughput() << " | "
+        << std::setw(8) << items();
+    return out.str();
+}
+
+PipelineOccupancy& PipelineOccupancy::get_instance()
+{
+    static PipelineOccupancy instance;
+    return instance;
+}
+
+void PipelineOccupancy::add(StageOccupancy* stage)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.push_back(stage);
+}
+
+void PipelineOccupancy::remove(StageOccupancy* stage)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.erase(std::remove(stages_.begin(), stages_.end(), stage), stages_.end());
+}
+
+void PipelineOccupancy::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto* stage : stages_)
+    {
+        stage->reset();
+    }
+}
+
+std::string PipelineOccupancy::to_string() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::ostringstream out;
+    out << std::setw(18) << "stage" << " | " << std::setw(8) << "busy" << " | " << std::setw(8) << "items/s" << " | " << std::setw(8) << "items" << "\n";
+    for (const auto* stage : stages_)
+    {
+        out << stage->to_string() << "\n";
+    }
+    return out.str();
+}
+
+} // namespace fastsense::util
@@ -0,0 +1,169 @@
+#pragma once
+
+/**
+ * @file stage_occupancy.h
+ */
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fastsense::util
+{
+
+/**
+ * @brief Measures how busy one stage of the processing pipeline is and how many items it processes.
+ *
+ * The stage thread calls begin() when it has an item and end() when the item is done, the time in between
+ * is busy time. The occupancy is the busy time relative to the time since the last reset, so a stage with
+ * an occupancy close to 100% limits the throughput of the pipeline.
+ * The measurements can be read from any thread.
+ */
+class StageOccupancy
+{
+public:
+    /**
+     * @brief Construct a new Stage Occupancy object and add it to the PipelineOccupancy report
+     *
+     * @param name name of the stage in the report
+     */
+    explicit StageOccupancy(const std::string& name);
+
+    /// remove the stage from the PipelineOccupancy report
+    ~StageOccupancy();
+
+    /// delete copy assignment operator
+    StageOccupancy& operator=(const StageOccupancy& other) = delete;
+
+    /// delete move assignment operator
+    StageOccupancy& operator=(StageOccupancy&&) noexcept = delete;
+
+    /// delete copy constructor
+    StageOccupancy(const StageOccupancy&) = delete;
+
+    /// delete move constructor
+    StageOccupancy(StageOccupancy&&) = delete;
+
+    /**
+     * @brief The stage starts to process an item
+     */
+    void begin();
+
+    /**
+     * @brief The stage finished the items since begin()
+     *
+     * @param items number of processed items, e.g. the scans of a batch
+     */
+    void end(size_t items = 1);
+
+    /**
+     * @brief Restart the measurement, e.g. when the pipeline is started
+     */
+    void reset();
+
+    /**
+     * @brief Busy time relative to the time since the last reset, from 0 to 1
+     */
+    double occupancy() const;
+
+    /**
+     * @brief Processed items per second since the last reset
+     */
+    double throughput() const;
+
+    /**
+     * @brief Number of processed items since the last reset
+     */
+    size_t items() const
+    {
+        return items_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Name of the stage
+     */
+    const std::string& name() const
+    {
+        return name_;
+    }
+
+    /**
+     * @brief One line of the report: name, occupancy, throughput and items
+     */
+    std::string to_string() const;
+
+private:
+    /// Nanoseconds of the steady clock
+    static int64_t now();
+
+    /// Name of the stage
+    std::string name_;
+    /// Start of the measurement
+    std::atomic<int64_t> reset_time_;
+    /// Start of the current item, only used by the stage thread
+    int64_t begin_time_;
+    /// Accumulated busy time in ns
+    std::atomic<int64_t> busy_;
+    /// Processed items
+    std::atomic<size_t> items_;
+};
+
+/**
+ * @brief Report of the occupancy of all stages of the pipeline
+ *
+ * Every StageOccupancy adds itself while it exists. Implemented as a singleton like the RuntimeEvaluator.
+ */
+class PipelineOccupancy
+{
+public:
+    /**
+     * @brief Returns the singleton instance
+     */
+    static PipelineOccupancy& get_instance();
+
+    /// default destructor
+    ~PipelineOccupancy() = default;
+
+    /// delete copy assignment operator
+    PipelineOccupancy& operator=(const PipelineOccupancy& other) = delete;
+
+    /// delete move assignment operator
+    PipelineOccupancy& operator=(PipelineOccupancy&&) noexcept = delete;
+
+    /// delete copy constructor
+    PipelineOccupancy(const PipelineOccupancy&) = delete;
+
+    /// delete move constructor
+    PipelineOccupancy(PipelineOccupancy&&) = delete;
+
+    /**
+     * @brief Restart the measurements of all stages
+     */
+    void reset();
+
+    /**
+     * @brief Table with the occupancy and throughput of every stage, in the order the stages were created
+     */
+    std::string to_string() const;
+
+private:
+    friend class StageOccupancy;
+
+    /// construct an empty report
+    PipelineOccupancy() = default;
+
+    /// Add a stage to the report
+    void add(StageOccupancy* stage);
+
+    /// Remove a stage from the report
+    void remove(StageOccupancy* stage);
+
+    /// Protects the stages
+    mutable std::mutex mutex_;
+    /// The stages that currently exist
+    std::vector<StageOccupancy*> stages_;
+};
+
+} // namespace fastsense::util
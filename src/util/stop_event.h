@@ -0,0 +1,85 @@
+#pragma once
+
+/**
+ * @file stop_event.h
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+namespace fastsense::util
+{
+
+/**
+ * @brief An eventfd that becomes readable when it is signalled, so waits in poll() can be cancelled.
+ *
+ * A thread that blocks in poll() on a socket adds the descriptor to its poll set and signals the event
+ * from a StopCallback, so it needs no timeout to notice a stop.
+ */
+class StopEvent
+{
+public:
+    /// create the eventfd, not signalled
+    StopEvent() : fd_{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}
+    {
+        if (fd_ < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "failed to create eventfd");
+        }
+    }
+
+    /// close the eventfd
+    ~StopEvent()
+    {
+        close(fd_);
+    }
+
+    /// delete copy assignment operator
+    StopEvent& operator=(const StopEvent& other) = delete;
+
+    /// delete move assignment operator
+    StopEvent& operator=(StopEvent&&) noexcept = delete;
+
+    /// delete copy constructor
+    StopEvent(const StopEvent&) = delete;
+
+    /// delete move constructor
+    StopEvent(StopEvent&&) = delete;
+
+    /**
+     * @brief Descriptor to poll for POLLIN
+     */
+    int fd() const
+    {
+        return fd_;
+    }
+
+    /**
+     * @brief Make the descriptor readable until the next reset()
+     */
+    void signal()
+    {
+        uint64_t one = 1;
+        // only fails if the counter overflows, and then the descriptor is readable anyway
+        [[maybe_unused]] auto written = write(fd_, &one, sizeof(one));
+    }
+
+    /**
+     * @brief Clear the signal, e.g. before the next run of a thread
+     */
+    void reset()
+    {
+        uint64_t count;
+        // fails with EAGAIN if the event was not signalled
+        [[maybe_unused]] auto read_bytes = read(fd_, &count, sizeof(count));
+    }
+
+private:
+    /// eventfd descriptor
+    int fd_;
+};
+
+} // namespace fastsense::util
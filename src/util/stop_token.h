@@ -0,0 +1,325 @@
+#pragma once
+
+/**
+ * @file stop_token.h
+ */
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace fastsense::util
+{
+
+class StopCallbackBase;
+
+/**
+ * @brief Shared state of a StopSource and its StopTokens
+ *
+ */
+class StopState
+{
+public:
+    /// default constructor
+    StopState() : stop_requested_{false}, mutex_{}, callbacks_{nullptr}
+    {
+    }
+
+    /// default destructor
+    ~StopState() = default;
+
+    /// delete copy assignment operator
+    StopState& operator=(const StopState& other) = delete;
+
+    /// delete move assignment operator
+    StopState& operator=(StopState&&) noexcept = delete;
+
+    /// delete copy constructor
+    StopState(const StopState&) = delete;
+
+    /// delete move constructor
+    StopState(StopState&&) = delete;
+
+    /// Whether the stop was requested
+    bool stop_requested() const
+    {
+        return stop_requested_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Set the stop flag and invoke all registered callbacks
+     *
+     * @return true if this call requested the stop, false if it was already requested
+     */
+    bool request_stop();
+
+    /**
+     * @brief Register the callback, or invoke it right away if the stop was already requested
+     */
+    void add(StopCallbackBase* callback);
+
+    /**
+     * @brief Unregister the callback. Waits until a running invocation of it is finished.
+     */
+    void remove(StopCallbackBase* callback);
+
+private:
+    /// Flag if the stop was requested
+    std::atomic<bool> stop_requested_;
+    /// Protects the list of callbacks, held during their invocation
+    std::mutex mutex_;
+    /// First registered callback
+    StopCallbackBase* callbacks_;
+};
+
+/**
+ * @brief Read-only view of a stop request, handed to the functions that should be cancellable.
+ *
+ * A default constructed token is never stopped.
+ */
+class StopToken
+{
+public:
+    /// default constructor: a token that is never stopped
+    StopToken() = default;
+
+    /// the token of a StopSource
+    explicit StopToken(std::shared_ptr<StopState> state) : state_{std::move(state)}
+    {
+    }
+
+    /**
+     * @brief Whether the stop was requested
+     */
+    bool stop_requested() const
+    {
+        return state_ && state_->stop_requested();
+    }
+
+    /**
+     * @brief Whether the token belongs to a StopSource and can be stopped at all
+     */
+    bool stop_possible() const
+    {
+        return state_ != nullptr;
+    }
+
+private:
+    friend class StopCallbackBase;
+
+    /// Shared state, nullptr if the token is never stopped
+    std::shared_ptr<StopState> state_;
+};
+
+/**
+ * @brief Requests a stop from all StopTokens that were taken from it.
+ *
+ * Functions that block with a token register a StopCallback that wakes them up, so a stop does not have
+ * to wait for a timeout. A source can only be stopped once, a new run needs a new source.
+ */
+class StopSource
+{
+public:
+    /// construct a source that is not stopped
+    StopSource() : state_{std::make_shared<StopState>()}
+    {
+    }
+
+    /**
+     * @brief Token to pass to the cancellable functions
+     */
+    StopToken get_token() const
+    {
+        return StopToken{state_};
+    }
+
+    /**
+     * @brief Request the stop and wake up all functions that wait with a token of this source
+     *
+     * @return true if this call requested the stop, false if it was already requested
+     */
+    bool request_stop()
+    {
+        return state_->request_stop();
+    }
+
+    /**
+     * @brief Whether the stop was requested
+     */
+    bool stop_requested() const
+    {
+        return state_->stop_requested();
+    }
+
+private:
+    /// Shared state with the tokens
+    std::shared_ptr<StopState> state_;
+};
+
+/**
+ * @brief Node of the callback list of a StopState
+ *
+ */
+class StopCallbackBase
+{
+public:
+    /// delete copy assignment operator
+    StopCallbackBase& operator=(const StopCallbackBase& other) = delete;
+
+    /// delete move assignment operator
+    StopCallbackBase& operator=(StopCallbackBase&&) noexcept = delete;
+
+    /// delete copy constructor
+    StopCallbackBase(const StopCallbackBase&) = delete;
+
+    /// delete move constructor
+    StopCallbackBase(StopCallbackBase&&) = delete;
+
+protected:
+    /// construct an unregistered node
+    StopCallbackBase() : prev_{nullptr}, next_{nullptr}, state_{}
+    {
+    }
+
+    /// default destructor
+    virtual ~StopCallbackBase() = default;
+
+    /// Register at the state of the token, if it has one
+    void attach(const StopToken& token)
+    {
+        state_ = token.state_;
+        if (state_)
+        {
+            state_->add(this);
+        }
+    }
+
+    /// Unregister from the state
+    void detach()
+    {
+        if (state_)
+        {
+            state_->remove(this);
+        }
+    }
+
+    /// Called when the stop is requested
+    virtual void invoke() = 0;
+
+private:
+    friend class StopState;
+
+    /// Previous node of the list
+    StopCallbackBase* prev_;
+    /// Next node of the list
+    StopCallbackBase* next_;
+    /// State the callback is registered at
+    std::shared_ptr<StopState> state_;
+};
+
+/**
+ * @brief Invokes a function when the stop of the token is requested, as long as the callback exists.
+ *
+ * Waits that can be cancelled register a callback that wakes them up. The callback is invoked
+ * immediately if the stop was already requested. Registering does not allocate memory.
+ *
+ * @tparam FUNC type of the function
+ */
+template<typename FUNC>
+class StopCallback : public StopCallbackBase
+{
+public:
+    /**
+     * @brief Register the function at the token.
+     *
+     * The function must not lock a mutex that is held while the callback is destroyed.
+     *
+     * @param token token to watch
+     * @param func function to invoke on the stop
+     */
+    StopCallback(const StopToken& token, FUNC func) : func_{std::move(func)}
+    {
+        attach(token);
+    }
+
+    /// unregister the function, waits if it is being invoked
+    ~StopCallback() override
+    {
+        detach();
+    }
+
+    /// delete copy assignment operator
+    StopCallback& operator=(const StopCallback& other) = delete;
+
+    /// delete move assignment operator
+    StopCallback& operator=(StopCallback&&) noexcept = delete;
+
+    /// delete copy constructor
+    StopCallback(const StopCallback&) = delete;
+
+    /// delete move constructor
+    StopCallback(StopCallback&&) = delete;
+
+private:
+    void invoke() override
+    {
+        func_();
+    }
+
+    /// Function to invoke
+    FUNC func_;
+};
+
+inline bool StopState::request_stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_requested_.exchange(true, std::memory_order_acq_rel))
+    {
+        return false;
+    }
+
+    for (auto* callback = callbacks_; callback != nullptr; callback = callback->next_)
+    {
+        callback->invoke();
+    }
+    return true;
+}
+
+inline void StopState::add(StopCallbackBase* callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_requested_.load(std::memory_order_acquire))
+    {
+        callback->invoke();
+        return;
+    }
+
+    callback->prev_ = nullptr;
+    callback->next_ = callbacks_;
+    if (callbacks_ != nullptr)
+    {
+        callbacks_->prev_ = callback;
+    }
+    callbacks_ = callback;
+}
+
+inline void StopState::remove(StopCallbackBase* callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (callback->prev_ != nullptr)
+    {
+        callback->prev_->next_ = callback->next_;
+    }
+    else if (callbacks_ == callback)
+    {
+        callbacks_ = callback->next_;
+    }
+    if (callback->next_ != nullptr)
+    {
+        callback->next_->prev_ = callback->prev_;
+    }
+    callback->prev_ = nullptr;
+    callback->next_ = nullptr;
+}
+
+} // namespace fastsense::util
@@ -0,0 +1,298 @@
+/**
+ * @file thread_pool.cpp
+ */
+
+#include <util/thread_pool.h>
+
+#include <pthread.h>
+
+namespace fastsense::util
+{
+
+/// Priority of the loops started by the current thread
+static thread_local int current_priority = 0;
+
+/// SCHED_FIFO or SCHED_RR priority of the current thread, 0 for the other policies
+static int rt_priority()
+{
+    int policy;
+    sched_param param{};
+    if (pthread_getschedparam(pthread_self(), &policy, &param) != 0 || (policy != SCHED_FIFO && policy != SCHED_RR))
+    {
+        return 0;
+    }
+    return param.sched_priority;
+}
+
+ThreadPool& ThreadPool::get_instance()
+{
+    static ThreadPool instance;
+    return instance;
+}
+
+ThreadPool::ThreadPool()
+    : workers_{},
+      wake_{},
+      stopping_{false},
+      next_worker_{0},
+      steals_{0},
+      done_mutex_{},
+      done_cv_{}
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+    stop();
+}
+
+void ThreadPool::set_priority(int priority)
+{
+    current_priority = priority;
+}
+
+int ThreadPool::priority()
+{
+    return current_priority;
+}
+
+void ThreadPool::configure(size_t workers, const ThreadSettings& settings)
+{
+    stop();
+
+    stopping_ = false;
+    for (size_t i = 0; i < workers; i++)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < workers; i++)
+    {
+        workers_[i]->thread = std::thread([this, i]()
+        {
+            worker_run(i);
+        });
+
+        ThreadSettings worker_settings = settings;
+        if (!worker_settings.name.empty())
+        {
+            worker_settings.name += std::to_string(i);
+        }
+        worker_settings.apply(workers_[i]->thread);
+    }
+}
+
+void ThreadPool::stop()
+{
+    stopping_ = true;
+    wake_.notify_all();
+    for (auto& worker : workers_)
+    {
+        if (worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+    workers_.clear();
+}
+
+void ThreadPool::run(size_t begin, size_t end, size_t grain, void (*body)(void*, size_t, size_t), void* context)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    size_t n = end - begin;
+    size_t target_chunks = concurrency() * CHUNKS_PER_THREAD;
+    size_t chunk = std::max<size_t>({grain, 1, (n + target_chunks - 1) / target_chunks});
+    size_t chunks = (n + chunk - 1) / chunk;
+    if (workers_.empty() || chunks == 1)
+    {
+        body(context, begin, end);
+        return;
+    }
+
+    Job job;
+    job.body = body;
+    job.context = context;
+    job.end = end;
+    job.chunk = chunk;
+    job.priority = current_priority;
+    job.rt_priority = rt_priority();
+    job.next = begin;
+    job.helpers = 0;
+    job.failed = false;
+
+    // the calling thread takes one chunk itself, every other chunk can get a helper
+    size_t tickets = std::min(workers_.size(), chunks - 1);
+    size_t first = next_worker_.fetch_add(tickets, std::memory_order_relaxed);
+    for (size_t i = 0; i < tickets; i++)
+    {
+        auto& worker = *workers_[(first + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tickets.push_back(&job);
+    }
+    wake_.notify_all();
+
+    execute(job);
+
+    // tickets that were not taken yet are not needed anymore
+    for (auto& worker : workers_)
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->tickets.erase(std::remove(worker->tickets.begin(), worker->tickets.end(), &job), worker->tickets.end());
+    }
+
+    {
+        // the job lives on this stack, so every helper has to be done with it
+        std::unique_lock<std::mutex> lock(done_mutex_);
+        done_cv_.wait(lock, [&]()
+        {
+            return job.helpers.load() == 0;
+        });
+    }
+
+    if (job.error)
+    {
+        std::rethrow_exception(job.error);
+    }
+}
+
+void ThreadPool::execute(Job& job)
+{
+    while (!job.failed.load(std::memory_order_relaxed))
+    {
+        size_t first = job.next.fetch_add(job.chunk);
+        if (first >= job.end)
+        {
+            break;
+        }
+
+        try
+        {
+            job.body(job.context, first, std::min(first + job.chunk, job.end));
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(done_mutex_);
+            if (!job.error)
+            {
+                job.error = std::current_exception();
+            }
+            job.failed = true;
+        }
+    }
+}
+
+ThreadPool::Job* ThreadPool::pop(Worker& worker)
+{
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tickets.empty())
+    {
+        return nullptr;
+    }
+
+    // the oldest ticket wins ties
+    auto best = worker.tickets.begin();
+    for (auto it = worker.tickets.begin(); it != worker.tickets.end(); ++it)
+    {
+        if ((*it)->priority > (*best)->priority)
+        {
+            best = it;
+        }
+    }
+
+    Job* job = *best;
+    worker.tickets.erase(best);
+    // counted while the ticket is protected, so the owner of the job waits for this helper
+    job->helpers++;
+    return job;
+}
+
+ThreadPool::Job* ThreadPool::take(size_t self)
+{
+    while (true)
+    {
+        size_t best_worker = 0;
+        int best_priority = 0;
+        bool found = false;
+
+        for (size_t i = 0; i < workers_.size(); i++)
+        {
+            size_t index = (self + i) % workers_.size();
+            auto& worker = *workers_[index];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            for (const Job* job : worker.tickets)
+            {
+                if (!found || job->priority > best_priority)
+                {
+                    found = true;
+                    best_priority = job->priority;
+                    best_worker = index;
+                }
+            }
+        }
+
+        if (!found)
+        {
+            return nullptr;
+        }
+
+        // the ticket might have been taken in the meantime, then look again
+        Job* job = pop(*workers_[best_worker]);
+        if (job != nullptr)
+        {
+            if (best_worker != self)
+            {
+                steals_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+    }
+}
+
+void ThreadPool::worker_run(size_t self)
+{
+    while (!stopping_)
+    {
+        uint32_t wake = wake_.value();
+        Job* job = take(self);
+        if (job == nullptr)
+        {
+            if (!stopping_)
+            {
+                wake_.wait(wake);
+            }
+            continue;
+        }
+
+        // loops started by the body run with the priority of the job
+        current_priority = job->priority;
+
+        // the caller waits for this worker, so the worker must not run below the caller's real-time priority
+        int policy;
+        sched_param base{};
+        bool boosted = false;
+        if (job->rt_priority > 0 && pthread_getschedparam(pthread_self(), &policy, &base) == 0 && base.sched_priority < job->rt_priority)
+        {
+            sched_param param{};
+            param.sched_priority = job->rt_priority;
+            boosted = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+        }
+
+        execute(*job);
+
+        if (boosted)
+        {
+            pthread_setschedparam(pthread_self(), policy, &base);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(done_mutex_);
+            job->helpers--;
+        }
+        done_cv_.notify_all();
+    }
+}
+
+} // namespace fastsense::util
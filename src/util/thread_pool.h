@@ -0,0 +1,215 @@
+#pragma once
+
+/**
+ * @file thread_pool.h
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <util/futex.h>
+#include <util/thread_settings.h>
+
+namespace fastsense::util
+{
+
+/**
+ * @brief Worker threads shared by all parallel loops of the pipeline
+ *
+ * A loop is split into chunks that are claimed one after another, so fast threads take more chunks than slow ones.
+ * The thread that starts the loop always works on it, the workers join through tickets in their deques.
+ * An idle worker takes the ticket with the highest priority, from its own deque or stolen from another one.
+ * The priority of a loop is the priority of the stage (thread) that starts it, see set_priority().
+ * A worker runs a chunk with the real-time priority of the starting thread if that is higher than its own,
+ * so a thread with a priority in between cannot keep the worker and thereby the waiting caller off the CPU.
+ *
+ * Without workers, every loop runs on the calling thread. The pool is a singleton, so the pipeline threads
+ * share a fixed number of workers instead of creating their own threads for every loop.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Returns the singleton instance, without workers until configure() is called
+     */
+    static ThreadPool& get_instance();
+
+    /**
+     * @brief Stops the workers
+     */
+    ~ThreadPool();
+
+    /// delete copy assignment operator
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    /// delete move assignment operator
+    ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+    /// delete copy constructor
+    ThreadPool(const ThreadPool&) = delete;
+
+    /// delete move constructor
+    ThreadPool(ThreadPool&&) = delete;
+
+    /**
+     * @brief Replace the workers. Must not be called while a loop is running
+     *
+     * @param workers number of worker threads. 0 runs every loop on the calling thread
+     * @param settings name, CPU affinity and scheduling of the workers. The name gets the index of the worker appended
+     */
+    void configure(size_t workers, const ThreadSettings& settings = ThreadSettings{});
+
+    /**
+     * @brief Number of worker threads
+     */
+    size_t workers() const
+    {
+        return workers_.size();
+    }
+
+    /**
+     * @brief Number of threads that work on a loop: the workers and the calling thread
+     */
+    size_t concurrency() const
+    {
+        return workers_.size() + 1;
+    }
+
+    /**
+     * @brief Number of tickets that a worker took from the deque of another worker
+     */
+    size_t steals() const
+    {
+        return steals_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Set the priority of the loops that are started by the calling thread. Higher priorities run first
+     */
+    static void set_priority(int priority);
+
+    /**
+     * @brief Priority of the loops that are started by the calling thread
+     */
+    static int priority();
+
+    /**
+     * @brief Call f(i) for every i in [begin, end) on the calling thread and the workers. Returns when all calls are done
+     *
+     * f is called concurrently and has to be safe for that. The first exception thrown by f stops the loop
+     * and is rethrown by this function.
+     *
+     * @param begin first index
+     * @param end index after the last one
+     * @param f function with the signature void(size_t i)
+     * @param grain minimum number of indices of a chunk
+     */
+    template<typename F>
+    void parallel_for(size_t begin, size_t end, F&& f, size_t grain = 1)
+    {
+        using Function = std::remove_reference_t<F>;
+        auto body = [](void* context, size_t first, size_t last)
+        {
+            Function& function = *static_cast<Function*>(context);
+            for (size_t i = first; i < last; i++)
+            {
+                function(i);
+            }
+        };
+        run(begin, end, grain, body, const_cast<void*>(static_cast<const void*>(std::addressof(f))));
+    }
+
+private:
+    /// Chunks per thread, so that the threads finish at about the same time
+    static constexpr size_t CHUNKS_PER_THREAD = 4;
+
+    /// One parallel loop, owned by the calling thread
+    struct Job
+    {
+        /// Processes the indices [first, last) of the loop
+        void (*body)(void* context, size_t first, size_t last);
+        /// Function of the loop
+        void* context;
+        /// Index after the last one
+        size_t end;
+        /// Number of indices of a chunk
+        size_t chunk;
+        /// Priority of the calling thread
+        int priority;
+        /// SCHED_FIFO priority of the calling thread, 0 without real-time scheduling
+        int rt_priority;
+        /// First index of the next chunk
+        std::atomic<size_t> next;
+        /// Number of workers that took a ticket of the job and did not finish it
+        std::atomic<size_t> helpers;
+        /// Set by the first exception, stops the loop
+        std::atomic<bool> failed;
+        /// The first exception
+        std::exception_ptr error;
+    };
+
+    /// A worker thread and the tickets of the jobs it should help with
+    struct Worker
+    {
+        std::thread thread;
+        std::mutex mutex;
+        std::deque<Job*> tickets;
+    };
+
+    /// Constructor of the singleton
+    ThreadPool();
+
+    /**
+     * @brief Run a loop with a type erased body
+     */
+    void run(size_t begin, size_t end, size_t grain, void (*body)(void*, size_t, size_t), void* context);
+
+    /**
+     * @brief Process chunks of the job until all are claimed
+     */
+    void execute(Job& job);
+
+    /**
+     * @brief Take the ticket with the highest priority of all deques, the own deque wins ties
+     *
+     * @param self index of the calling worker
+     * @return Job* the job, nullptr if there are no tickets
+     */
+    Job* take(size_t self);
+
+    /**
+     * @brief Remove the ticket with the highest priority from the deque of a worker
+     */
+    Job* pop(Worker& worker);
+
+    /**
+     * @brief Main loop of a worker
+     */
+    void worker_run(size_t self);
+
+    /**
+     * @brief Stop and join all workers
+     */
+    void stop();
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    /// Wakes up the workers when tickets are added or the pool stops
+    Futex wake_;
+    std::atomic<bool> stopping_;
+    /// Worker that gets the first ticket of the next job
+    std::atomic<size_t> next_worker_;
+    std::atomic<size_t> steals_;
+    /// Protects the error of a job and the end of a ticket
+    std::mutex done_mutex_;
+    std::condition_variable done_cv_;
+};
+
+} // namespace fastsense::util
@@ -0,0 +1,166 @@
+/**
+ * @file thread_settings.cpp
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <util/thread_settings.h>
+#include <util/logging/logger.h>
+
+using namespace fastsense::util::logging;
+
+namespace fastsense::util
+{
+
+/// Linux limits thread names to 16 bytes including the terminating zero
+constexpr size_t MAX_THREAD_NAME = 15;
+
+/**
+ * @brief Parse one CPU number of a CPU list
+ */
+static int parse_cpu(const std::string& text, const std::string& list)
+{
+    size_t end = 0;
+    int cpu = -1;
+    try
+    {
+        cpu = std::stoi(text, &end);
+    }
+    catch (const std::exception&)
+    {
+        end = 0;
+    }
+
+    if (text.empty() || end != text.size() || cpu < 0 || cpu >= CPU_SETSIZE)
+    {
+        throw std::runtime_error("invalid CPU list '" + list + "'");
+    }
+    return cpu;
+}
+
+/**
+ * @brief Format CPU numbers as a list of ranges, e.g. "0,2-3"
+ */
+static std::string format_cpus(const cpu_set_t& set)
+{
+    std::ostringstream out;
+    int first = -1;
+    for (int cpu = 0; cpu <= CPU_SETSIZE; cpu++)
+    {
+        bool in_set = cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set);
+        if (in_set && first < 0)
+        {
+            first = cpu;
+        }
+        else if (!in_set && first >= 0)
+        {
+            out << (out.tellp() > 0 ? "," : "") << first;
+            if (cpu - 1 > first)
+            {
+                out << "-" << cpu - 1;
+            }
+            first = -1;
+        }
+    }
+    return out.str();
+}
+
+ThreadSettings ThreadSettings::parse(const std::string& name, const std::string& cpus, int priority, int pool_priority)
+{
+    ThreadSettings settings;
+    settings.name = name.substr(0, MAX_THREAD_NAME);
+
+    std::istringstream list(cpus);
+    std::string range;
+    while (std::getline(list, range, ','))
+    {
+        size_t dash = range.find('-');
+        int first = parse_cpu(range.substr(0, dash), cpus);
+        int last = dash == std::string::npos ? first : parse_cpu(range.substr(dash + 1), cpus);
+        if (last < first)
+        {
+            throw std::runtime_error("invalid CPU list '" + cpus + "'");
+        }
+        for (int cpu = first; cpu <= last; cpu++)
+        {
+            settings.cpus.push_back(cpu);
+        }
+    }
+
+    if (priority < 0 || priority > sched_get_priority_max(SCHED_FIFO))
+    {
+        throw std::runtime_error("invalid SCHED_FIFO priority " + std::to_string(priority) + " of thread '" + name + "'");
+    }
+    settings.priority = priority;
+    settings.pool_priority = pool_priority;
+
+    return settings;
+}
+
+void ThreadSettings::apply(std::thread& thread) const
+{
+    pthread_t handle = thread.native_handle();
+
+    if (!name.empty())
+    {
+        int error = pthread_setname_np(handle, name.c_str());
+        if (error != 0)
+        {
+            Logger::warning("Cannot name thread '", name, "': ", std::strerror(error));
+        }
+    }
+
+    char thread_name[MAX_THREAD_NAME + 1] = "";
+    pthread_getname_np(handle, thread_name, sizeof(thread_name));
+
+    if (!cpus.empty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+        {
+            CPU_SET(cpu, &set);
+        }
+
+        int error = pthread_setaffinity_np(handle, sizeof(set), &set);
+        if (error != 0)
+        {
+            Logger::warning("Cannot pin thread '", thread_name, "' to CPUs ", format_cpus(set), ": ", std::strerror(error));
+        }
+    }
+
+    if (priority > 0)
+    {
+        sched_param param{};
+        param.sched_priority = priority;
+        int error = pthread_setschedparam(handle, SCHED_FIFO, &param);
+        if (error != 0)
+        {
+            Logger::warning("Cannot set SCHED_FIFO priority ", priority, " of thread '", thread_name, "': ", std::strerror(error));
+        }
+    }
+
+    // log what the system actually applied
+    cpu_set_t actual;
+    CPU_ZERO(&actual);
+    pthread_getaffinity_np(handle, sizeof(actual), &actual);
+
+    int policy = SCHED_OTHER;
+    sched_param param{};
+    pthread_getschedparam(handle, &policy, &param);
+
+    if (policy == SCHED_FIFO)
+    {
+        Logger::info("Thread '", thread_name, "' runs on CPUs ", format_cpus(actual), " with SCHED_FIFO priority ", param.sched_priority);
+    }
+    else
+    {
+        Logger::info("Thread '", thread_name, "' runs on CPUs ", format_cpus(actual), " with default scheduling");
+    }
+}
+
+} // namespace fastsense::util
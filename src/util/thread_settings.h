@@ -0,0 +1,54 @@
+#pragma once
+
+/**
+ * @file thread_settings.h
+ */
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fastsense::util
+{
+
+/**
+ * @brief Placement and scheduling of a thread: name, CPU affinity, real-time priority and the priority of its
+ * parallel loops in the ThreadPool
+ *
+ * The default settings leave a thread as it was created: unnamed, on all cores and with the default scheduling.
+ */
+struct ThreadSettings
+{
+    /**
+     * @brief Create settings from their textual form in the configuration
+     *
+     * @param name name of the thread, cut to 15 characters
+     * @param cpus list of CPU cores like "0", "0,2" or "1-3". Empty allows all cores
+     * @param priority SCHED_FIFO priority from 1 to 99. 0 keeps the default scheduling
+     * @param pool_priority priority of the parallel loops of the thread in the ThreadPool, higher runs first
+     * @return ThreadSettings the parsed settings
+     * @throw std::runtime_error if the CPU list or the priority is invalid
+     */
+    static ThreadSettings parse(const std::string& name, const std::string& cpus, int priority, int pool_priority = 0);
+
+    /**
+     * @brief Apply the settings to a running thread and log where and how it runs afterwards.
+     *
+     * Settings that the system rejects, e.g. a real-time priority without the permission for it,
+     * are logged as warnings; the thread keeps running with its previous settings.
+     *
+     * @param thread the thread to configure
+     */
+    void apply(std::thread& thread) const;
+
+    /// Name of the thread, empty keeps the name
+    std::string name;
+    /// CPU cores the thread may run on, empty allows all cores
+    std::vector<int> cpus;
+    /// SCHED_FIFO priority, 0 keeps the default scheduling
+    int priority = 0;
+    /// Priority of the parallel loops of the thread in the ThreadPool. Set by the thread itself, see ProcessThread
+    int pool_priority = 0;
+};
+
+} // namespace fastsense::util
@@ -8,9 +8,21 @@ namespace fastsense::util
 using HighResTime = std::chrono::high_resolution_clock;
 using HighResTimePoint = HighResTime::time_point;
 
+/// Monotonic clock for durations inside the pipeline, independent of sensor or replayed timestamps
+using SteadyTime = std::chrono::steady_clock;
+using SteadyTimePoint = SteadyTime::time_point;
+
 namespace time
 {
 using secs_double = std::chrono::duration<double>;
 }
 
+/**
+ * @brief Convert a time of the system clock, e.g. a kernel or capture timestamp, to HighResTime
+ */
+inline HighResTimePoint to_high_res_time(const std::chrono::system_clock::time_point& time)
+{
+    return HighResTime::now() - std::chrono::duration_cast<HighResTime::duration>(std::chrono::system_clock::now() - time);
+}
+
 } // namespace time
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+ * @file alloc_counter.h
+ *
+ * Counts the heap allocations of the test program, for tests that check that a code path does not allocate.
+ * alloc_counter.cpp replaces every form of the global operator new and delete of the test executable.
+ */
+
+#include <cstddef>
+
+namespace fastsense::test
+{
+
+/**
+ * @brief Number of heap allocations of all threads since the start of the test program
+ */
+size_t heap_allocations();
+
+} // namespace fastsense::test
@@ -16,6 +16,7 @@
 #include <msg/transform.h>
 #include <msg/point_cloud.h>
 #include <msg/tsdf.h>
+#include <msg/registration_stats.h>
 #include <iostream>
 #include <thread>
 
@@ -423,7 +424,7 @@ TEST_CASE("ImuStamped Sender Receiver Test", "[communication]")
 
      std::thread receive_thread{[&]()
      {
-         BufferedImuStampedReceiver receiver{"127.0.0.1", 1544, 20ms, buffer};
+         BufferedImuStampedReceiver receiver{"127.0.0.1", 1544, buffer};
 
          while (n_msgs != buffer->size())
          {
@@ -518,7 +519,7 @@ TEST_CASE("ImuStamped Sender Receiver Test", "[communication]")
 
       std::thread receive_thread{[&]()
       {
-          BufferedPclStampedReceiver receiver{"127.0.0.1", 1257, 20ms, buffer};
+          BufferedPclStampedReceiver receiver{"127.0.0.1", 1257, buffer};
 
           while (n_msgs != buffer->size())
           {
@@ -644,4 +645,62 @@ TEST_CASE("Stamped<msg::Transform> Sender Receiver Test", "[communication]")
         REQUIRE(value_received.data_.scaling == 0.5f);
         REQUIRE(value_to_send.timestamp_ == value_received.timestamp_);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("RegistrationStatsStamped Sender Receiver Test", "[communication]")
+{
+    std::cout << "Testing 'RegistrationStatsStamped Sender Receiver Test'" << std::endl;
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        bool received = false;
+
+        auto tp = util::HighResTime::now();
+        RegistrationStats stats;
+        stats.iterations_ = 3;
+        stats.max_iterations_ = 3;
+        stats.cap_hit_ = true;
+        stats.num_points_ = 6000;
+        stats.num_hits_ = 5800;
+        stats.set_condition(Eigen::Matrix<double, 6, 6>::Identity() * 2.0);
+        stats.point_time_ = 4.5f;
+        stats.solve_time_ = 0.25f;
+        stats.errors_ = {30.0f, 20.0f, 15.0f};
+
+        RegistrationStatsStamped value_to_send{std::move(stats), tp};
+        RegistrationStatsStamped value_received;
+
+        std::thread receive_thread{[&]()
+        {
+            Receiver<RegistrationStatsStamped> receiver{"127.0.0.1", 2281, 20ms};
+
+            while (!received)
+            {
+                received = receiver.receive(value_received);
+            }
+        }};
+
+        std::thread send_thread{[&]()
+        {
+            Sender<RegistrationStatsStamped> sender{2281};
+            SLEEP(500ms);
+            sender.send(value_to_send);
+            SLEEP(500ms);
+        }};
+
+        receive_thread.join();
+        send_thread.join();
+
+        const auto& sent = value_to_send.data_;
+        const auto& got = value_received.data_;
+        REQUIRE(got.iterations_ == sent.iterations_);
+        REQUIRE(got.max_iterations_ == sent.max_iterations_);
+        REQUIRE(got.cap_hit_ == sent.cap_hit_);
+        REQUIRE(got.num_points_ == sent.num_points_);
+        REQUIRE(got.num_hits_ == sent.num_hits_);
+        REQUIRE(got.condition_ == Approx(1.0f));
+        REQUIRE(got.point_time_ == sent.point_time_);
+        REQUIRE(got.solve_time_ == sent.solve_time_);
+        REQUIRE(got.errors_ == sent.errors_);
+        REQUIRE(value_to_send.timestamp_ == value_received.timestamp_);
+    }
+}
@@ -37,9 +37,11 @@ TEST_CASE("ConcRingBuffer", "[ConcRingBuffer]")
     {
         std::cout << "    Section 'Test push_nb, pop, and pop_nb'" << std::endl;
 
-        // test push_nb, pop
+        // test push_nb, pop. Only the forced push deletes an element
         REQUIRE(!crb.push_nb(0));
+        REQUIRE(crb.overwritten() == 0);
         REQUIRE(crb.push_nb(buffer_size, true));
+        REQUIRE(crb.overwritten() == 1);
 
         // Pop first value
         size_t val;
@@ -57,6 +59,40 @@ TEST_CASE("ConcRingBuffer", "[ConcRingBuffer]")
 
         REQUIRE(crb.size() == 0);
         REQUIRE(!crb.pop_nb(&val));
+
+        // a forced push into free space deletes nothing
+        REQUIRE(crb.push_nb(0, true));
+        REQUIRE(crb.overwritten() == 1);
+    }
+
+    SECTION("Test drain_until and peek_front")
+    {
+        std::cout << "    Section 'Test drain_until and peek_front'" << std::endl;
+
+        size_t front = 0;
+        REQUIRE(crb.peek_front([&](const size_t& val) { front = val + 1; }));
+        REQUIRE(front == 1);
+        REQUIRE(crb.size() == buffer_size);
+
+        // draining stops at the first rejected element
+        size_t out[buffer_size];
+        REQUIRE(crb.drain_until([](const size_t& val) { return val < 3; }, out, buffer_size) == 3);
+        REQUIRE(out[0] == 0);
+        REQUIRE(out[2] == 2);
+        REQUIRE(crb.size() == buffer_size - 3);
+
+        // and at the size of the output, also across the end of the buffer
+        crb.push(buffer_size);
+        crb.push(buffer_size + 1);
+        REQUIRE(crb.drain_until([](const size_t&) { return true; }, out, 3) == 3);
+        REQUIRE(out[0] == 3);
+        REQUIRE(out[2] == buffer_size);
+        REQUIRE(crb.drain_until([](const size_t&) { return true; }, out, buffer_size) == 1);
+        REQUIRE(out[0] == buffer_size + 1);
+
+        REQUIRE(crb.empty());
+        REQUIRE(!crb.peek_front([](const size_t&) {}));
+        REQUIRE(crb.drain_until([](const size_t&) { return true; }, out, buffer_size) == 0);
     }
 
     SECTION("Test clear")
@@ -123,3 +159,106 @@ TEST_CASE("ConcRingBuffer", "[ConcRingBuffer]")
     // after all these changes, capcity should not change
     REQUIRE(crb.capacity() == buffer_size);
 }
+
+TEST_CASE("ConcRingBufferStop", "[ConcRingBuffer]")
+{
+    std::cout << "Test Concurrent Ringbuffer Stop\n";
+
+    ConcurrentRingBuffer<size_t> crb(1);
+    size_t val;
+
+    SECTION("Test stopping a waiting pop")
+    {
+        std::cout << "    Section 'Test stopping a waiting pop'" << std::endl;
+
+        StopSource source;
+        auto start = std::chrono::steady_clock::now();
+        std::thread stop_thread{[&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            source.request_stop();
+        }};
+
+        REQUIRE(!crb.pop(&val, source.get_token()));
+        stop_thread.join();
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+        // a stopped token does not block, but still pops
+        REQUIRE(!crb.pop(&val, source.get_token()));
+        crb.push(1);
+        REQUIRE(crb.pop(&val, source.get_token()));
+        REQUIRE(val == 1);
+    }
+
+    SECTION("Test stopping a waiting push")
+    {
+        std::cout << "    Section 'Test stopping a waiting push'" << std::endl;
+
+        StopSource source;
+        crb.push(1);
+        std::thread stop_thread{[&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            source.request_stop();
+        }};
+
+        REQUIRE(!crb.push(2, source.get_token()));
+        stop_thread.join();
+        REQUIRE(crb.pop_nb(&val));
+        REQUIRE(val == 1);
+    }
+
+    SECTION("Test waiting for space")
+    {
+        std::cout << "    Section 'Test waiting for space'" << std::endl;
+
+        StopSource source;
+        REQUIRE(crb.wait_for_space(source.get_token()));
+
+        crb.push(1);
+        std::thread pop_thread{[&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            crb.pop(&val);
+        }};
+        REQUIRE(crb.wait_for_space(source.get_token()));
+        REQUIRE(crb.empty());
+        pop_thread.join();
+
+        crb.push(2);
+        std::thread stop_thread{[&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            source.request_stop();
+        }};
+        REQUIRE(!crb.wait_for_space(source.get_token()));
+        stop_thread.join();
+        REQUIRE(crb.full());
+    }
+
+    SECTION("Test waking consumers with clear")
+    {
+        std::cout << "    Section 'Test waking consumers with clear'" << std::endl;
+
+        std::thread clear_thread{[&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            crb.clear();
+        }};
+
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(!crb.pop_nb(&val, 10000));
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+        clear_thread.join();
+
+        // a token without a source never stops
+        std::thread push_thread{[&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            crb.push(3);
+        }};
+        REQUIRE(crb.pop(&val, StopToken{}));
+        REQUIRE(val == 3);
+        push_thread.join();
+    }
+}
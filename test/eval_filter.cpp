@@ -0,0 +1,176 @@
+/**
+ * @file eval_filter.cpp
+ *
+ * Compares the filters of util/filter.h with the former sliding window filter on a std::queue.
+ * Reports the runtime per update and the heap allocations while filtering, the filters have to update without any.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <msg/imu.h>
+#include <util/filter.h>
+
+#include "catch2_config.h"
+#include "alloc_counter.h"
+
+using namespace fastsense;
+using namespace fastsense::util;
+
+using fastsense::test::heap_allocations;
+
+namespace fastsense::util
+{
+
+constexpr size_t FILTER_WINDOW = 100;
+constexpr size_t FILTER_UPDATES = 1000000;
+
+/**
+ * @brief The former sliding window filter: a std::queue that grows and shrinks on every update
+ */
+template<typename T>
+class QueueWindowFilter
+{
+public:
+    explicit QueueWindowFilter(size_t window_size)
+        : window_size_{static_cast<double>(window_size)},
+          buffer_{},
+          mean_{}
+    {
+    }
+
+    const T& update(const T& new_value)
+    {
+        buffer_.push(new_value);
+        if (buffer_.size() <= window_size_)
+        {
+            mean_ += (new_value / window_size_);
+            return new_value;
+        }
+        mean_ += (buffer_.back() - buffer_.front()) / window_size_;
+        buffer_.pop();
+        return mean_;
+    }
+
+private:
+    double window_size_;
+    std::queue<T> buffer_;
+    T mean_;
+};
+
+/// Runtime per update in ns and heap allocations of a filter run
+struct FilterRun
+{
+    double time;
+    size_t allocations;
+};
+
+template<typename FILTER, typename T>
+static FilterRun run_filter(FILTER& filter, const std::vector<T>& values)
+{
+    size_t allocations = heap_allocations();
+    auto start = std::chrono::steady_clock::now();
+
+    T result{};
+    for (const auto& value : values)
+    {
+        result = filter.update(value);
+    }
+
+    double time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    allocations = heap_allocations() - allocations;
+
+    // keeps the loop from being optimized away
+    volatile bool sink = result == T{};
+    (void)sink;
+
+    return {time / values.size(), allocations};
+}
+
+static void print_run(const std::string& name, const FilterRun& run)
+{
+    std::cout << std::setw(28) << name << " | "
+              << std::setw(10) << std::fixed << std::setprecision(2) << run.time << " | "
+              << std::setw(11) << run.allocations << std::endl;
+}
+
+TEST_CASE("Eval_Filter", "[eval_filter][slow]")
+{
+    std::cout << "Testing 'Eval Filter'" << std::endl;
+
+    std::mt19937 gen(42);
+    std::normal_distribution<double> noise(9.81, 0.5);
+
+    std::vector<double> values(FILTER_UPDATES);
+    for (auto& value : values)
+    {
+        value = noise(gen);
+    }
+
+    std::vector<msg::Imu> imu_values(FILTER_UPDATES / 10);
+    for (auto& imu : imu_values)
+    {
+        double acc[3] = {noise(gen), noise(gen), noise(gen)};
+        double ang[3] = {noise(gen), noise(gen), noise(gen)};
+        double mag[3] = {noise(gen), noise(gen), noise(gen)};
+        imu = msg::Imu(acc, ang, mag);
+    }
+
+    std::cout << std::setw(28) << "filter" << " | "
+              << std::setw(10) << "ns/update" << " | "
+              << std::setw(11) << "allocations" << std::endl;
+
+    QueueWindowFilter<double> queue_filter(FILTER_WINDOW);
+    print_run("queue mean (former)", run_filter(queue_filter, values));
+
+    SlidingWindowFilter<double> mean_filter(FILTER_WINDOW);
+    auto mean_run = run_filter(mean_filter, values);
+    print_run("ring mean", mean_run);
+
+    SlidingWindowFilter<double> compensated_filter(FILTER_WINDOW, true);
+    auto compensated_run = run_filter(compensated_filter, values);
+    print_run("ring mean compensated", compensated_run);
+
+    SlidingMedianFilter<double> median_filter(FILTER_WINDOW);
+    auto median_run = run_filter(median_filter, values);
+    print_run("ring median", median_run);
+
+    ExponentialFilter<double> exponential_filter(2.0 / (FILTER_WINDOW + 1));
+    auto exponential_run = run_filter(exponential_filter, values);
+    print_run("exponential", exponential_run);
+
+    QueueWindowFilter<msg::Imu> queue_imu_filter(FILTER_WINDOW);
+    print_run("queue mean imu (former)", run_filter(queue_imu_filter, imu_values));
+
+    SlidingWindowFilter<msg::Imu> imu_filter(FILTER_WINDOW);
+    auto imu_run = run_filter(imu_filter, imu_values);
+    print_run("ring mean imu", imu_run);
+
+    REQUIRE(mean_run.allocations == 0);
+    REQUIRE(compensated_run.allocations == 0);
+    REQUIRE(median_run.allocations == 0);
+    REQUIRE(exponential_run.allocations == 0);
+    REQUIRE(imu_run.allocations == 0);
+
+    // drift of the running mean against the mean of the values in the window
+    double exact = 0.0;
+    for (size_t i = values.size() - FILTER_WINDOW; i < values.size(); i++)
+    {
+        exact += values[i];
+    }
+    exact /= FILTER_WINDOW;
+
+    double drift = std::abs(mean_filter.get_mean() - exact);
+    double compensated_drift = std::abs(compensated_filter.get_mean() - exact);
+    std::cout << std::scientific << "Drift after " << FILTER_UPDATES << " updates: " << drift
+              << ", compensated: " << compensated_drift << std::endl;
+
+    REQUIRE(compensated_drift <= drift);
+}
+
+} // namespace fastsense::util
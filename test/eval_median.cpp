@@ -135,15 +135,17 @@ TEST_CASE("Eval_Median", "[eval_median][slow]")
     std::cout << "Testing 'Eval Median'" << std::endl;
 
     auto pointcloud_buffer = std::make_shared<msg::PointCloudPtrStampedBuffer>(1);
-    auto pointcloud_bridge_buffer = std::make_shared<msg::PointCloudPtrStampedBuffer>(1);
+    auto pointcloud_bridge_buffer = std::make_shared<fastsense::buffer::ScanBufferStampedBuffer>(1);
 
-    Preprocessing preprocessor{pointcloud_buffer, pointcloud_bridge_buffer, 0, false, false};
+    Preprocessing preprocessor{pointcloud_buffer, pointcloud_bridge_buffer, nullptr, 0, false, false};
 
     fastsense::CommandQueuePtr q = fastsense::hw::FPGAManager::create_command_queue();
 
     auto buffer = std::make_shared<msg::ImuStampedBuffer>(0);
     //test registration
-    fastsense::registration::Registration reg(q, buffer, MAX_ITERATIONS);
+    fastsense::registration::RegistrationOptions options;
+    options.max_iterations = MAX_ITERATIONS;
+    fastsense::registration::Registration reg(q, buffer, options);
 
     std::vector<std::vector<Vector3f>> float_points;
     unsigned int num_points;
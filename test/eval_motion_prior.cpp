@@ -0,0 +1,188 @@
+/**
+ * @file eval_motion_prior.cpp
+ *
+ * Registers a sequence of scans with aggressive simulated motion with and without
+ * the constant velocity motion model and compares the iterations per scan
+ */
+
+#include <iomanip>
+
+#include <registration/registration.h>
+#include <util/pcd/pcd_file.h>
+#include <tsdf/krnl_tsdf.h>
+
+#include "catch2_config.h"
+
+using fastsense::util::PCDFile;
+
+namespace fastsense::registration
+{
+
+constexpr unsigned int SCALE = 1000;
+
+/// Upper bound for the average error with the motion model
+constexpr float MAX_OFFSET = 100;
+
+/// Simulated motion per scan: 2 m/s and 30 deg/s at 10 Hz
+constexpr float STEP_X = 0.15 * SCALE;
+constexpr float STEP_Y = 0.1 * SCALE;
+constexpr float STEP_YAW = 3 * (M_PI / 180);
+constexpr int SCAN_PERIOD_MS = 100;
+constexpr int NUM_SCANS = 10;
+
+constexpr float TAU = 1 * SCALE;
+constexpr float MAX_WEIGHT = 10 * WEIGHT_RESOLUTION;
+
+constexpr int SIZE_X = 20 * SCALE / MAP_RESOLUTION;
+constexpr int SIZE_Y = 20 * SCALE / MAP_RESOLUTION;
+constexpr int SIZE_Z = 5 * SCALE / MAP_RESOLUTION;
+
+/// Parameters of app_data/config.json
+constexpr int MAX_ITERATIONS = 200;
+constexpr float IT_WEIGHT_GRADIENT = 0.1;
+constexpr float EPSILON = 0.04;
+constexpr float LM_DAMPING = 0.001;
+constexpr float LM_TRANSLATION_EPSILON = 1.0;
+constexpr float LM_ROTATION_EPSILON = 0.001;
+constexpr int MOTION_HISTORY = 3;
+/// There is no IMU data in this benchmark, so the rotation is only predicted by the motion model
+constexpr float MOTION_IMU_WEIGHT = 0.0;
+constexpr float PRIOR_WEIGHT = 0.01;
+
+/// Result of a whole sequence
+struct SequenceResult
+{
+    int iterations;
+    float error;
+};
+
+/**
+ * @brief Simulated pose of the scanner at the given scan
+ */
+static Matrix4f simulated_pose(int scan)
+{
+    Matrix4f pose = Matrix4f::Identity();
+    pose.block<3, 3>(0, 0) = Eigen::AngleAxisf(STEP_YAW * scan, Vector3f::UnitZ()).toRotationMatrix();
+    pose.block<3, 1>(0, 3) = Vector3f(STEP_X * scan, STEP_Y * scan, 0);
+    return pose;
+}
+
+/**
+ * @brief Register the simulated sequence and sum up the iterations and the translation errors
+ */
+static SequenceResult eval_sequence(const ScanPoints_t& points,
+                                    fastsense::map::LocalMap& local_map,
+                                    fastsense::registration::Registration& reg,
+                                    const fastsense::CommandQueuePtr& q)
+{
+    SequenceResult result{0, 0.0f};
+    fastsense::buffer::InputBuffer<PointHW> buffer(q, points.size());
+
+    auto start = util::HighResTime::now();
+    Matrix4f pose = Matrix4f::Identity();
+
+    for (int scan = 1; scan <= NUM_SCANS; scan++)
+    {
+        // the scanner moved, so the points appear with the inverse motion
+        Matrix4f truth = simulated_pose(scan);
+        ScanPoints_t points_transformed(points);
+        Registration::transform_point_cloud(points_transformed, truth.inverse());
+
+        for (size_t i = 0; i < points_transformed.size(); i++)
+        {
+            buffer[i] = PointHW(points_transformed[i].x(), points_transformed[i].y(), points_transformed[i].z());
+        }
+
+        reg.register_cloud(local_map, buffer, buffer.size(), start + std::chrono::milliseconds(SCAN_PERIOD_MS * scan), pose);
+
+        result.iterations += reg.last_iterations();
+        result.error += (pose.block<3, 1>(0, 3) - truth.block<3, 1>(0, 3)).norm();
+    }
+
+    result.error /= NUM_SCANS;
+    return result;
+}
+
+TEST_CASE("Eval_Motion_Prior", "[eval_motion_prior][slow]")
+{
+    std::cout << "Testing 'Eval Motion Prior'" << std::endl;
+
+    fastsense::CommandQueuePtr q = fastsense::hw::FPGAManager::create_command_queue();
+    auto imu_buffer = std::make_shared<msg::ImuStampedBuffer>(0);
+
+    std::vector<std::vector<Vector3f>> float_points;
+    unsigned int num_points;
+
+    PCDFile file("robo_lab.pcd");
+    file.readPoints(float_points, num_points);
+
+    ScanPoints_t scan_points(num_points);
+    fastsense::buffer::InputBuffer<PointHW> kernel_points(q, num_points);
+
+    auto count = 0u;
+    for (const auto& ring : float_points)
+    {
+        for (const auto& point : ring)
+        {
+            scan_points[count] = (point * SCALE).cast<int>();
+            kernel_points[count] = PointHW(scan_points[count].x(), scan_points[count].y(), scan_points[count].z());
+            ++count;
+        }
+    }
+
+    std::shared_ptr<fastsense::map::GlobalMap> global_map_ptr(new fastsense::map::GlobalMap("test_global_map.h5", 0.0, 0.0));
+    fastsense::map::LocalMap local_map(SIZE_X, SIZE_Y, SIZE_Z, global_map_ptr, q);
+
+    fastsense::tsdf::TSDFKernel krnl(q, local_map.getBuffer().size());
+    krnl.run(local_map, kernel_points, kernel_points.size(), TAU, MAX_WEIGHT);
+    krnl.waitComplete();
+
+    std::cout << std::setw(24) << "configuration" << " | "
+              << std::setw(12) << "iterations" << " | "
+              << std::setw(12) << "error [mm]" << std::endl;
+
+    auto print_result = [](const std::string & name, const SequenceResult & result)
+    {
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(24) << name << " | "
+                  << std::setw(12) << result.iterations << " | "
+                  << std::setw(12) << result.error << std::endl;
+    };
+
+    for (auto solver : {SolverMode::KERNEL, SolverMode::LM})
+    {
+        std::string name = solver == SolverMode::LM ? "lm" : "kernel";
+
+        RegistrationOptions options;
+        options.max_iterations = MAX_ITERATIONS;
+        options.it_weight_gradient = IT_WEIGHT_GRADIENT;
+        options.epsilon = EPSILON;
+        options.solver = solver;
+        options.lm_damping = LM_DAMPING;
+        options.lm_translation_epsilon = LM_TRANSLATION_EPSILON;
+        options.lm_rotation_epsilon = LM_ROTATION_EPSILON;
+
+        Registration reg_imu(q, imu_buffer, options);
+        auto without = eval_sequence(scan_points, local_map, reg_imu, q);
+        print_result(name + " imu only", without);
+
+        options.motion_history = MOTION_HISTORY;
+        options.motion_imu_weight = MOTION_IMU_WEIGHT;
+        Registration reg_motion(q, imu_buffer, options);
+        auto with = eval_sequence(scan_points, local_map, reg_motion, q);
+        print_result(name + " motion model", with);
+
+        CHECK(with.iterations <= without.iterations);
+        CHECK(with.error < MAX_OFFSET);
+
+        if (solver == SolverMode::LM)
+        {
+            options.prior_weight = PRIOR_WEIGHT;
+            Registration reg_prior(q, imu_buffer, options);
+            auto prior = eval_sequence(scan_points, local_map, reg_prior, q);
+            print_result(name + " motion model + prior", prior);
+        }
+    }
+}
+
+} //namespace fastsense::registration
@@ -0,0 +1,158 @@
+/**
+ * @file eval_pipeline_occupancy.cpp
+ *
+ * Compares the processing of scans one after another in a single thread with the staged pipeline,
+ * where preprocessing, registration, integration and export run in their own threads and hand the scans
+ * over through ring buffers. The stages are modelled by their host time (busy on the CPU) and their device
+ * time (waiting for a kernel), with the ratios of a measured run. Reports the scans per second and the
+ * occupancy of every stage.
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include <util/concurrent_ring_buffer.h>
+#include <util/stage_occupancy.h>
+
+#include "catch2_config.h"
+
+using namespace fastsense::util;
+using namespace std::chrono_literals;
+
+namespace fastsense::util
+{
+
+constexpr size_t PIPELINE_SCANS = 200;
+
+/// Host and device time of a stage per scan
+struct StageModel
+{
+    const char* name;
+    std::chrono::microseconds host;
+    std::chrono::microseconds device;
+};
+
+/// preprocessing on the CPU, registration and integration wait for their kernels, the export copies the map
+static const StageModel STAGES[] =
+{
+    {"preprocessing", 1500us, 0us},
+    {"registration", 500us, 2500us},
+    {"integration", 200us, 3000us},
+    {"export", 1000us, 0us},
+};
+constexpr size_t NUM_STAGES = sizeof(STAGES) / sizeof(STAGES[0]);
+
+/// Keep the CPU busy like the host part of a stage
+static void host_work(std::chrono::microseconds duration)
+{
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+/// Process one scan in a stage: host part, then waiting for the kernel
+static void process(const StageModel& stage)
+{
+    host_work(stage.host);
+    std::this_thread::sleep_for(stage.device);
+}
+
+/**
+ * @brief Process all scans in one thread, every stage waits for the previous one
+ *
+ * @return double scans per second
+ */
+static double run_sequential()
+{
+    std::vector<std::unique_ptr<StageOccupancy>> occupancy;
+    for (const auto& stage : STAGES)
+    {
+        occupancy.push_back(std::make_unique<StageOccupancy>(std::string("seq_") + stage.name));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t scan = 0; scan < PIPELINE_SCANS; scan++)
+    {
+        for (size_t s = 0; s < NUM_STAGES; s++)
+        {
+            occupancy[s]->begin();
+            process(STAGES[s]);
+            occupancy[s]->end();
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << PipelineOccupancy::get_instance().to_string();
+    return PIPELINE_SCANS / seconds;
+}
+
+/**
+ * @brief Process the scans in one thread per stage, connected by ring buffers
+ *
+ * @return double scans per second
+ */
+static double run_pipelined()
+{
+    std::vector<std::unique_ptr<StageOccupancy>> occupancy;
+    std::vector<std::unique_ptr<ConcurrentRingBuffer<size_t>>> buffers;
+    for (const auto& stage : STAGES)
+    {
+        occupancy.push_back(std::make_unique<StageOccupancy>(std::string("pipe_") + stage.name));
+        buffers.push_back(std::make_unique<ConcurrentRingBuffer<size_t>>(2));
+    }
+    ConcurrentRingBuffer<size_t> done(PIPELINE_SCANS);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t s = 0; s < NUM_STAGES; s++)
+    {
+        threads.emplace_back([&, s]()
+        {
+            auto& out = s + 1 < NUM_STAGES ? *buffers[s + 1] : done;
+            size_t scan;
+            for (size_t i = 0; i < PIPELINE_SCANS; i++)
+            {
+                buffers[s]->pop(&scan);
+                occupancy[s]->begin();
+                process(STAGES[s]);
+                occupancy[s]->end();
+                out.push(scan);
+            }
+        });
+    }
+    for (size_t scan = 0; scan < PIPELINE_SCANS; scan++)
+    {
+        buffers[0]->push(scan);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    REQUIRE(done.size() == PIPELINE_SCANS);
+    std::cout << PipelineOccupancy::get_instance().to_string();
+    return PIPELINE_SCANS / seconds;
+}
+
+TEST_CASE("Eval_Pipeline_Occupancy", "[eval_pipeline_occupancy][slow]")
+{
+    std::cout << "Testing 'Eval Pipeline Occupancy' with " << std::thread::hardware_concurrency() << " cores" << std::endl;
+
+    std::cout << "Sequential:" << std::endl;
+    double sequential = run_sequential();
+    std::cout << "Pipelined:" << std::endl;
+    double pipelined = run_pipelined();
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "sequential: " << sequential << " scans/s, pipelined: " << pipelined << " scans/s, gain: "
+              << pipelined / sequential << "x" << std::endl;
+
+    // the slowest stage limits the pipeline, the sequential run takes the sum of all stages
+    REQUIRE(pipelined > sequential);
+}
+
+} // namespace fastsense::util
@@ -0,0 +1,177 @@
+/**
+ * @file eval_point_selection.cpp
+ *
+ * Compares the latency and the accuracy of the registration for different point budgets
+ * on prerecorded scans with a simulated translation and rotation
+ */
+
+#include <chrono>
+#include <iomanip>
+
+#include <registration/registration.h>
+#include <util/pcd/pcd_file.h>
+#include <tsdf/krnl_tsdf.h>
+
+#include "catch2_config.h"
+
+using fastsense::util::PCDFile;
+
+namespace fastsense::registration
+{
+
+constexpr unsigned int SCALE = 1000;
+
+/// Upper bound for the error of the largest budget
+constexpr float MAX_OFFSET = 100;
+
+/// Test Translation
+constexpr float TX = 0.3 * SCALE;
+constexpr float TY = 0.3 * SCALE;
+constexpr float TZ = 0.0 * SCALE;
+/// Test Rotation
+constexpr float RY = 5 * (M_PI / 180); //radiants
+
+constexpr float TAU = 1 * SCALE;
+constexpr float MAX_WEIGHT = 10 * WEIGHT_RESOLUTION;
+
+constexpr int MAX_ITERATIONS = 200;
+
+constexpr int SIZE_X = 20 * SCALE / MAP_RESOLUTION;
+constexpr int SIZE_Y = 20 * SCALE / MAP_RESOLUTION;
+constexpr int SIZE_Z = 5 * SCALE / MAP_RESOLUTION;
+
+/// Point budgets to compare. 0 uses every point
+static const std::vector<unsigned int> BUDGETS = {0, 8000, 4000, 2000, 1000, 500};
+
+/// Recorded scans
+static const std::vector<std::string> RECORDINGS = {"robo_lab.pcd", "bagfile_cloud.pcd"};
+
+/**
+ * @brief Average distance between the points of two clouds
+ */
+static float average_error(const ScanPoints_t& points_posttransform, const ScanPoints_t& points_pretransform)
+{
+    float average = 0;
+    for (size_t i = 0; i < points_pretransform.size(); i++)
+    {
+        average += (points_pretransform[i] - points_posttransform[i]).cast<float>().norm();
+    }
+    return average / points_pretransform.size();
+}
+
+/**
+ * @brief Registers the transformed cloud and measures the time and the remaining error
+ *
+ * @param points Original scan points
+ * @param transformation_mat Transformation applied on the points before the registration
+ * @param local_map Map built from the original points
+ * @param reg Registration, which should be evaluated
+ * @param q Command queue for the input buffer
+ * @param latency Runtime of the registration in ms
+ * @return float Average error of the original and the registered points
+ */
+static float eval_registration(const ScanPoints_t& points,
+                               const Eigen::Matrix4f& transformation_mat,
+                               fastsense::map::LocalMap& local_map,
+                               fastsense::registration::Registration& reg,
+                               const fastsense::CommandQueuePtr& q,
+                               float& latency)
+{
+    ScanPoints_t points_transformed(points);
+    reg.transform_point_cloud(points_transformed, transformation_mat);
+
+    fastsense::buffer::InputBuffer<PointHW> buffer(q, points_transformed.size());
+    for (size_t i = 0; i < points_transformed.size(); i++)
+    {
+        buffer[i] = PointHW(points_transformed[i].x(), points_transformed[i].y(), points_transformed[i].z());
+    }
+
+    Matrix4f result_matrix = Matrix4f::Identity();
+
+    auto start = std::chrono::steady_clock::now();
+    reg.register_cloud(local_map, buffer, buffer.size(), util::HighResTime::now(), result_matrix);
+    latency = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    reg.transform_point_cloud(points_transformed, result_matrix);
+    return average_error(points_transformed, points);
+}
+
+TEST_CASE("Eval_Point_Selection", "[eval_point_selection][slow]")
+{
+    std::cout << "Testing 'Eval Point Selection'" << std::endl;
+
+    fastsense::CommandQueuePtr q = fastsense::hw::FPGAManager::create_command_queue();
+    auto imu_buffer = std::make_shared<msg::ImuStampedBuffer>(0);
+
+    Eigen::Matrix4f translation_mat;
+    translation_mat << 1, 0, 0, TX,
+                    0, 1, 0, TY,
+                    0, 0, 1, TZ,
+                    0, 0, 0,  1;
+
+    Eigen::Matrix4f rotation_mat;
+    rotation_mat <<  cos(RY), -sin(RY),      0, 0,
+                 sin(RY),  cos(RY),      0, 0,
+                 0,             0,       1, 0,
+                 0,             0,       0, 1;
+
+    for (const auto& recording : RECORDINGS)
+    {
+        std::vector<std::vector<Vector3f>> float_points;
+        unsigned int num_points;
+
+        PCDFile file(recording);
+        file.readPoints(float_points, num_points);
+
+        ScanPoints_t scan_points(num_points);
+        fastsense::buffer::InputBuffer<PointHW> kernel_points(q, num_points);
+
+        auto count = 0u;
+        for (const auto& ring : float_points)
+        {
+            for (const auto& point : ring)
+            {
+                scan_points[count] = (point * SCALE).cast<int>();
+                kernel_points[count] = PointHW(scan_points[count].x(), scan_points[count].y(), scan_points[count].z());
+                ++count;
+            }
+        }
+
+        std::shared_ptr<fastsense::map::GlobalMap> global_map_ptr(new fastsense::map::GlobalMap("test_global_map.h5", 0.0, 0.0));
+        fastsense::map::LocalMap local_map(SIZE_X, SIZE_Y, SIZE_Z, global_map_ptr, q);
+
+        fastsense::tsdf::TSDFKernel krnl(q, local_map.getBuffer().size());
+        krnl.run(local_map, kernel_points, kernel_points.size(), TAU, MAX_WEIGHT);
+        krnl.waitComplete();
+
+        std::cout << "    Recording '" << recording << "' with " << num_points << " points\n"
+                  << std::setw(8) << "budget" << " | "
+                  << std::setw(12) << "trans [ms]" << " | " << std::setw(12) << "trans [mm]" << " | "
+                  << std::setw(12) << "rot [ms]" << " | " << std::setw(12) << "rot [mm]" << std::endl;
+
+        for (auto budget : BUDGETS)
+        {
+            fastsense::registration::RegistrationOptions options;
+            options.max_iterations = MAX_ITERATIONS;
+            options.point_budget = budget;
+            fastsense::registration::Registration reg(q, imu_buffer, options);
+
+            float trans_latency, rot_latency;
+            float trans_error = eval_registration(scan_points, translation_mat, local_map, reg, q, trans_latency);
+            float rot_error = eval_registration(scan_points, rotation_mat, local_map, reg, q, rot_latency);
+
+            std::cout << std::fixed << std::setprecision(2)
+                      << std::setw(8) << budget << " | "
+                      << std::setw(12) << trans_latency << " | " << std::setw(12) << trans_error << " | "
+                      << std::setw(12) << rot_latency << " | " << std::setw(12) << rot_error << std::endl;
+
+            if (budget == 0 || budget == BUDGETS[1])
+            {
+                CHECK(trans_error < MAX_OFFSET);
+                CHECK(rot_error < MAX_OFFSET);
+            }
+        }
+    }
+}
+
+} //namespace fastsense::registration
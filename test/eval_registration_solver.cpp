@@ -0,0 +1,203 @@
+/**
+ * @file eval_registration_solver.cpp
+ *
+ * Compares the registration kernel with the Levenberg-Marquardt solver on prerecorded scans
+ * with a simulated translation and rotation: iterations, time per scan and remaining error
+ */
+
+#include <chrono>
+#include <iomanip>
+
+#include <registration/registration.h>
+#include <registration/lm_solver.h>
+#include <util/pcd/pcd_file.h>
+#include <tsdf/krnl_tsdf.h>
+
+#include "catch2_config.h"
+
+using fastsense::util::PCDFile;
+
+namespace fastsense::registration
+{
+
+constexpr unsigned int SCALE = 1000;
+
+/// Upper bound for the error of the LM solver
+constexpr float MAX_OFFSET = 100;
+
+/// Test Translation
+constexpr float TX = 0.3 * SCALE;
+constexpr float TY = 0.3 * SCALE;
+constexpr float TZ = 0.0 * SCALE;
+/// Test Rotation
+constexpr float RY = 5 * (M_PI / 180); //radiants
+
+constexpr float TAU = 1 * SCALE;
+constexpr float MAX_WEIGHT = 10 * WEIGHT_RESOLUTION;
+
+constexpr int SIZE_X = 20 * SCALE / MAP_RESOLUTION;
+constexpr int SIZE_Y = 20 * SCALE / MAP_RESOLUTION;
+constexpr int SIZE_Z = 5 * SCALE / MAP_RESOLUTION;
+
+/// Parameters of app_data/config.json
+constexpr int MAX_ITERATIONS = 200;
+constexpr float IT_WEIGHT_GRADIENT = 0.1;
+constexpr float EPSILON = 0.04;
+constexpr float LM_DAMPING = 0.001;
+constexpr float LM_TRANSLATION_EPSILON = 1.0;
+constexpr float LM_ROTATION_EPSILON = 0.001;
+
+/// Recorded scans
+static const std::vector<std::string> RECORDINGS = {"sim_cloud.pcd", "robo_lab.pcd", "bagfile_cloud.pcd"};
+
+/// Result of one registration
+struct SolverResult
+{
+    int iterations;
+    float time;
+    float error;
+    float pose_error;
+};
+
+/**
+ * @brief Average distance between the points of two clouds
+ */
+static float average_error(const ScanPoints_t& points_posttransform, const ScanPoints_t& points_pretransform)
+{
+    float average = 0;
+    for (size_t i = 0; i < points_pretransform.size(); i++)
+    {
+        average += (points_pretransform[i] - points_posttransform[i]).cast<float>().norm();
+    }
+    return average / points_pretransform.size();
+}
+
+/**
+ * @brief Registers the transformed cloud with the kernel or the LM solver
+ *
+ * @param points Original scan points
+ * @param transformation_mat Transformation applied on the points before the registration
+ * @param local_map Map built from the original points
+ * @param use_lm true: LM solver, false: registration kernel
+ * @param q Command queue for the buffers and the kernel
+ */
+static SolverResult eval_solver(const ScanPoints_t& points,
+                                const Eigen::Matrix4f& transformation_mat,
+                                fastsense::map::LocalMap& local_map,
+                                bool use_lm,
+                                const fastsense::CommandQueuePtr& q)
+{
+    ScanPoints_t points_transformed(points);
+    Registration::transform_point_cloud(points_transformed, transformation_mat);
+
+    fastsense::buffer::InputBuffer<PointHW> buffer(q, points_transformed.size());
+    for (size_t i = 0; i < points_transformed.size(); i++)
+    {
+        buffer[i] = PointHW(points_transformed[i].x(), points_transformed[i].y(), points_transformed[i].z());
+    }
+
+    SolverResult result;
+    Matrix4f pose = Matrix4f::Identity();
+    auto start = std::chrono::steady_clock::now();
+
+    if (use_lm)
+    {
+        LMSolver solver(MAX_ITERATIONS, LM_DAMPING, LM_TRANSLATION_EPSILON, LM_ROTATION_EPSILON);
+        result.iterations = solver.solve(local_map, buffer, buffer.size(), pose, result.error);
+    }
+    else
+    {
+        fastsense::kernels::RegistrationKernel krnl(q);
+        result.iterations = krnl.synchronized_run(local_map, buffer, buffer.size(), MAX_ITERATIONS, IT_WEIGHT_GRADIENT, EPSILON, pose, result.error);
+    }
+
+    result.time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    Registration::transform_point_cloud(points_transformed, pose);
+    result.pose_error = average_error(points_transformed, points);
+    return result;
+}
+
+/**
+ * @brief Print one line of the comparison table
+ */
+static void print_result(const std::string& name, const SolverResult& result)
+{
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(20) << name << " | "
+              << std::setw(10) << result.iterations << " | "
+              << std::setw(10) << result.time << " | "
+              << std::setw(10) << result.error << " | "
+              << std::setw(10) << result.pose_error << std::endl;
+}
+
+TEST_CASE("Eval_Registration_Solver", "[eval_registration_solver][slow]")
+{
+    std::cout << "Testing 'Eval Registration Solver'" << std::endl;
+
+    fastsense::CommandQueuePtr q = fastsense::hw::FPGAManager::create_command_queue();
+
+    Eigen::Matrix4f translation_mat;
+    translation_mat << 1, 0, 0, TX,
+                    0, 1, 0, TY,
+                    0, 0, 1, TZ,
+                    0, 0, 0,  1;
+
+    Eigen::Matrix4f rotation_mat;
+    rotation_mat <<  cos(RY), -sin(RY),      0, 0,
+                 sin(RY),  cos(RY),      0, 0,
+                 0,             0,       1, 0,
+                 0,             0,       0, 1;
+
+    for (const auto& recording : RECORDINGS)
+    {
+        std::vector<std::vector<Vector3f>> float_points;
+        unsigned int num_points;
+
+        PCDFile file(recording);
+        file.readPoints(float_points, num_points);
+
+        ScanPoints_t scan_points(num_points);
+        fastsense::buffer::InputBuffer<PointHW> kernel_points(q, num_points);
+
+        auto count = 0u;
+        for (const auto& ring : float_points)
+        {
+            for (const auto& point : ring)
+            {
+                scan_points[count] = (point * SCALE).cast<int>();
+                kernel_points[count] = PointHW(scan_points[count].x(), scan_points[count].y(), scan_points[count].z());
+                ++count;
+            }
+        }
+
+        std::shared_ptr<fastsense::map::GlobalMap> global_map_ptr(new fastsense::map::GlobalMap("test_global_map.h5", 0.0, 0.0));
+        fastsense::map::LocalMap local_map(SIZE_X, SIZE_Y, SIZE_Z, global_map_ptr, q);
+
+        fastsense::tsdf::TSDFKernel krnl(q, local_map.getBuffer().size());
+        krnl.run(local_map, kernel_points, kernel_points.size(), TAU, MAX_WEIGHT);
+        krnl.waitComplete();
+
+        std::cout << "    Recording '" << recording << "' with " << num_points << " points\n"
+                  << std::setw(20) << "solver" << " | "
+                  << std::setw(10) << "iterations" << " | "
+                  << std::setw(10) << "time [ms]" << " | "
+                  << std::setw(10) << "error" << " | "
+                  << std::setw(10) << "pose [mm]" << std::endl;
+
+        auto kernel_trans = eval_solver(scan_points, translation_mat, local_map, false, q);
+        auto lm_trans = eval_solver(scan_points, translation_mat, local_map, true, q);
+        auto kernel_rot = eval_solver(scan_points, rotation_mat, local_map, false, q);
+        auto lm_rot = eval_solver(scan_points, rotation_mat, local_map, true, q);
+
+        print_result("kernel translation", kernel_trans);
+        print_result("lm translation", lm_trans);
+        print_result("kernel rotation", kernel_rot);
+        print_result("lm rotation", lm_rot);
+
+        CHECK(lm_trans.pose_error < MAX_OFFSET);
+        CHECK(lm_rot.pose_error < MAX_OFFSET);
+    }
+}
+
+} //namespace fastsense::registration
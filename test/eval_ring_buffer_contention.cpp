@@ -0,0 +1,95 @@
+/**
+ * @file eval_ring_buffer_contention.cpp
+ *
+ * Compares the mutex based ConcurrentRingBuffer with the lock-free SpscRingBuffer and MpmcRingBuffer
+ * under contention: producer and consumer threads hand over stamped point cloud pointers through a small
+ * buffer with the blocking push and pop. Reports the handed over elements per second.
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <thread>
+
+#include <msg/point_cloud.h>
+#include <util/concurrent_ring_buffer.h>
+#include <util/lock_free_ring_buffer.h>
+
+#include "catch2_config.h"
+
+using namespace fastsense;
+using namespace fastsense::msg;
+using namespace fastsense::util;
+
+namespace fastsense::util
+{
+
+constexpr size_t CONTENTION_BUFFER_SIZE = 16;
+constexpr size_t CONTENTION_ELEMENTS = 400000;
+
+/**
+ * @brief Hand over CONTENTION_ELEMENTS elements from the producers to the consumers
+ *
+ * @return double million elements per second
+ */
+template<typename BUFFER>
+static double handover(size_t producers, size_t consumers)
+{
+    BUFFER buffer(CONTENTION_BUFFER_SIZE);
+    auto cloud = std::make_shared<PointCloud>();
+
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&]()
+        {
+            for (size_t i = 0; i < CONTENTION_ELEMENTS / producers; i++)
+            {
+                PointCloudPtrStamped scan{cloud};
+                buffer.push(std::move(scan));
+            }
+        });
+    }
+    for (size_t c = 0; c < consumers; c++)
+    {
+        threads.emplace_back([&]()
+        {
+            PointCloudPtrStamped scan;
+            for (size_t i = 0; i < CONTENTION_ELEMENTS / consumers; i++)
+            {
+                buffer.pop(&scan);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    REQUIRE(buffer.empty());
+    return CONTENTION_ELEMENTS / seconds * 1e-6;
+}
+
+TEST_CASE("Eval_Ring_Buffer_Contention", "[eval_ring_buffer_contention][slow]")
+{
+    std::cout << "Testing 'Eval Ring Buffer Contention' with " << std::thread::hardware_concurrency() << " cores" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(10) << "threads" << " | " << std::setw(12) << "mutex" << " | " << std::setw(12) << "spsc" << " | " << std::setw(12) << "mpmc" << " (Melements/s)" << std::endl;
+
+    std::cout << std::setw(10) << "1 / 1" << " | "
+              << std::setw(12) << handover<ConcurrentRingBuffer<PointCloudPtrStamped>>(1, 1) << " | "
+              << std::setw(12) << handover<SpscRingBuffer<PointCloudPtrStamped>>(1, 1) << " | "
+              << std::setw(12) << handover<MpmcRingBuffer<PointCloudPtrStamped>>(1, 1) << std::endl;
+
+    for (size_t threads : {2, 4})
+    {
+        std::cout << std::setw(10) << (std::to_string(threads) + " / " + std::to_string(threads)) << " | "
+                  << std::setw(12) << handover<ConcurrentRingBuffer<PointCloudPtrStamped>>(threads, threads) << " | "
+                  << std::setw(12) << "-" << " | "
+                  << std::setw(12) << handover<MpmcRingBuffer<PointCloudPtrStamped>>(threads, threads) << std::endl;
+    }
+}
+
+} // namespace fastsense::util
@@ -0,0 +1,166 @@
+/**
+ * @file eval_scan_handoff.cpp
+ *
+ * Compares the handoff of a scan from the preprocessing to the registration and the map thread:
+ * the former path (scale in place, reduce into a new vector, copy into a device buffer for the registration
+ * and a second one for the map thread) against the fused reduction into a pooled device buffer.
+ * Reports the bytes of point data written per scan and the runtime.
+ */
+
+#include <random>
+#include <chrono>
+#include <iomanip>
+
+#include <preprocessing/preprocessing.h>
+#include <util/config/config_manager.h>
+#include <hw/fpga_manager.h>
+
+#include "catch2_config.h"
+
+using namespace fastsense;
+using namespace fastsense::msg;
+using namespace fastsense::buffer;
+using namespace fastsense::preprocessing;
+using fastsense::util::config::ConfigManager;
+
+namespace fastsense::preprocessing
+{
+
+constexpr int HANDOFF_RUNS = 20;
+
+/// map_size / 2 * MAP_RESOLUTION of the config below
+constexpr int HANDOFF_BOUND_XY = 100 * MAP_RESOLUTION;
+constexpr int HANDOFF_BOUND_Z = 47 * MAP_RESOLUTION;
+
+static std::vector<ScanPoint> cloud_points(const InputBuffer<PointHW>& buffer, size_t num_points)
+{
+    std::vector<ScanPoint> points(num_points);
+    for (size_t i = 0; i < num_points; i++)
+    {
+        points[i] = ScanPoint(buffer[i].x, buffer[i].y, buffer[i].z);
+    }
+    return points;
+}
+
+TEST_CASE("Eval_Scan_Handoff", "[eval_scan_handoff][slow]")
+{
+    std::cout << "Testing 'Eval Scan Handoff'" << std::endl;
+
+    ConfigManager::loadString(R"({"slam": {"map_size_x": 201, "map_size_y": 201, "map_size_z": 95}})");
+
+    auto q = hw::FPGAManager::create_command_queue();
+    auto pool = std::make_shared<ScanBufferPool>(q);
+    auto pointcloud_buffer = std::make_shared<PointCloudPtrStampedBuffer>(1);
+    auto scan_buffer = std::make_shared<ScanBufferStampedBuffer>(1);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> xy(-HANDOFF_BOUND_XY, HANDOFF_BOUND_XY);
+    std::uniform_int_distribution<int> z(-HANDOFF_BOUND_Z, HANDOFF_BOUND_Z);
+    std::vector<ScanPoint> points(30000);
+    for (auto& point : points)
+    {
+        point = ScanPoint(xy(gen), xy(gen), z(gen)) / 2;
+    }
+
+    std::cout << std::setw(6) << "scale" << " | "
+              << std::setw(8) << "path" << " | "
+              << std::setw(12) << "bytes/scan" << " | "
+              << std::setw(10) << "time [ms]" << std::endl;
+
+    for (float scale : {1.0f, 2.0f})
+    {
+        Preprocessing preprocessor{pointcloud_buffer, scan_buffer, pool, nullptr, false, false, scale};
+
+        PointCloudPtrStamped cloud;
+        cloud.data_ = std::make_shared<PointCloud>();
+
+        // former path
+        size_t former_bytes = 0;
+        size_t former_points = 0;
+        std::unique_ptr<InputBuffer<PointHW>> registration_points;
+        std::unique_ptr<InputBuffer<PointHW>> map_points;
+        double former_time = 0.0;
+        for (int run = 0; run < HANDOFF_RUNS; run++)
+        {
+            cloud.data_->points_ = points;
+            former_bytes = 0;
+
+            auto start = std::chrono::steady_clock::now();
+            if (scale != 1.0f)
+            {
+                for (auto& point : cloud.data_->points_)
+                {
+                    point = (point.cast<float>() * scale).cast<ScanPointType>();
+                }
+                former_bytes += cloud.data_->points_.size() * sizeof(ScanPoint);
+            }
+
+            preprocessor.reduction_filter_closest(cloud);
+            size_t num_points = cloud.data_->points_.size();
+            former_points = num_points;
+            former_bytes += num_points * sizeof(ScanPoint);
+
+            if (registration_points == nullptr || num_points > registration_points->size())
+            {
+                registration_points.reset();
+                registration_points.reset(new InputBuffer<PointHW>(q, num_points * 1.5));
+            }
+            for (size_t i = 0; i < num_points; i++)
+            {
+                const auto& point = cloud.data_->points_[i];
+                (*registration_points)[i] = PointHW(point.x(), point.y(), point.z());
+            }
+            former_bytes += num_points * sizeof(PointHW);
+
+            // the map thread copied the whole buffer on every map update
+            if (map_points == nullptr || map_points->size() != registration_points->size())
+            {
+                map_points.reset();
+                map_points.reset(new InputBuffer<PointHW>(*registration_points));
+            }
+            else
+            {
+                map_points->fill_from(*registration_points);
+            }
+            former_bytes += registration_points->size() * sizeof(PointHW);
+            former_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        // fused path
+        size_t fused_bytes = 0;
+        size_t allocations = 0;
+        double fused_time = 0.0;
+        for (int run = 0; run < HANDOFF_RUNS; run++)
+        {
+            cloud.data_->points_ = points;
+
+            auto start = std::chrono::steady_clock::now();
+            ScanBuffer::Ptr scan = preprocessor.reduce_to_scan(cloud);
+            fused_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            fused_bytes = scan->num_points_ * sizeof(PointHW);
+
+            if (run == 0)
+            {
+                // same points in the same order as the former path
+                std::vector<ScanPoint> actual;
+                scan->copy_to(actual);
+                REQUIRE(actual == cloud_points(*registration_points, former_points));
+                allocations = pool->allocations();
+            }
+        }
+        // the buffer of every scan returns to the pool
+        REQUIRE(pool->allocations() == allocations);
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << std::setw(6) << scale << " | "
+                  << std::setw(8) << "former" << " | "
+                  << std::setw(12) << former_bytes << " | "
+                  << std::setw(10) << former_time / HANDOFF_RUNS << std::endl
+                  << std::setw(6) << scale << " | "
+                  << std::setw(8) << "fused" << " | "
+                  << std::setw(12) << fused_bytes << " | "
+                  << std::setw(10) << fused_time / HANDOFF_RUNS << std::endl;
+    }
+}
+
+} // namespace fastsense::preprocessing
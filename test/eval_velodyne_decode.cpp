@@ -0,0 +1,206 @@
+/**
+ * @file eval_velodyne_decode.cpp
+ *
+ * Compares the decoding of the Velodyne decoder with lookup tables to the former decoding with
+ * sin and cos for every point on synthetic VLP-16 packets of a room: points and throughput.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <random>
+
+#include <driver/lidar/velodyne_decoder.h>
+
+#include "catch2_config.h"
+
+using namespace fastsense;
+using namespace fastsense::driver;
+using namespace fastsense::msg;
+
+namespace fastsense::driver
+{
+
+constexpr int NUM_RUNS = 5;
+
+/// 10 s of data of the sensor
+constexpr size_t NUM_PACKETS = 7540;
+
+/// Former decoding with sin and cos for every point
+namespace reference
+{
+
+constexpr float deg_to_rad(float deg)
+{
+    return deg * M_PIf32 / 180.f;
+}
+
+constexpr float LASER_ID_TO_VERT_ANGLE[16] =
+{
+    deg_to_rad(-15), deg_to_rad(1), deg_to_rad(-13), deg_to_rad(3),
+    deg_to_rad(-11), deg_to_rad(5), deg_to_rad(-9), deg_to_rad(7),
+    deg_to_rad(-7), deg_to_rad(9), deg_to_rad(-5), deg_to_rad(11),
+    deg_to_rad(-3), deg_to_rad(13), deg_to_rad(-1), deg_to_rad(15)
+};
+
+constexpr float LASER_ID_TO_OFFSET[16] =
+{
+    11.2f, -0.7f, 9.7f, -2.2f, 8.1f, -3.7f, 6.6f, -5.1f,
+    5.1f, -6.6f, 3.7f, 2.2f, -9.7f, 0.7f, -11.2f
+};
+
+constexpr uint8_t LASER_ID_TO_RING[16] =
+{
+    15, 13, 11, 9, 7, 5, 3, 1, 14, 12, 10, 8, 6, 4, 2, 0
+};
+
+static void decode_packet(const VelodynePacket& packet, std::vector<ScanPoint>& points)
+{
+    // last block uses previous difference for simplification
+    float az_diff = 0.f;
+
+    for (int b = 0; b < BLOCKS_IN_PACKET; b++)
+    {
+        float az_block = packet.blocks[b].azimuth * 0.01f;
+
+        size_t startIdx = points.size();
+        points.resize(startIdx + POINTS_IN_BLOCK);
+
+        if (b + 1 < BLOCKS_IN_PACKET)
+        {
+            az_diff = (packet.blocks[b + 1].azimuth * 0.01f) - az_block;
+            if (packet.blocks[b + 1].azimuth < packet.blocks[b].azimuth)
+            {
+                az_diff += 360.f;
+            }
+        }
+
+        for (int p = 0; p < POINTS_IN_BLOCK; p++)
+        {
+            auto& new_point = points[startIdx + LASER_ID_TO_RING[p % RINGS_IN_SCAN] + (p < RINGS_IN_SCAN ? 0 : RINGS_IN_SCAN)];
+
+            float az;
+            if (p < 16)
+            {
+                az = az_block + (az_diff * 2.304f * p) / 55.296f;
+            }
+            else
+            {
+                az = az_block + (az_diff * 2.304f * (p - 16)) / (2 * 55.296f);
+            }
+
+            if (az > 360.f)
+            {
+                az -= 360.f;
+            }
+
+            az = deg_to_rad(az);
+
+            if (packet.blocks[b].points[p].distance > 0)
+            {
+                float r = packet.blocks[b].points[p].distance * 2 - LASER_ID_TO_OFFSET[p % 16];
+                float cos_vertical = cos(LASER_ID_TO_VERT_ANGLE[p % 16]);
+                new_point.x() = r * cos_vertical * sin(az);
+                new_point.y() = r * cos_vertical * cos(az);
+                new_point.z() = r * sin(LASER_ID_TO_VERT_ANGLE[p % 16]);
+            }
+            else
+            {
+                new_point = ScanPoint::Zero();
+            }
+        }
+    }
+}
+
+} // namespace reference
+
+/**
+ * @brief Packets of a spinning VLP-16 at 10 Hz in a room of 20 m x 12 m with some missing returns
+ */
+static std::vector<VelodynePacket> room_packets(size_t num_packets)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> noise(-10, 10);
+    std::uniform_int_distribution<int> missing(0, 30);
+
+    std::vector<VelodynePacket> packets(num_packets);
+    uint16_t azimuth = 0;
+    for (auto& packet : packets)
+    {
+        packet.mode = 0x37;
+        packet.produkt_id = 0x22;
+        for (auto& block : packet.blocks)
+        {
+            block.flag = 0xEEFF;
+            block.azimuth = azimuth;
+            azimuth = (azimuth + 40) % 36000;
+
+            float az = block.azimuth * 0.01f * M_PIf32 / 180.f;
+            float wall = std::min(10000.f / std::max(std::abs(std::sin(az)), 0.01f), 6000.f / std::max(std::abs(std::cos(az)), 0.01f));
+            for (int p = 0; p < POINTS_IN_BLOCK; p++)
+            {
+                // distance in 2 mm
+                block.points[p].distance = missing(gen) == 0 ? 0 : static_cast<uint16_t>(wall / 2 + noise(gen));
+                block.points[p].intensity = 100;
+            }
+        }
+    }
+    return packets;
+}
+
+TEST_CASE("Eval_Velodyne_Decode", "[eval_velodyne_decode][slow]")
+{
+    std::cout << "Testing 'Eval Velodyne Decode'" << std::endl;
+
+    auto packets = room_packets(NUM_PACKETS);
+    auto buffer = std::make_shared<PointCloudPtrStampedBuffer>(16);
+    VelodyneDecoder decoder{buffer};
+    auto now = util::HighResTime::now();
+
+    // one packet is less than one scan, so every packet stays in the current scan
+    for (const auto& packet : room_packets(1))
+    {
+        std::vector<ScanPoint> expected;
+        reference::decode_packet(packet, expected);
+        decoder.decode_packet(packet, now);
+        const auto& actual = decoder.current_scan().points_;
+        REQUIRE(actual.size() == expected.size());
+
+        // the azimuth is rounded to 0.01 degree: less than 1 mm at 10 m, plus truncation
+        for (size_t i = 0; i < actual.size(); i++)
+        {
+            REQUIRE((actual[i] - expected[i]).cwiseAbs().maxCoeff() <= 2);
+        }
+    }
+
+    double reference_time = 0.0;
+    double lut_time = 0.0;
+    std::vector<ScanPoint> points;
+    points.reserve(NUM_PACKETS * BLOCKS_IN_PACKET * POINTS_IN_BLOCK);
+    for (int run = 0; run < NUM_RUNS; run++)
+    {
+        points.clear();
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& packet : packets)
+        {
+            reference::decode_packet(packet, points);
+        }
+        reference_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        buffer->clear();
+        start = std::chrono::steady_clock::now();
+        for (const auto& packet : packets)
+        {
+            decoder.decode_packet(packet, now);
+        }
+        lut_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double num_points = static_cast<double>(NUM_PACKETS) * BLOCKS_IN_PACKET * POINTS_IN_BLOCK * NUM_RUNS;
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(14) << "decode" << " | " << std::setw(16) << "Mpoints/s" << std::endl
+              << std::setw(14) << "sin/cos" << " | " << std::setw(16) << num_points / reference_time * 1e-6 << std::endl
+              << std::setw(14) << "lookup table" << " | " << std::setw(16) << num_points / lut_time * 1e-6 << std::endl;
+}
+
+} // namespace fastsense::driver
@@ -0,0 +1,276 @@
+/**
+ * @file eval_velodyne_receive.cpp
+ *
+ * Replays synthetic VLP-16 packets over the loopback interface to the VelodyneDriver and
+ * measures the received packets per second, the CPU time per packet and the dropped packets.
+ * The former receive loop with poll, recvfrom and decode of every packet in one thread serves as reference.
+ */
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <thread>
+#include <ctime>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <driver/lidar/velodyne.h>
+
+#include "catch2_config.h"
+
+using namespace fastsense;
+using namespace fastsense::driver;
+using namespace fastsense::msg;
+
+namespace fastsense::driver
+{
+
+constexpr uint16_t REPLAY_PORT = 2370;
+constexpr size_t PACKETS_PER_SECOND = 754;
+constexpr size_t FLOOD_PACKETS = 200000;
+
+/**
+ * @brief CPU time of the calling thread or the whole process in seconds
+ */
+static double cpu_time(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Replay stand-in for the sensor: sends packets of a spinning VLP-16 in strongest return mode
+ */
+class PacketReplay
+{
+public:
+    explicit PacketReplay(uint16_t port)
+        : sockfd_{socket(PF_INET, SOCK_DGRAM, 0)}, addr_{}, packet_{}, azimuth_{0}, cpu_time_{0.0}
+    {
+        addr_.sin_family = AF_INET;
+        addr_.sin_port = htons(port);
+        addr_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        packet_.mode = 0x37;
+        packet_.produkt_id = 0x22;
+        for (auto& block : packet_.blocks)
+        {
+            block.flag = 0xEEFF;
+            for (int p = 0; p < POINTS_IN_BLOCK; p++)
+            {
+                block.points[p].distance = 1000 + 100 * (p % RINGS_IN_SCAN);
+                block.points[p].intensity = 100;
+            }
+        }
+    }
+
+    ~PacketReplay()
+    {
+        close(sockfd_);
+    }
+
+    /// delete copy assignment operator
+    PacketReplay& operator=(const PacketReplay& other) = delete;
+
+    /// delete move assignment operator
+    PacketReplay& operator=(PacketReplay&&) noexcept = delete;
+
+    /// delete copy constructor
+    PacketReplay(const PacketReplay&) = delete;
+
+    /// delete move constructor
+    PacketReplay(PacketReplay&&) = delete;
+
+    /**
+     * @brief Send the packets with the given rate. 0 sends as fast as possible
+     */
+    void send(size_t num_packets, size_t packets_per_second)
+    {
+        double cpu_start = cpu_time(CLOCK_THREAD_CPUTIME_ID);
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < num_packets; i++)
+        {
+            if (packets_per_second > 0)
+            {
+                std::this_thread::sleep_until(start + std::chrono::microseconds(i * 1000000 / packets_per_second));
+            }
+
+            // 0.4 degree between two blocks at 10 Hz
+            for (auto& block : packet_.blocks)
+            {
+                block.azimuth = azimuth_;
+                azimuth_ = (azimuth_ + 40) % 36000;
+            }
+            sendto(sockfd_, &packet_, sizeof(packet_), 0, reinterpret_cast<sockaddr*>(&addr_), sizeof(addr_));
+        }
+
+        cpu_time_ += cpu_time(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+    }
+
+    /**
+     * @brief CPU time of all send calls in seconds
+     */
+    double cpu_time_used() const
+    {
+        return cpu_time_;
+    }
+
+private:
+    int sockfd_;
+    sockaddr_in addr_;
+    VelodynePacket packet_;
+    uint16_t azimuth_;
+    double cpu_time_;
+};
+
+struct ReceiveResult
+{
+    size_t packets;
+    size_t calls;
+    double seconds;
+    double cpu_seconds;
+    size_t dropped;
+    size_t high_water;
+};
+
+/**
+ * @brief Driver with the former receive loop: poll, recvfrom and decode of every packet in one thread
+ */
+class ReferenceDriver : public VelodyneDriver
+{
+public:
+    using VelodyneDriver::VelodyneDriver;
+
+protected:
+    void thread_run() override
+    {
+        pollfd fds[1];
+        fds[0].fd = sockfd_;
+        fds[0].events = POLLIN;
+        VelodynePacket packet;
+
+        while (running)
+        {
+            if (poll(fds, 1, 100) <= 0)
+            {
+                continue;
+            }
+            ssize_t size = recvfrom(sockfd_, &packet, sizeof(VelodynePacket), 0, nullptr, nullptr);
+            receive_calls_++;
+            if (size == sizeof(VelodynePacket))
+            {
+                packets_received_++;
+                decoder_.decode_packet(packet, util::HighResTime::now());
+            }
+        }
+    }
+};
+
+/**
+ * @brief Receive and decode with the driver. The CPU time of the driver is the CPU time of the process without the sender
+ */
+template<typename DRIVER>
+static ReceiveResult receive(size_t num_packets, size_t packets_per_second, std::vector<PointCloudPtrStamped>& scans)
+{
+    auto buffer = std::make_shared<PointCloudPtrStampedBuffer>(1000);
+    DRIVER driver{REPLAY_PORT, buffer, 4 * 1024 * 1024};
+    PacketReplay replay{REPLAY_PORT};
+
+    driver.start();
+    double cpu_start = cpu_time(CLOCK_PROCESS_CPUTIME_ID);
+    auto start = std::chrono::steady_clock::now();
+
+    replay.send(num_packets, packets_per_second);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    ReceiveResult result{driver.packets_received(), driver.receive_calls(), 0.0, 0.0,
+                         num_packets - driver.packets_received(), driver.ring_high_water()};
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.cpu_seconds = cpu_time(CLOCK_PROCESS_CPUTIME_ID) - cpu_start - replay.cpu_time_used();
+    driver.stop();
+
+    PointCloudPtrStamped scan;
+    while (buffer->pop_nb(&scan))
+    {
+        scans.push_back(scan);
+    }
+    return result;
+}
+
+TEST_CASE("Eval_Velodyne_Receive", "[eval_velodyne_receive][slow]")
+{
+    std::cout << "Testing 'Eval Velodyne Receive'" << std::endl;
+
+    std::cout << std::setw(10) << "rate" << " | "
+              << std::setw(18) << "receiver" << " | "
+              << std::setw(10) << "packets" << " | "
+              << std::setw(12) << "packets/s" << " | "
+              << std::setw(14) << "cpu [us/pkt]" << " | "
+              << std::setw(10) << "pkts/call" << " | "
+              << std::setw(10) << "dropped" << " | "
+              << std::setw(10) << "ring max" << std::endl;
+
+    auto print = [](const std::string & rate, const std::string & name, const ReceiveResult & result)
+    {
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(10) << rate << " | "
+                  << std::setw(18) << name << " | "
+                  << std::setw(10) << result.packets << " | "
+                  << std::setw(12) << result.packets / result.seconds << " | "
+                  << std::setw(14) << result.cpu_seconds * 1e6 / result.packets << " | "
+                  << std::setw(10) << static_cast<double>(result.packets) / result.calls << " | "
+                  << std::setw(10) << result.dropped << " | "
+                  << std::setw(10) << result.high_water << std::endl;
+    };
+
+    SECTION("Sensor rate")
+    {
+        std::vector<PointCloudPtrStamped> scans;
+        auto before = util::HighResTime::now();
+        std::vector<PointCloudPtrStamped> reference_scans;
+        auto driver = receive<VelodyneDriver>(2 * PACKETS_PER_SECOND, PACKETS_PER_SECOND, scans);
+        auto reference = receive<ReferenceDriver>(2 * PACKETS_PER_SECOND, PACKETS_PER_SECOND, reference_scans);
+
+        print("sensor", "single thread", reference);
+        print("sensor", "receive + decode", driver);
+
+        // nothing is lost at the rate of the sensor
+        REQUIRE(driver.packets == 2 * PACKETS_PER_SECOND);
+
+        // 10 Hz, the first scan starts at the first packet
+        REQUIRE(scans.size() >= 18);
+        for (size_t i = 0; i < scans.size(); i++)
+        {
+            REQUIRE(scans[i].data_->points_.size() > 0);
+            REQUIRE(scans[i].data_->points_.size() % RINGS_IN_SCAN == 0);
+
+            // kernel timestamps of the packets: after the start, not in the future and in order
+            REQUIRE(scans[i].timestamp_ >= before);
+            REQUIRE(scans[i].timestamp_ <= util::HighResTime::now());
+            if (i > 0)
+            {
+                REQUIRE(scans[i].timestamp_ > scans[i - 1].timestamp_);
+            }
+        }
+    }
+
+    SECTION("Flood")
+    {
+        std::vector<PointCloudPtrStamped> scans;
+        auto driver = receive<VelodyneDriver>(FLOOD_PACKETS, 0, scans);
+        auto reference = receive<ReferenceDriver>(FLOOD_PACKETS, 0, scans);
+
+        print("flood", "single thread", reference);
+        print("flood", "receive + decode", driver);
+
+        REQUIRE(driver.packets > 0);
+        REQUIRE(driver.high_water <= DEFAULT_PACKET_RING_SIZE);
+    }
+}
+
+} // namespace fastsense::driver
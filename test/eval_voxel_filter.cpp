@@ -0,0 +1,347 @@
+/**
+ * @file eval_voxel_filter.cpp
+ *
+ * Compares the sort based reduction filters of the preprocessing with the former
+ * std::unordered_map implementation on random clouds: results and runtime.
+ * Measures the scaling of the reduction filters with the number of threads.
+ */
+
+#include <random>
+#include <chrono>
+#include <iomanip>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+
+#include <preprocessing/preprocessing.h>
+#include <util/config/config_manager.h>
+#include <util/thread_pool.h>
+
+#include "catch2_config.h"
+
+using namespace fastsense;
+using namespace fastsense::msg;
+using namespace fastsense::preprocessing;
+using fastsense::util::config::ConfigManager;
+
+namespace std
+{
+template<> struct hash<fastsense::ScanPoint>
+{
+    std::size_t operator()(fastsense::ScanPoint const& p) const noexcept
+    {
+        long long v = ((long long)p.x() << 32) ^ ((long long)p.y() << 16) ^ (long long)p.z();
+        return std::hash<long long>()(v);
+    }
+};
+}
+
+namespace fastsense::preprocessing
+{
+
+constexpr int NUM_RUNS = 20;
+
+/// map_size / 2 * MAP_RESOLUTION of the config below
+constexpr int BOUND_XY = 100 * MAP_RESOLUTION;
+constexpr int BOUND_Z = 47 * MAP_RESOLUTION;
+
+/// Former implementations with std::unordered_map
+namespace reference
+{
+
+static bool ignore(const ScanPoint& point, const ScanPoint& bounds)
+{
+    return (point.x() == 0 && point.y() == 0 && point.z() == 0) || bounds.x() < std::abs(point.x()) || bounds.y() < std::abs(point.y()) || bounds.z() < std::abs(point.z());
+}
+
+static ScanPoint voxel(const ScanPoint& point)
+{
+    return ScanPoint(std::floor((float)point.x() / MAP_RESOLUTION),
+                     std::floor((float)point.y() / MAP_RESOLUTION),
+                     std::floor((float)point.z() / MAP_RESOLUTION));
+}
+
+static void average(std::vector<ScanPoint>& cloud_points, const ScanPoint& bounds)
+{
+    std::unordered_map<ScanPoint, std::pair<Vector3i, int>> point_map;
+    point_map.reserve(cloud_points.size());
+
+    for (const auto& point : cloud_points)
+    {
+        if (ignore(point, bounds))
+        {
+            continue;
+        }
+        auto& avg_point = point_map.try_emplace(voxel(point), std::make_pair(Vector3i::Zero(), 0)).first->second;
+        avg_point.first += point.cast<int>();
+        avg_point.second++;
+    }
+
+    cloud_points.resize(point_map.size());
+    int counter = 0;
+    for (auto& avg_point : point_map)
+    {
+        cloud_points[counter++] = (avg_point.second.first / avg_point.second.second).cast<ScanPointType>();
+    }
+}
+
+static void closest(std::vector<ScanPoint>& cloud_points, const ScanPoint& bounds)
+{
+    std::unordered_map<ScanPoint, std::pair<ScanPoint, int>> point_map;
+    point_map.reserve(cloud_points.size());
+
+    for (const auto& point : cloud_points)
+    {
+        if (ignore(point, bounds))
+        {
+            continue;
+        }
+        ScanPoint voxel_center = voxel(point) * MAP_RESOLUTION + ScanPoint::Constant(MAP_RESOLUTION / 2);
+        int distance = (point - voxel_center).norm();
+
+        auto& closest = point_map.try_emplace(voxel_center, std::make_pair(ScanPoint::Zero(), MAP_RESOLUTION * 2)).first->second;
+        if (distance < closest.second)
+        {
+            closest.first = point;
+            closest.second = distance;
+        }
+    }
+
+    cloud_points.resize(point_map.size());
+    int counter = 0;
+    for (auto& point : point_map)
+    {
+        cloud_points[counter++] = point.second.first;
+    }
+}
+
+static void voxel_center(std::vector<ScanPoint>& cloud_points, const ScanPoint& bounds)
+{
+    std::unordered_set<ScanPoint> point_set;
+
+    for (const auto& point : cloud_points)
+    {
+        if (ignore(point, bounds))
+        {
+            continue;
+        }
+        point_set.insert(voxel(point) * MAP_RESOLUTION + ScanPoint::Constant(MAP_RESOLUTION / 2));
+    }
+
+    cloud_points.resize(point_set.size());
+    std::copy(point_set.begin(), point_set.end(), cloud_points.begin());
+}
+
+} // namespace reference
+
+/**
+ * @brief Random cloud in a room around the scanner with some invalid and far away points
+ */
+static std::vector<ScanPoint> random_cloud(size_t num_points)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> xy(-BOUND_XY * 3 / 2, BOUND_XY * 3 / 2);
+    std::uniform_int_distribution<int> z(-BOUND_Z, BOUND_Z);
+    std::uniform_int_distribution<int> invalid(0, 50);
+
+    std::vector<ScanPoint> points(num_points);
+    for (auto& point : points)
+    {
+        point = invalid(gen) == 0 ? ScanPoint::Zero() : ScanPoint(xy(gen), xy(gen), z(gen));
+    }
+    return points;
+}
+
+static std::vector<ScanPoint> sorted(std::vector<ScanPoint> points)
+{
+    std::sort(points.begin(), points.end(), [](const ScanPoint & a, const ScanPoint & b)
+    {
+        return std::lexicographical_compare(a.data(), a.data() + 3, b.data(), b.data() + 3);
+    });
+    return points;
+}
+
+/**
+ * @brief Average runtime of the filter in ms
+ */
+template<typename F>
+static double measure(const std::vector<ScanPoint>& points, F filter)
+{
+    double total = 0.0;
+    for (int run = 0; run < NUM_RUNS; run++)
+    {
+        std::vector<ScanPoint> copy = points;
+        auto start = std::chrono::steady_clock::now();
+        filter(copy);
+        total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return total / NUM_RUNS;
+}
+
+TEST_CASE("Eval_Voxel_Filter", "[eval_voxel_filter][slow]")
+{
+    std::cout << "Testing 'Eval Voxel Filter'" << std::endl;
+
+    ConfigManager::loadString(R"({"slam": {"map_size_x": 201, "map_size_y": 201, "map_size_z": 95}})");
+    ScanPoint bounds(BOUND_XY, BOUND_XY, BOUND_Z);
+
+    auto pointcloud_buffer = std::make_shared<PointCloudPtrStampedBuffer>(1);
+    auto pointcloud_bridge_buffer = std::make_shared<buffer::ScanBufferStampedBuffer>(1);
+    Preprocessing preprocessor{pointcloud_buffer, pointcloud_bridge_buffer, nullptr, 0, false, false};
+
+    PointCloudPtrStamped cloud;
+    cloud.data_ = std::make_shared<PointCloud>();
+
+    auto run = [&](std::vector<ScanPoint>& points, void (Preprocessing::*filter)(PointCloudPtrStamped&))
+    {
+        cloud.data_->points_.swap(points);
+        (preprocessor.*filter)(cloud);
+        cloud.data_->points_.swap(points);
+    };
+
+    std::cout << std::setw(8) << "points" << " | "
+              << std::setw(14) << "filter" << " | "
+              << std::setw(14) << "map [ms]" << " | "
+              << std::setw(14) << "sorted [ms]" << std::endl;
+
+    for (size_t num_points : {30000ul, 300000ul})
+    {
+        auto points = random_cloud(num_points);
+
+        auto print = [&](const std::string & name, double map_time, double sort_time)
+        {
+            std::cout << std::fixed << std::setprecision(3)
+                      << std::setw(8) << num_points << " | "
+                      << std::setw(14) << name << " | "
+                      << std::setw(14) << map_time << " | "
+                      << std::setw(14) << sort_time << std::endl;
+        };
+
+        SECTION("closest " + std::to_string(num_points))
+        {
+            auto expected = points;
+            auto actual = points;
+            reference::closest(expected, bounds);
+            run(actual, &Preprocessing::reduction_filter_closest);
+            REQUIRE(sorted(actual) == sorted(expected));
+
+            print("closest",
+                  measure(points, [&](auto & p) { reference::closest(p, bounds); }),
+                  measure(points, [&](auto & p) { run(p, &Preprocessing::reduction_filter_closest); }));
+        }
+
+        SECTION("average " + std::to_string(num_points))
+        {
+            auto expected = points;
+            auto actual = points;
+            reference::average(expected, bounds);
+            run(actual, &Preprocessing::reduction_filter_average);
+            REQUIRE(sorted(actual) == sorted(expected));
+
+            print("average",
+                  measure(points, [&](auto & p) { reference::average(p, bounds); }),
+                  measure(points, [&](auto & p) { run(p, &Preprocessing::reduction_filter_average); }));
+        }
+
+        SECTION("voxel center " + std::to_string(num_points))
+        {
+            auto expected = points;
+            auto actual = points;
+            reference::voxel_center(expected, bounds);
+            run(actual, &Preprocessing::reduction_filter_voxel_center);
+            REQUIRE(sorted(actual) == sorted(expected));
+
+            print("voxel center",
+                  measure(points, [&](auto & p) { reference::voxel_center(p, bounds); }),
+                  measure(points, [&](auto & p) { run(p, &Preprocessing::reduction_filter_voxel_center); }));
+        }
+
+        SECTION("random point " + std::to_string(num_points))
+        {
+            // one input point for every occupied voxel, without bounds
+            auto actual = points;
+            run(actual, &Preprocessing::reduction_filter_random_point);
+
+            std::unordered_set<ScanPoint> voxels;
+            for (const auto& point : points)
+            {
+                if (!point.isZero())
+                {
+                    voxels.insert(reference::voxel(point));
+                }
+            }
+            REQUIRE(actual.size() == voxels.size());
+
+            std::unordered_set<ScanPoint> input(points.begin(), points.end());
+            for (const auto& point : actual)
+            {
+                REQUIRE(input.count(point) == 1);
+                REQUIRE(voxels.erase(reference::voxel(point)) == 1);
+            }
+        }
+    }
+}
+
+TEST_CASE("Eval_Voxel_Filter_Scaling", "[eval_voxel_filter_scaling][slow]")
+{
+    std::cout << "Testing 'Eval Voxel Filter Scaling'" << std::endl;
+
+    ConfigManager::loadString(R"({"slam": {"map_size_x": 201, "map_size_y": 201, "map_size_z": 95}})");
+
+    auto pointcloud_buffer = std::make_shared<PointCloudPtrStampedBuffer>(1);
+    auto pointcloud_bridge_buffer = std::make_shared<buffer::ScanBufferStampedBuffer>(1);
+
+    const std::vector<std::pair<std::string, void (Preprocessing::*)(PointCloudPtrStamped&)>> filters =
+    {
+        {"closest", &Preprocessing::reduction_filter_closest},
+        {"average", &Preprocessing::reduction_filter_average},
+        {"voxel center", &Preprocessing::reduction_filter_voxel_center},
+    };
+
+    auto points = random_cloud(300000);
+
+    std::cout << std::setw(8) << "threads" << " | "
+              << std::setw(14) << "filter" << " | "
+              << std::setw(14) << "time [ms]" << " | "
+              << std::setw(8) << "speedup" << std::endl;
+
+    for (const auto& [name, filter] : filters)
+    {
+        PointCloudPtrStamped cloud;
+        cloud.data_ = std::make_shared<PointCloud>();
+
+        auto run = [&](Preprocessing & preprocessor, std::vector<ScanPoint>& p)
+        {
+            cloud.data_->points_.swap(p);
+            (preprocessor.*filter)(cloud);
+            cloud.data_->points_.swap(p);
+        };
+
+        Preprocessing single{pointcloud_buffer, pointcloud_bridge_buffer, nullptr, 0, false, false, 1.0, 1};
+        auto expected = points;
+        run(single, expected);
+        double single_time = measure(points, [&](auto & p) { run(single, p); });
+
+        for (unsigned int threads = 1; threads <= std::max(std::thread::hardware_concurrency(), 1u); threads *= 2)
+        {
+            // the calling thread works on the loops as well
+            util::ThreadPool::get_instance().configure(threads - 1);
+            Preprocessing preprocessor{pointcloud_buffer, pointcloud_bridge_buffer, nullptr, 0, false, false, 1.0, threads};
+
+            // every partition holds whole voxels, so the result does not depend on the number of threads
+            auto actual = points;
+            run(preprocessor, actual);
+            REQUIRE(sorted(actual) == sorted(expected));
+
+            double time = measure(points, [&](auto & p) { run(preprocessor, p); });
+            std::cout << std::fixed << std::setprecision(3)
+                      << std::setw(8) << threads << " | "
+                      << std::setw(14) << name << " | "
+                      << std::setw(14) << time << " | "
+                      << std::setw(8) << single_time / time << std::endl;
+        }
+    }
+    util::ThreadPool::get_instance().configure(0);
+}
+
+} // namespace fastsense::preprocessing
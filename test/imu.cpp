@@ -2,6 +2,8 @@
 #include <msg/imu.h>
 #include <util/filter.h>
 
+#include <cmath>
+
 using namespace fastsense;
 using namespace fastsense::util;
 
@@ -123,3 +125,93 @@ TEST_CASE("Moving Average Filter Imu", "[MovAvgFilter]")
     // back(): 2.
     REQUIRE_IMU(filter.get_buffer().back(), 2.);
 }
+
+TEST_CASE("Moving Average Filter Compensated", "[MovAvgFilter]")
+{
+    // float values that can not be represented exactly: the plain running mean drifts away
+    constexpr size_t window_size = 10;
+    constexpr size_t updates = 1000000;
+
+    SlidingWindowFilter<float> plain(window_size);
+    SlidingWindowFilter<float> compensated(window_size, true);
+
+    for (size_t i = 0; i < updates; i++)
+    {
+        float value = (i % 7) * 0.1f + 0.3f;
+        plain.update(value);
+        compensated.update(value);
+    }
+
+    double exact = 0.0;
+    for (size_t i = 0; i < window_size; i++)
+    {
+        exact += compensated.get_buffer()[i];
+    }
+    exact /= window_size;
+
+    REQUIRE(compensated.get_buffer().size() == window_size);
+    REQUIRE(std::abs(compensated.get_mean() - exact) < 1e-5);
+    REQUIRE(std::abs(compensated.get_mean() - exact) <= std::abs(plain.get_mean() - exact));
+}
+
+TEST_CASE("Filter Window", "[MovAvgFilter]")
+{
+    FilterWindow<int> window(3);
+    REQUIRE(window.capacity() == 3);
+    REQUIRE(window.size() == 0);
+
+    window.push(1);
+    window.push(2);
+    REQUIRE(window.size() == 2);
+    REQUIRE(!window.full());
+    REQUIRE(window.front() == 1);
+    REQUIRE(window.back() == 2);
+
+    window.push(3);
+    window.push(4);
+    REQUIRE(window.full());
+    REQUIRE(window.size() == 3);
+    REQUIRE(window.front() == 2);
+    REQUIRE(window[1] == 3);
+    REQUIRE(window.back() == 4);
+}
+
+TEST_CASE("Sliding Median Filter", "[MedianFilter]")
+{
+    SlidingMedianFilter<double> filter(3);
+
+    REQUIRE(filter.update(5.) == 5.);
+    // upper one of the two middle values
+    REQUIRE(filter.update(1.) == 5.);
+    REQUIRE(filter.update(3.) == 3.);
+
+    // 5 leaves the window: 1, 3, 100
+    REQUIRE(filter.update(100.) == 3.);
+    // 1 leaves the window: 3, 100, 2
+    REQUIRE(filter.update(2.) == 3.);
+    // 3 leaves the window: 100, 2, 2
+    REQUIRE(filter.update(2.) == 2.);
+    REQUIRE(filter.get_median() == 2.);
+    REQUIRE(filter.get_buffer().size() == 3);
+
+    SlidingMedianFilter<double> disabled(1);
+    REQUIRE(disabled.update(4.) == 4.);
+    REQUIRE(disabled.update(7.) == 7.);
+}
+
+TEST_CASE("Exponential Filter", "[ExpFilter]")
+{
+    REQUIRE_THROWS(ExponentialFilter<double>(0.0));
+    REQUIRE_THROWS(ExponentialFilter<double>(1.5));
+
+    ExponentialFilter<double> filter(0.25);
+    REQUIRE(filter.update(4.) == 4.);
+    REQUIRE(filter.update(8.) == Approx(5.));
+    REQUIRE(filter.update(1.) == Approx(4.));
+    REQUIRE(filter.get_mean() == Approx(4.));
+
+    ExponentialFilter<msg::Imu> imu_filter(0.5);
+    imu_filter.update(IMU_WITH_VAL(2.));
+    auto mean = imu_filter.update(IMU_WITH_VAL(4.));
+    REQUIRE_IMU(mean, 3.);
+}
@@ -176,7 +176,9 @@ TEST_CASE("Kernel", "[kernel][slow]")
     // Dummy for the IMU (nut used in this test)
     auto buffer = std::make_shared<msg::ImuStampedBuffer>(0);
     // Initialize the registration
-    fastsense::registration::Registration reg(q, buffer, MAX_ITERATIONS);
+    fastsense::registration::RegistrationOptions options;
+    options.max_iterations = MAX_ITERATIONS;
+    fastsense::registration::Registration reg(q, buffer, options);
 
     // Read the recorded scan
 
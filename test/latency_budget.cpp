@@ -0,0 +1,132 @@
+/**
+ * @file latency_budget.cpp
+ */
+
+#include "catch2_config.h"
+#include <registration/latency_budget.h>
+#include <util/scan_age.h>
+#include <msg/point_cloud.h>
+
+#include <iostream>
+#include <thread>
+
+using namespace fastsense::registration;
+using namespace fastsense::util;
+using namespace std::chrono_literals;
+
+TEST_CASE("LatencyBudget", "[latency_budget]")
+{
+    std::cout << "Testing 'LatencyBudget'" << std::endl;
+
+    SECTION("Disabled")
+    {
+        LatencyBudget budget(0.0f, 20, 1000);
+        REQUIRE(!budget.enabled());
+        budget.update(10.0f, 10000, 100);
+        auto plan = budget.plan(500.0f, 3, 10000, 200);
+        REQUIRE(plan.level == DeadlineLevel::FULL);
+        REQUIRE(plan.iterations == 200);
+        REQUIRE(plan.points == 0);
+    }
+
+    SECTION("Full registration without a runtime estimate")
+    {
+        LatencyBudget budget(100.0f, 20, 1000);
+        REQUIRE(budget.cost() == 0.0f);
+        REQUIRE(budget.plan(90.0f, 0, 10000, 200).level == DeadlineLevel::FULL);
+    }
+
+    SECTION("Degrade iterations before points")
+    {
+        LatencyBudget budget(100.0f, 20, 1000);
+        // 1e-5 ms per point and iteration: 20 ms for 10000 points and 200 iterations
+        budget.update(10.0f, 10000, 100);
+        REQUIRE(budget.cost() == Approx(1e-5f));
+
+        auto plan = budget.plan(50.0f, 0, 10000, 200);
+        REQUIRE(plan.level == DeadlineLevel::FULL);
+
+        plan = budget.plan(90.0f, 0, 10000, 200);
+        REQUIRE(plan.level == DeadlineLevel::FEWER_ITERATIONS);
+        REQUIRE(plan.iterations >= 99);
+        REQUIRE(plan.iterations <= 100);
+        REQUIRE(plan.points == 0);
+
+        plan = budget.plan(99.0f, 0, 10000, 200);
+        REQUIRE(plan.level == DeadlineLevel::FEWER_POINTS);
+        REQUIRE(plan.iterations == 20);
+        REQUIRE(plan.points >= 4990);
+        REQUIRE(plan.points <= 5000);
+
+        // never below the minimum number of points
+        plan = budget.plan(99.99f, 0, 10000, 200);
+        REQUIRE(plan.level == DeadlineLevel::FEWER_POINTS);
+        REQUIRE(plan.points == 1000);
+    }
+
+    SECTION("Drop late scans only if a newer one is waiting")
+    {
+        LatencyBudget budget(100.0f, 20, 1000);
+        budget.update(10.0f, 10000, 100);
+
+        auto plan = budget.plan(120.0f, 0, 10000, 200);
+        REQUIRE(plan.level == DeadlineLevel::FEWER_POINTS);
+        REQUIRE(plan.iterations == 20);
+        REQUIRE(plan.points == 1000);
+
+        // at most two drops in a row
+        REQUIRE(budget.plan(120.0f, 1, 10000, 200).level == DeadlineLevel::DROP);
+        REQUIRE(budget.plan(120.0f, 1, 10000, 200).level == DeadlineLevel::DROP);
+        REQUIRE(budget.plan(120.0f, 1, 10000, 200).level == DeadlineLevel::FEWER_POINTS);
+        REQUIRE(budget.plan(120.0f, 1, 10000, 200).level == DeadlineLevel::DROP);
+
+        // a scan in time resets the count
+        REQUIRE(budget.plan(10.0f, 1, 10000, 200).level == DeadlineLevel::FULL);
+        REQUIRE(budget.plan(120.0f, 1, 10000, 200).level == DeadlineLevel::DROP);
+    }
+
+    SECTION("Runtime estimate follows the measurements")
+    {
+        LatencyBudget budget(100.0f, 20, 1000);
+        budget.update(10.0f, 10000, 100);
+        for (int i = 0; i < 50; i++)
+        {
+            budget.update(20.0f, 10000, 100);
+        }
+        REQUIRE(budget.cost() == Approx(2e-5f).epsilon(0.01));
+
+        // invalid measurements are ignored
+        budget.update(10.0f, 0, 100);
+        budget.update(10.0f, 10000, 0);
+        REQUIRE(budget.cost() == Approx(2e-5f).epsilon(0.01));
+    }
+}
+
+TEST_CASE("ScanAge", "[scan_age]")
+{
+    std::cout << "Testing 'ScanAge'" << std::endl;
+
+    ScanAge age("test_stage");
+    REQUIRE(age.count() == 0);
+    REQUIRE(age.mean() == 0.0f);
+
+    auto now = SteadyTime::now();
+    REQUIRE(ScanAge::since(now - 30ms, now) == Approx(30.0f));
+
+    float first = age.add(SteadyTime::now() - 10ms);
+    float second = age.add(SteadyTime::now() - 30ms);
+    REQUIRE(first >= 10.0f);
+    REQUIRE(second >= 30.0f);
+    REQUIRE(age.count() == 2);
+    REQUIRE(age.max() == second);
+    REQUIRE(age.mean() == Approx((first + second) / 2));
+    REQUIRE(age.to_string().find("test_stage") != std::string::npos);
+
+    age.reset();
+    REQUIRE(age.count() == 0);
+    REQUIRE(age.max() == 0.0f);
+
+    // a replayed scan keeps its old sensor timestamp, but its age starts when it enters the pipeline
+    fastsense::msg::PointCloudPtrStamped replayed{std::make_shared<fastsense::msg::PointCloud>(), HighResTime::now() - std::chrono::hours(24 * 365)};
+    REQUIRE(ScanAge::since(replayed.data_->arrival_) < 1000.0f);
+}
@@ -0,0 +1,126 @@
+/**
+ * @file lm_solver.cpp
+ *
+ * Tests the step control of the Levenberg-Marquardt solver on a synthetic room
+ */
+
+#include <registration/lm_solver.h>
+#include <hw/fpga_manager.h>
+
+#include <eigen3/Eigen/Geometry>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "catch2_config.h"
+
+using namespace fastsense;
+using namespace fastsense::map;
+using namespace fastsense::registration;
+
+/// Truncation distance of the synthetic TSDF
+constexpr float ROOM_TAU = 600;
+
+/// Signed distance to the walls, the floor and the ceiling of a room around the origin
+static float room_distance(const Vector3f& p)
+{
+    return std::min({2000 - std::abs(p.x()), 1500 - std::abs(p.y()), p.z() + 400, 600 - p.z()});
+}
+
+/// Fill the map with the truncated signed distance of the room
+static void fill_room(LocalMap& map)
+{
+    for (int x = -40; x <= 40; x++)
+    {
+        for (int y = -40; y <= 40; y++)
+        {
+            for (int z = -15; z <= 15; z++)
+            {
+                Vector3f center = (Vector3f(x, y, z) * MAP_RESOLUTION).array() + MAP_RESOLUTION / 2;
+                float distance = room_distance(center);
+                if (distance >= -ROOM_TAU)
+                {
+                    map.value(x, y, z) = TSDFEntry(std::min(distance, ROOM_TAU), 1);
+                }
+            }
+        }
+    }
+}
+
+/// Points of a 16 ring scan of the room from the origin
+static std::vector<Vector3f> scan_room()
+{
+    std::vector<Vector3f> points;
+    for (int ring = 0; ring < 16; ring++)
+    {
+        for (int step = 0; step < 1800; step++)
+        {
+            float elevation = (-15 + 2 * ring) * M_PI / 180;
+            float azimuth = step * 2 * M_PI / 1800;
+            Vector3f direction(std::cos(elevation) * std::cos(azimuth), std::cos(elevation) * std::sin(azimuth), std::sin(elevation));
+            for (float range = 100; range < 5000; range += 5)
+            {
+                if (room_distance(direction * range) < 0)
+                {
+                    points.push_back(direction * range);
+                    break;
+                }
+            }
+        }
+    }
+    return points;
+}
+
+TEST_CASE("LMSolver", "[lm_solver]")
+{
+    std::cout << "Testing 'LMSolver'" << std::endl;
+
+    auto q = hw::FPGAManager::create_command_queue();
+    auto global_map = std::make_shared<GlobalMap>("LMSolverTest.h5", 0, 0);
+    LocalMap map(81, 81, 31, global_map, q);
+    fill_room(map);
+
+    // the scan is taken from a pose that is slightly moved and rotated against the map
+    Matrix4f offset = Matrix4f::Identity();
+    offset.block<3, 3>(0, 0) = Eigen::AngleAxisf(0.02, Vector3f::UnitZ()).toRotationMatrix();
+    offset.block<3, 1>(0, 3) = Vector3f(50, -35, 20);
+    Matrix4f inverse = offset.inverse();
+
+    auto points = scan_room();
+    buffer::InputBuffer<PointHW> cloud(q, points.size());
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        Vector3f point = inverse.block<3, 3>(0, 0) * points[i] + inverse.block<3, 1>(0, 3);
+        cloud[i] = PointHW(point.x(), point.y(), point.z());
+    }
+    int num_points = points.size();
+
+    SECTION("A rejected step does not converge")
+    {
+        constexpr float DAMPING = 0.001;
+
+        // the first step with the initial damping overshoots
+        LMSolver::System start, trial;
+        LMSolver::build_system(map, cloud, num_points, Matrix4f::Identity(), start);
+        LMSolver::Matrix6d h = start.h;
+        h.diagonal() *= 1.0 + DAMPING;
+        LMSolver::Vector6d xi = h.ldlt().solve(-start.g);
+        LMSolver::build_system(map, cloud, num_points, LMSolver::xi_to_transform(xi, Vector3f::Zero()), trial);
+        REQUIRE(trial.cost() > start.cost());
+
+        // every step is below the epsilons, so the first accepted step ends the solve
+        LMSolver solver(50, DAMPING, 1e6, 1e6);
+        Matrix4f pose = Matrix4f::Identity();
+        float error;
+        int iterations = solver.solve(map, cloud, num_points, pose, error);
+
+        REQUIRE(iterations > 1);
+        REQUIRE(iterations < 50);
+        REQUIRE(!pose.isIdentity());
+
+        LMSolver::System result;
+        LMSolver::build_system(map, cloud, num_points, pose, result);
+        REQUIRE(result.cost() < start.cost());
+    }
+}
@@ -0,0 +1,161 @@
+/**
+ * @file local_map_snapshots.cpp
+ */
+
+#include <map/local_map_snapshots.h>
+#include <hw/fpga_manager.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "catch2_config.h"
+
+using namespace fastsense::map;
+using namespace fastsense::hw;
+using Eigen::Vector3i;
+
+/// set every cell of the map to the value
+static void fill(LocalMap& map, int value)
+{
+    auto& buffer = map.getBuffer();
+    for (size_t i = 0; i < buffer.size(); i++)
+    {
+        buffer[i] = TSDFEntry(value, 1);
+    }
+}
+
+/// whether every cell of the map has the same value
+static bool consistent(LocalMap& map)
+{
+    const auto& buffer = map.getBuffer();
+    for (size_t i = 1; i < buffer.size(); i++)
+    {
+        if (buffer[i].value() != buffer[0].value())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("Local_Map_Snapshots", "[local_map_snapshots]")
+{
+    std::cout << "Testing 'Local Map Snapshots'" << std::endl;
+
+    auto global_map = std::make_shared<GlobalMap>("LocalMapSnapshotsTest.h5", 0, 0);
+    auto q = FPGAManager::create_command_queue();
+    auto initial = std::make_unique<LocalMap>(5, 5, 5, global_map, q);
+    fill(*initial, 0);
+    LocalMapSnapshots snapshots(std::move(initial));
+
+    SECTION("Pinned versions stay unchanged")
+    {
+        auto first = snapshots.pin();
+        REQUIRE(first.version() == 0);
+        REQUIRE(first->value(0, 0, 0).value() == 0);
+
+        LocalMap& update = snapshots.begin_update();
+        REQUIRE(&update != &first.map());
+        fill(update, 1);
+
+        // not published yet
+        REQUIRE(snapshots.pin()->value(0, 0, 0).value() == 0);
+
+        REQUIRE(snapshots.publish() == 1);
+        REQUIRE(snapshots.version() == 1);
+
+        auto second = snapshots.pin();
+        REQUIRE(second.version() == 1);
+        REQUIRE(second->value(0, 0, 0).value() == 1);
+
+        // the first version is pinned, so the next updates use the third copy
+        for (int value = 2; value < 5; value++)
+        {
+            second.release();
+            LocalMap& next = snapshots.begin_update();
+            REQUIRE(&next != &first.map());
+            REQUIRE(next.value(0, 0, 0).value() == value - 1);
+            fill(next, value);
+            snapshots.publish();
+            second = snapshots.pin();
+        }
+
+        REQUIRE(first.version() == 0);
+        REQUIRE(first->value(0, 0, 0).value() == 0);
+        REQUIRE(consistent(*first));
+        REQUIRE(second->value(0, 0, 0).value() == 4);
+        REQUIRE(snapshots.update_waits() == 0);
+    }
+
+    SECTION("An update sleeps until an old version is released")
+    {
+        // two readers pin the two old versions, the third copy is the current one
+        auto first = snapshots.pin();
+        snapshots.begin_update();
+        snapshots.publish();
+        auto second = snapshots.pin();
+        snapshots.begin_update();
+        snapshots.publish();
+
+        std::atomic<bool> updated{false};
+        LocalMap* update = nullptr;
+        std::thread writer([&]()
+        {
+            update = &snapshots.begin_update();
+            updated = true;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        REQUIRE(!updated);
+        REQUIRE(snapshots.update_waits() > 0);
+
+        LocalMap* released = &second.map();
+        second.release();
+        writer.join();
+        REQUIRE(updated);
+        REQUIRE(update == released);
+        REQUIRE(first.version() == 0);
+    }
+
+    SECTION("Publish needs an update")
+    {
+        REQUIRE_THROWS(snapshots.publish());
+        snapshots.begin_update();
+        snapshots.publish();
+        REQUIRE_THROWS(snapshots.publish());
+    }
+
+    SECTION("Readers never see a partial update")
+    {
+        constexpr int UPDATES = 200;
+        std::atomic<bool> done{false};
+        bool all_consistent = true;
+        uint64_t last_version = 0;
+        bool monotonic = true;
+
+        std::thread reader([&]()
+        {
+            while (!done)
+            {
+                auto map = snapshots.pin();
+                all_consistent &= consistent(*map);
+                monotonic &= map.version() >= last_version;
+                last_version = map.version();
+            }
+        });
+
+        for (int value = 1; value <= UPDATES; value++)
+        {
+            fill(snapshots.begin_update(), value);
+            snapshots.publish();
+        }
+        done = true;
+        reader.join();
+
+        REQUIRE(all_consistent);
+        REQUIRE(monotonic);
+        REQUIRE(snapshots.version() == UPDATES);
+        REQUIRE(snapshots.pin()->value(0, 0, 0).value() == UPDATES);
+    }
+}
@@ -0,0 +1,314 @@
+/**
+ * @file lock_free_ring_buffer.cpp
+ */
+
+#include "catch2_config.h"
+#include <util/lock_free_ring_buffer.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <numeric>
+#include <thread>
+
+using namespace fastsense::util;
+
+TEMPLATE_TEST_CASE("LockFreeRingBuffer", "[LockFreeRingBuffer]", SpscRingBuffer<size_t>, MpmcRingBuffer<size_t>)
+{
+    std::cout << "Test Lock Free Ringbuffer\n";
+
+    constexpr size_t buffer_size = 5;
+
+    TestType rb(buffer_size);
+
+    REQUIRE(rb.size() == 0);
+    REQUIRE(rb.capacity() == buffer_size);
+    REQUIRE(rb.empty());
+
+    for (size_t i = 0; i < buffer_size; ++i)
+    {
+        rb.push(i);
+    }
+
+    REQUIRE(rb.size() == buffer_size);
+    REQUIRE(rb.full());
+
+    SECTION("Test push_nb, pop, and pop_nb")
+    {
+        std::cout << "    Section 'Test push_nb, pop, and pop_nb'" << std::endl;
+
+        // the oldest element is dropped by a forced push
+        REQUIRE(!rb.push_nb(0));
+        REQUIRE(rb.push_nb(buffer_size, true));
+
+        size_t val;
+        rb.pop(&val);
+        REQUIRE(val == 1);
+        REQUIRE(rb.size() == buffer_size - 1);
+
+        for (size_t i = 2; i <= buffer_size; i++)
+        {
+            REQUIRE(rb.pop_nb(&val));
+            REQUIRE(val == i);
+            REQUIRE(rb.size() == buffer_size - i);
+        }
+
+        REQUIRE(rb.empty());
+        REQUIRE(!rb.pop_nb(&val));
+
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(!rb.pop_nb(&val, 50));
+        REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+    }
+
+    SECTION("Test clear")
+    {
+        std::cout << "    Section 'clear'" << std::endl;
+
+        rb.clear();
+        REQUIRE(rb.size() == 0);
+        REQUIRE(rb.empty());
+
+        // the positions continue after a clear
+        rb.push(42);
+        size_t val;
+        REQUIRE(rb.pop_nb(&val));
+        REQUIRE(val == 42);
+    }
+
+    SECTION("Test multithreading")
+    {
+        std::cout << "    Section 'Test multithreading'" << std::endl;
+
+        size_t val;
+
+        // test waiting to push
+        std::thread push_thread{[&]()
+        {
+            rb.push(buffer_size);
+        }};
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        rb.pop(&val);
+        push_thread.join();
+
+        REQUIRE(val == 0);
+        REQUIRE(rb.full());
+
+        // test waiting to pop and the wake up of a timed pop
+        rb.clear();
+
+        std::thread push_thread2{[&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            rb.push(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            rb.push(2);
+        }};
+
+        rb.pop(&val);
+        REQUIRE(val == 1);
+        REQUIRE(rb.pop_nb(&val, 10000));
+        REQUIRE(val == 2);
+        push_thread2.join();
+
+        // test the wake up of a blocked push by clear
+        for (size_t i = 0; i < buffer_size; ++i)
+        {
+            rb.push(i);
+        }
+        std::thread push_thread3{[&]()
+        {
+            rb.push(buffer_size);
+        }};
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        rb.clear();
+        push_thread3.join();
+        REQUIRE(rb.pop_nb(&val, 1000));
+        REQUIRE(val == buffer_size);
+    }
+
+    // after all these changes, capcity should not change
+    REQUIRE(rb.capacity() == buffer_size);
+}
+
+TEMPLATE_TEST_CASE("LockFreeRingBuffer_Move", "[LockFreeRingBuffer]", SpscRingBuffer<std::unique_ptr<int>>, MpmcRingBuffer<std::unique_ptr<int>>)
+{
+    std::cout << "Test Lock Free Ringbuffer Move\n";
+
+    TestType rb(2);
+
+    auto first = std::make_unique<int>(1);
+    REQUIRE(rb.push_nb(std::move(first)));
+    REQUIRE(first == nullptr);
+    rb.push(std::make_unique<int>(2));
+
+    // a failed push leaves the element untouched
+    auto third = std::make_unique<int>(3);
+    REQUIRE(!rb.push_nb(std::move(third)));
+    REQUIRE(third != nullptr);
+
+    // the dropped element is destroyed
+    REQUIRE(rb.push_nb(std::move(third), true));
+
+    std::unique_ptr<int> val;
+    REQUIRE(rb.pop_nb(&val));
+    REQUIRE(*val == 2);
+    rb.pop(&val);
+    REQUIRE(*val == 3);
+}
+
+TEST_CASE("MpmcRingBuffer_Threads", "[LockFreeRingBuffer]")
+{
+    std::cout << "Test Mpmc Ringbuffer Threads\n";
+
+    constexpr size_t num_threads = 4;
+    constexpr size_t num_values = 20000;
+
+    MpmcRingBuffer<size_t> rb(16);
+    std::vector<size_t> sums(num_threads, 0);
+    std::vector<size_t> counts(num_threads, 0);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (size_t i = 1; i <= num_values; i++)
+            {
+                rb.push(i);
+            }
+        });
+        threads.emplace_back([&, t]()
+        {
+            size_t val;
+            for (size_t i = 0; i < num_values; i++)
+            {
+                rb.pop(&val);
+                sums[t] += val;
+                counts[t]++;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    // every value is popped exactly once
+    REQUIRE(std::accumulate(counts.begin(), counts.end(), size_t(0)) == num_threads * num_values);
+    REQUIRE(std::accumulate(sums.begin(), sums.end(), size_t(0)) == num_threads * num_values * (num_values + 1) / 2);
+    REQUIRE(rb.empty());
+}
+
+/**
+ * @brief Element whose move assignment can be slow, to keep the slot of a pop in flight
+ */
+struct SlowMove
+{
+    SlowMove(size_t value = 0, bool slow = false)
+        : value{value},
+          slow{slow}
+    {
+    }
+
+    SlowMove(const SlowMove& other) = default;
+
+    SlowMove& operator=(const SlowMove& other)
+    {
+        value = other.value;
+        return *this;
+    }
+
+    SlowMove& operator=(SlowMove&& other)
+    {
+        if (slow)
+        {
+            moving = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        value = other.value;
+        return *this;
+    }
+
+    size_t value;
+    /// only the target of the consumer is slow, the slots are not
+    bool slow;
+    static std::atomic<bool> moving;
+};
+
+std::atomic<bool> SlowMove::moving{false};
+
+TEMPLATE_TEST_CASE("LockFreeRingBuffer_ForcedPush", "[LockFreeRingBuffer]", SpscRingBuffer<SlowMove>, MpmcRingBuffer<SlowMove>)
+{
+    std::cout << "Test Lock Free Ringbuffer forced push\n";
+
+    constexpr size_t buffer_size = 4;
+    TestType rb(buffer_size);
+
+    SECTION("A slot in flight is waited for instead of dropping elements")
+    {
+        for (size_t i = 0; i < buffer_size; i++)
+        {
+            rb.push(SlowMove(i));
+        }
+
+        SlowMove::moving = false;
+        SlowMove popped(100, true);
+        std::thread consumer([&]()
+        {
+            rb.pop(&popped);
+        });
+
+        // the consumer has claimed the first slot, but did not release it yet
+        while (!SlowMove::moving)
+        {
+            std::this_thread::yield();
+        }
+        REQUIRE(rb.push_nb(SlowMove(buffer_size), true));
+        consumer.join();
+        REQUIRE(popped.value == 0);
+
+        // nothing was dropped
+        REQUIRE(rb.size() == buffer_size);
+        SlowMove val;
+        for (size_t i = 1; i <= buffer_size; i++)
+        {
+            REQUIRE(rb.pop_nb(&val));
+            REQUIRE(val.value == i);
+        }
+    }
+
+    SECTION("Contended forced pushes drop at most one element each")
+    {
+        constexpr size_t num_values = 20000;
+
+        std::atomic<bool> done{false};
+        std::vector<size_t> received;
+        std::thread consumer([&]()
+        {
+            SlowMove val;
+            while (!done || !rb.empty())
+            {
+                if (rb.pop_nb(&val, 1))
+                {
+                    received.push_back(val.value);
+                }
+            }
+        });
+
+        for (size_t i = 1; i <= num_values; i++)
+        {
+            REQUIRE(rb.push_nb(SlowMove(i), true));
+            REQUIRE(rb.size() <= buffer_size);
+        }
+        done = true;
+        consumer.join();
+
+        // the values arrive in order, the newest ones are never dropped
+        REQUIRE(!received.empty());
+        REQUIRE(std::is_sorted(received.begin(), received.end()));
+        REQUIRE(std::adjacent_find(received.begin(), received.end()) == received.end());
+        REQUIRE(received.back() == num_values);
+        REQUIRE(received.size() >= buffer_size);
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ * @file map_update_scheduler.cpp
+ */
+
+#include <callback/map_update_scheduler.h>
+#include <hw/fpga_manager.h>
+
+#include <chrono>
+#include <thread>
+
+#include "catch2_config.h"
+
+using namespace fastsense;
+using namespace fastsense::buffer;
+using namespace fastsense::callback;
+using namespace std::chrono_literals;
+
+static MapUpdate make_update(const ScanBufferPool::Ptr& pool, int x)
+{
+    return MapUpdate{Eigen::Vector3i(x, 0, 0), Eigen::Matrix4f::Identity(), pool->acquire(10), fastsense::util::SteadyTime::now()};
+}
+
+TEST_CASE("Map_Update_Scheduler", "[map_update_scheduler]")
+{
+    std::cout << "Testing 'Map Update Scheduler'" << std::endl;
+
+    auto q = hw::FPGAManager::create_command_queue();
+    auto pool = std::make_shared<ScanBufferPool>(q);
+    util::StopSource stop;
+    std::vector<MapUpdate> batch;
+
+    SECTION("Scans during an update are coalesced")
+    {
+        MapUpdateScheduler scheduler(4);
+
+        REQUIRE_FALSE(scheduler.submit(make_update(pool, 1)));
+        REQUIRE(scheduler.take(batch, stop.get_token()));
+        REQUIRE(batch.size() == 1);
+
+        // the update of the first scan is running
+        REQUIRE_FALSE(scheduler.submit(make_update(pool, 2)));
+        REQUIRE_FALSE(scheduler.submit(make_update(pool, 3)));
+        REQUIRE(scheduler.pending() == 2);
+
+        REQUIRE(scheduler.take(batch, stop.get_token()));
+        REQUIRE(batch.size() == 2);
+        REQUIRE(batch[0].pos.x() == 2);
+        REQUIRE(batch[1].pos.x() == 3);
+        REQUIRE(scheduler.pending() == 0);
+
+        auto stats = scheduler.stats();
+        REQUIRE(stats.submitted == 3);
+        REQUIRE(stats.integrated == 3);
+        REQUIRE(stats.dropped == 0);
+        REQUIRE(stats.batches == 2);
+    }
+
+    SECTION("A full batch drops the oldest scan")
+    {
+        MapUpdateScheduler scheduler(2);
+
+        REQUIRE_FALSE(scheduler.submit(make_update(pool, 1)));
+        REQUIRE_FALSE(scheduler.submit(make_update(pool, 2)));
+        REQUIRE(scheduler.submit(make_update(pool, 3)));
+
+        REQUIRE(scheduler.take(batch, stop.get_token()));
+        REQUIRE(batch.size() == 2);
+        REQUIRE(batch[0].pos.x() == 2);
+        REQUIRE(batch[1].pos.x() == 3);
+
+        // the dropped scan returned its buffer to the pool
+        batch.clear();
+        pool->acquire(10);
+        REQUIRE(pool->allocations() == 3);
+
+        scheduler.submit(make_update(pool, 4));
+        scheduler.clear();
+
+        auto stats = scheduler.stats();
+        REQUIRE(stats.submitted == 4);
+        REQUIRE(stats.integrated == 2);
+        REQUIRE(stats.dropped == 2);
+        REQUIRE(stats.batches == 1);
+    }
+
+    SECTION("Take waits for a scan and wakes up on stop")
+    {
+        MapUpdateScheduler scheduler(4);
+
+        std::thread producer([&]()
+        {
+            std::this_thread::sleep_for(50ms);
+            scheduler.submit(make_update(pool, 1));
+        });
+        REQUIRE(scheduler.take(batch, stop.get_token()));
+        REQUIRE(batch.size() == 1);
+        producer.join();
+
+        std::thread stopper([&]()
+        {
+            std::this_thread::sleep_for(50ms);
+            stop.request_stop();
+        });
+        REQUIRE_FALSE(scheduler.take(batch, stop.get_token()));
+        REQUIRE(batch.empty());
+        stopper.join();
+    }
+}
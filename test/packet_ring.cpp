@@ -0,0 +1,105 @@
+/**
+ * @file packet_ring.cpp
+ */
+
+#include "catch2_config.h"
+#include <driver/lidar/packet_ring.h>
+#include <iostream>
+#include <thread>
+
+using namespace fastsense::driver;
+
+TEST_CASE("PacketRing", "[PacketRing]")
+{
+    std::cout << "Test Packet Ring\n";
+
+    PacketRing<size_t> ring(5);
+
+    std::cout << "    Section 'Test capacity, commit, release'" << std::endl;
+    REQUIRE(ring.capacity() == 8);
+    REQUIRE(ring.writable() == 8);
+    REQUIRE(ring.readable() == 0);
+
+    for (size_t i = 0; i < 6; i++)
+    {
+        ring.write_slot(i) = i;
+    }
+    ring.commit(6);
+    REQUIRE(ring.writable() == 2);
+    REQUIRE(ring.readable() == 6);
+    REQUIRE(ring.high_water() == 6);
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        REQUIRE(ring.read_slot(i) == i);
+    }
+    ring.release(4);
+    REQUIRE(ring.readable() == 2);
+    REQUIRE(ring.writable() == 6);
+
+    // wrap around
+    for (size_t i = 0; i < 6; i++)
+    {
+        ring.write_slot(i) = 6 + i;
+    }
+    ring.commit(6);
+    REQUIRE(ring.writable() == 0);
+    REQUIRE(ring.high_water() == 8);
+    for (size_t i = 0; i < 8; i++)
+    {
+        REQUIRE(ring.read_slot(i) == 4 + i);
+    }
+    ring.release(8);
+
+    SECTION("Test wait_readable")
+    {
+        std::cout << "    Section 'Test wait_readable'" << std::endl;
+        REQUIRE(ring.wait_readable(std::chrono::milliseconds(10)) == 0);
+
+        std::thread producer([&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            ring.write_slot(0) = 42;
+            ring.commit(1);
+        });
+        REQUIRE(ring.wait_readable(std::chrono::seconds(5)) == 1);
+        REQUIRE(ring.read_slot(0) == 42);
+        ring.release(1);
+        producer.join();
+    }
+
+    SECTION("Test producer and consumer thread")
+    {
+        std::cout << "    Section 'Test producer and consumer thread'" << std::endl;
+        constexpr size_t num_values = 100000;
+
+        std::thread producer([&]()
+        {
+            size_t value = 0;
+            while (value < num_values)
+            {
+                size_t count = std::min(ring.writable(), num_values - value);
+                for (size_t i = 0; i < count; i++)
+                {
+                    ring.write_slot(i) = value++;
+                }
+                ring.commit(count);
+            }
+        });
+
+        // every value arrives once and in order
+        size_t expected = 0;
+        while (expected < num_values)
+        {
+            size_t count = ring.wait_readable(std::chrono::seconds(5));
+            REQUIRE(count > 0);
+            for (size_t i = 0; i < count; i++)
+            {
+                REQUIRE(ring.read_slot(i) == expected++);
+            }
+            ring.release(count);
+        }
+        producer.join();
+        REQUIRE(ring.readable() == 0);
+    }
+}
@@ -0,0 +1,142 @@
+/**
+ * @file point_cloud_pool.cpp
+ */
+
+#include <msg/point_cloud_pool.h>
+#include <driver/lidar/velodyne_decoder.h>
+
+#include "catch2_config.h"
+#include "alloc_counter.h"
+
+using namespace fastsense;
+using namespace fastsense::msg;
+using namespace fastsense::driver;
+
+using fastsense::test::heap_allocations;
+
+TEST_CASE("Point_Cloud_Pool", "[point_cloud_pool]")
+{
+    std::cout << "Testing 'Point Cloud Pool'" << std::endl;
+
+    auto pool = std::make_shared<PointCloudPool>(2, 100);
+    REQUIRE(pool->allocations() == 2);
+    REQUIRE(pool->available() == 2);
+
+    SECTION("Clouds are reused and reset")
+    {
+        PointCloud* first;
+        {
+            auto cloud = pool->acquire();
+            REQUIRE(cloud->points_.empty());
+            REQUIRE(cloud->points_.capacity() >= 100);
+            REQUIRE(pool->available() == 1);
+
+            cloud->points_.resize(200);
+            cloud->rings_ = 16;
+            cloud->scaling_ = 2.0f;
+            first = cloud.get();
+        }
+        REQUIRE(pool->available() == 2);
+
+        // the last released cloud is reused first and keeps its memory
+        auto cloud = pool->acquire();
+        REQUIRE(cloud.get() == first);
+        REQUIRE(cloud->points_.empty());
+        REQUIRE(cloud->points_.capacity() >= 200);
+        REQUIRE(cloud->rings_ == 0);
+        REQUIRE(cloud->scaling_ == 1.0f);
+        REQUIRE(pool->allocations() == 2);
+    }
+
+    SECTION("The pool grows when all clouds are in use")
+    {
+        auto a = pool->acquire();
+        auto b = pool->acquire();
+        auto c = pool->acquire();
+        REQUIRE(pool->allocations() == 3);
+        REQUIRE(pool->available() == 0);
+
+        a.reset();
+        b.reset();
+        c.reset();
+        REQUIRE(pool->available() == 3);
+    }
+
+    SECTION("Clouds outlive the pool")
+    {
+        auto cloud = pool->acquire();
+        pool.reset();
+        cloud->points_.push_back(ScanPoint(1, 2, 3));
+        REQUIRE(cloud->points_[0] == ScanPoint(1, 2, 3));
+    }
+
+    SECTION("Acquire and release do not allocate")
+    {
+        // the control blocks are allocated on the first use of each cloud
+        {
+            auto a = pool->acquire();
+            auto b = pool->acquire();
+        }
+
+        size_t before = heap_allocations();
+        for (int i = 0; i < 1000; i++)
+        {
+            auto a = pool->acquire();
+            auto b = pool->acquire();
+            a->points_.resize(100);
+        }
+        size_t allocations = heap_allocations() - before;
+        REQUIRE(allocations == 0);
+    }
+}
+
+TEST_CASE("Velodyne_Steady_State", "[point_cloud_pool]")
+{
+    std::cout << "Testing 'Velodyne Steady State'" << std::endl;
+
+    constexpr size_t PACKETS_PER_SECOND = 754;
+
+    auto buffer = std::make_shared<PointCloudPtrStampedBuffer>(1);
+    VelodyneDecoder decoder{buffer};
+    auto now = util::HighResTime::now();
+
+    VelodynePacket packet{};
+    packet.mode = 0x37;
+    packet.produkt_id = 0x22;
+    uint16_t azimuth = 0;
+
+    // the next stage holds one scan while it works on it
+    PointCloudPtrStamped processed;
+    auto scan_for = [&](size_t num_packets)
+    {
+        for (size_t i = 0; i < num_packets; i++)
+        {
+            for (auto& block : packet.blocks)
+            {
+                block.flag = 0xEEFF;
+                block.azimuth = azimuth;
+                azimuth = (azimuth + 40) % 36000;
+                for (int p = 0; p < POINTS_IN_BLOCK; p++)
+                {
+                    block.points[p].distance = 1000 + i % 100;
+                }
+            }
+            decoder.decode_packet(packet, now);
+            buffer->pop_nb(&processed, 0);
+        }
+    };
+
+    // one second to reach the size of a scan
+    scan_for(PACKETS_PER_SECOND);
+    size_t pool_allocations = decoder.cloud_pool().allocations();
+
+    size_t before = heap_allocations();
+    scan_for(10 * PACKETS_PER_SECOND);
+    size_t allocations = heap_allocations() - before;
+
+    REQUIRE(allocations == 0);
+    REQUIRE(decoder.cloud_pool().allocations() == pool_allocations);
+
+    // 0.4 degree per block
+    REQUIRE(processed.data_->points_.size() == 900 * POINTS_IN_BLOCK);
+}
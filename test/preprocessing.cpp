@@ -18,9 +18,9 @@ TEST_CASE("Preprocessing", "[Preprocessing]")
     REQUIRE(1 == 1);
 
     auto pointcloud_buffer = std::make_shared<msg::PointCloudPtrStampedBuffer>(1);
-    auto pointcloud_bridge_buffer = std::make_shared<msg::PointCloudPtrStampedBuffer>(1);
+    auto pointcloud_bridge_buffer = std::make_shared<buffer::ScanBufferStampedBuffer>(1);
 
-    Preprocessing preprocessor{pointcloud_buffer, pointcloud_bridge_buffer, 0, false, false};
+    Preprocessing preprocessor{pointcloud_buffer, pointcloud_bridge_buffer, nullptr, 0, false, false};
     PointCloud::Ptr cloud = std::make_shared<PointCloud>();
     Stamped<PointCloud::Ptr> cloud_stamped;
     cloud_stamped.data_ = cloud;
@@ -95,6 +95,43 @@ TEST_CASE("Preprocessing", "[Preprocessing]")
         }
     }
 
+    SECTION("Test outlier filter"){
+
+        cloud_stamped.data_->points_[8] = {3000, 3000, 3000};
+
+        preprocessor.outlier_filter(cloud_stamped, 20.0f, 1);
+
+        for(uint32_t i = 0; i < points.size(); i++)
+        {
+            REQUIRE(cloud_stamped.data_->points_[i] == (i == 8 ? ScanPoint::Zero() : points[i]));
+        }
+
+        // not organized: the cloud is not changed
+        cloud_stamped.data_->points_.pop_back();
+        preprocessor.outlier_filter(cloud_stamped, 0.0f, 8);
+        REQUIRE(cloud_stamped.data_->points_.size() == 23);
+        REQUIRE(cloud_stamped.data_->points_[0] == points[0]);
+    }
+
+    SECTION("Test downsample filter"){
+
+        preprocessor.downsample_filter(cloud_stamped, 3);
+
+        std::vector<ScanPoint> result(8);
+        result[0] = {0, 0, 30}; //d = 30
+        result[2] = {30, 30, 10}; //d = 43.588989
+        result[4] = {10, 10, 30}; //d = 33.166248
+        result[6] = {50, 50, 10}; //d = 71.414284
+
+        result[1] = {20, 20, 20}; //d = 34.641016
+        result[3] = {30, 30, 40}; //d = 58.309519
+        result[5] = {0, 0, 40}; //d = 40
+        result[7] = {50, 50, 20}; //d = 73.484692
+
+        REQUIRE(cloud_stamped.data_->rings_ == 2);
+        REQUIRE(cloud_stamped.data_->points_ == result);
+    }
+
     SECTION("Test reduction filter average"){
 
         //n = 5
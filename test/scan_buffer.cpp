@@ -0,0 +1,75 @@
+/**
+ * @file scan_buffer.cpp
+ */
+
+#include <hw/buffer/scan_buffer.h>
+#include <hw/fpga_manager.h>
+
+#include "catch2_config.h"
+
+using namespace fastsense;
+using namespace fastsense::buffer;
+
+TEST_CASE("Scan_Buffer_Pool", "[scan_buffer_pool]")
+{
+    std::cout << "Testing 'Scan Buffer Pool'" << std::endl;
+
+    auto q = hw::FPGAManager::create_command_queue();
+    auto pool = std::make_shared<ScanBufferPool>(q);
+
+    SECTION("Buffers are reused")
+    {
+        ScanBuffer* first;
+        {
+            auto scan = pool->acquire(100);
+            REQUIRE(scan->num_points_ == 100);
+            REQUIRE(scan->points_.size() >= 100);
+            first = scan.get();
+        }
+        REQUIRE(pool->allocations() == 1);
+
+        auto scan = pool->acquire(80);
+        REQUIRE(scan.get() == first);
+        REQUIRE(scan->num_points_ == 80);
+        REQUIRE(pool->allocations() == 1);
+    }
+
+    SECTION("Shared buffers are not reused")
+    {
+        auto scan = pool->acquire(100);
+        auto shared = scan;
+        scan.reset();
+
+        auto other = pool->acquire(100);
+        REQUIRE(other.get() != shared.get());
+        REQUIRE(pool->allocations() == 2);
+
+        shared.reset();
+        other.reset();
+        auto again = pool->acquire(100);
+        REQUIRE(pool->allocations() == 2);
+    }
+
+    SECTION("Larger scans replace a buffer")
+    {
+        auto scan = pool->acquire(100);
+        size_t capacity = scan->points_.size();
+        scan.reset();
+
+        scan = pool->acquire(capacity + 1);
+        REQUIRE(scan->points_.size() > capacity);
+        REQUIRE(pool->allocations() == 2);
+    }
+
+    SECTION("Buffers outlive the pool")
+    {
+        auto scan = pool->acquire(10);
+        pool.reset();
+        scan->points_[9] = PointHW(1, 2, 3);
+
+        std::vector<ScanPoint> points;
+        scan->copy_to(points);
+        REQUIRE(points.size() == 10);
+        REQUIRE(points[9] == ScanPoint(1, 2, 3));
+    }
+}
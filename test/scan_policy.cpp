@@ -0,0 +1,76 @@
+/**
+ * @file scan_policy.cpp
+ */
+
+#include "catch2_config.h"
+#include <registration/scan_policy.h>
+
+#include <eigen3/Eigen/Geometry>
+
+using namespace fastsense;
+using namespace fastsense::registration;
+
+static Matrix4f translation(float x)
+{
+    Matrix4f pose = Matrix4f::Identity();
+    pose(0, 3) = x;
+    return pose;
+}
+
+TEST_CASE("ScanPolicy", "[ScanPolicy]")
+{
+    std::cout << "Testing 'ScanPolicy'" << std::endl;
+
+    Matrix4f still = Matrix4f::Identity();
+
+    SECTION("Disabled")
+    {
+        ScanPolicy policy(0.0f, 0.0f, 0, 0);
+        for (int i = 0; i < 5; i++)
+        {
+            policy.update(still, still);
+            REQUIRE(policy.decide(still, 3) == ScanDecision::FULL);
+        }
+    }
+
+    SECTION("Skip when stationary")
+    {
+        ScanPolicy policy(10.0f, 0.01f, 2, 5);
+
+        // no history yet
+        REQUIRE(policy.decide(still, 0) == ScanDecision::FULL);
+        policy.update(still, translation(1));
+        policy.update(translation(1), translation(2));
+        REQUIRE(policy.decide(still, 0) == ScanDecision::FULL);
+        policy.update(translation(2), translation(3));
+
+        // at most max_skipped scans in a row
+        REQUIRE(policy.decide(still, 0) == ScanDecision::SKIP);
+        REQUIRE(policy.decide(still, 0) == ScanDecision::SKIP);
+        REQUIRE(policy.decide(still, 0) == ScanDecision::REFINE);
+        REQUIRE(policy.decide(still, 0) == ScanDecision::SKIP);
+
+        // the IMU measures a rotation
+        Matrix4f rotated = Matrix4f::Identity();
+        rotated.block<3, 3>(0, 0) = Eigen::AngleAxisf(0.02f, Vector3f::UnitZ()).toRotationMatrix();
+        REQUIRE(policy.decide(rotated, 0) == ScanDecision::REFINE);
+    }
+
+    SECTION("Refine when slow or behind")
+    {
+        ScanPolicy policy(10.0f, 0.01f, 2, 5);
+        for (int i = 0; i < 3; i++)
+        {
+            policy.update(translation(i * 20), translation((i + 1) * 20));
+        }
+        REQUIRE(policy.decide(still, 0) == ScanDecision::REFINE);
+
+        policy.update(still, translation(200));
+        REQUIRE(policy.decide(still, 0) == ScanDecision::FULL);
+        REQUIRE(policy.decide(still, 1) == ScanDecision::REFINE);
+    }
+
+    REQUIRE(std::string(ScanPolicy::name(ScanDecision::FULL)) == "reg_full");
+    REQUIRE(std::string(ScanPolicy::name(ScanDecision::REFINE)) == "reg_refine");
+    REQUIRE(std::string(ScanPolicy::name(ScanDecision::SKIP)) == "reg_skip");
+}
@@ -0,0 +1,55 @@
+/**
+ * @file stage_occupancy.cpp
+ */
+
+#include "catch2_config.h"
+#include <util/stage_occupancy.h>
+
+#include <iostream>
+#include <thread>
+
+using namespace fastsense::util;
+using namespace std::chrono_literals;
+
+TEST_CASE("StageOccupancy", "[stage_occupancy]")
+{
+    std::cout << "Testing 'StageOccupancy'" << std::endl;
+
+    SECTION("Busy time and items")
+    {
+        StageOccupancy stage("test_stage");
+        REQUIRE(stage.items() == 0);
+
+        for (int i = 0; i < 5; i++)
+        {
+            stage.begin();
+            std::this_thread::sleep_for(10ms);
+            stage.end();
+            std::this_thread::sleep_for(10ms);
+        }
+        stage.begin();
+        stage.end(3);
+
+        REQUIRE(stage.items() == 8);
+        REQUIRE(stage.occupancy() > 0.3);
+        REQUIRE(stage.occupancy() < 0.7);
+        REQUIRE(stage.throughput() > 0.0);
+
+        stage.reset();
+        REQUIRE(stage.items() == 0);
+        REQUIRE(stage.occupancy() < 0.1);
+    }
+
+    SECTION("Stages are listed in the report while they exist")
+    {
+        {
+            StageOccupancy first("first_stage");
+            StageOccupancy second("second_stage");
+            auto report = PipelineOccupancy::get_instance().to_string();
+            REQUIRE(report.find("first_stage") != std::string::npos);
+            REQUIRE(report.find("second_stage") != std::string::npos);
+            REQUIRE(report.find("first_stage") < report.find("second_stage"));
+        }
+        REQUIRE(PipelineOccupancy::get_instance().to_string().find("first_stage") == std::string::npos);
+    }
+}
@@ -0,0 +1,282 @@
+/**
+ * @file thread_pool.cpp
+ */
+
+#include "catch2_config.h"
+#include <util/thread_pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+
+using namespace fastsense::util;
+
+/**
+ * @brief Checks that every index of the range was processed exactly once
+ */
+static bool all_once(const std::vector<std::atomic<int>>& counts)
+{
+    for (const auto& count : counts)
+    {
+        if (count.load() != 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("ThreadPool", "[thread_pool]")
+{
+    std::cout << "Testing 'ThreadPool'" << std::endl;
+
+    auto& pool = ThreadPool::get_instance();
+
+    SECTION("Without workers the loop runs on the calling thread")
+    {
+        pool.configure(0);
+        REQUIRE(pool.workers() == 0);
+        REQUIRE(pool.concurrency() == 1);
+
+        std::vector<size_t> order;
+        auto caller = std::this_thread::get_id();
+        bool same_thread = true;
+        pool.parallel_for(0, 100, [&](size_t i)
+        {
+            order.push_back(i);
+            same_thread = same_thread && std::this_thread::get_id() == caller;
+        });
+
+        std::vector<size_t> expected(100);
+        std::iota(expected.begin(), expected.end(), 0);
+        REQUIRE(order == expected);
+        REQUIRE(same_thread);
+    }
+
+    SECTION("Every index is processed once")
+    {
+        pool.configure(3);
+        REQUIRE(pool.workers() == 3);
+        REQUIRE(pool.concurrency() == 4);
+
+        for (size_t size : {0ul, 1ul, 7ul, 1000ul, 100000ul})
+        {
+            std::vector<std::atomic<int>> counts(size);
+            pool.parallel_for(0, size, [&](size_t i)
+            {
+                counts[i]++;
+            });
+            REQUIRE(all_once(counts));
+        }
+
+        // a partial range with a large grain
+        std::vector<std::atomic<int>> counts(1000);
+        pool.parallel_for(100, 900, [&](size_t i)
+        {
+            counts[i]++;
+        }, 256);
+        for (size_t i = 0; i < counts.size(); i++)
+        {
+            REQUIRE(counts[i].load() == (i >= 100 && i < 900 ? 1 : 0));
+        }
+    }
+
+    SECTION("Loops of several threads and nested loops")
+    {
+        pool.configure(3);
+
+        constexpr size_t CALLERS = 4;
+        constexpr size_t SIZE = 20000;
+        std::vector<std::vector<std::atomic<int>>> counts(CALLERS);
+        for (auto& c : counts)
+        {
+            c = std::vector<std::atomic<int>>(SIZE);
+        }
+
+        std::vector<std::thread> callers;
+        for (size_t caller = 0; caller < CALLERS; caller++)
+        {
+            callers.emplace_back([&, caller]()
+            {
+                ThreadPool::set_priority(static_cast<int>(caller));
+                for (int repeat = 0; repeat < 20; repeat++)
+                {
+                    pool.parallel_for(0, 4, [&](size_t outer)
+                    {
+                        pool.parallel_for(outer * SIZE / 4, (outer + 1) * SIZE / 4, [&](size_t i)
+                        {
+                            counts[caller][i]++;
+                        });
+                    });
+                }
+            });
+        }
+        for (auto& caller : callers)
+        {
+            caller.join();
+        }
+
+        for (auto& c : counts)
+        {
+            for (auto& count : c)
+            {
+                REQUIRE(count.load() == 20);
+            }
+        }
+    }
+
+    SECTION("The workers run a loop with the priority of the calling thread")
+    {
+        pool.configure(2);
+        ThreadPool::set_priority(7);
+
+        std::atomic<bool> priorities_match{true};
+        pool.parallel_for(0, 10000, [&](size_t)
+        {
+            if (ThreadPool::priority() != 7)
+            {
+                priorities_match = false;
+            }
+        });
+        REQUIRE(priorities_match);
+
+        int other = -1;
+        std::thread([&]()
+        {
+            other = ThreadPool::priority();
+        }).join();
+        REQUIRE(other == 0);
+
+        ThreadPool::set_priority(0);
+    }
+
+    SECTION("A worker is not kept off the CPU by a thread below the real-time priority of the caller")
+    {
+        using namespace std::chrono_literals;
+
+        // the worker and a busy real-time competitor share one CPU, the caller has a higher priority than the competitor
+        ThreadSettings worker_settings;
+        worker_settings.cpus = {0};
+        pool.configure(1, worker_settings);
+
+        ThreadSettings caller_settings = worker_settings;
+        caller_settings.priority = 20;
+        ThreadSettings competitor_settings = worker_settings;
+        competitor_settings.priority = 10;
+
+        std::atomic<bool> configured{false};
+        std::atomic<bool> worker_started{false};
+        std::atomic<bool> done{false};
+        std::atomic<bool> realtime{false};
+        std::atomic<int> worker_priority{-1};
+        std::chrono::steady_clock::duration loop_time{};
+
+        std::thread competitor([&]()
+        {
+            while (!worker_started && !done)
+            {
+                std::this_thread::sleep_for(1ms);
+            }
+            auto start = std::chrono::steady_clock::now();
+            while (!done && std::chrono::steady_clock::now() - start < 2s)
+            {
+            }
+        });
+        competitor_settings.apply(competitor);
+
+        std::thread caller([&]()
+        {
+            while (!configured)
+            {
+                std::this_thread::sleep_for(1ms);
+            }
+
+            int policy;
+            sched_param param{};
+            pthread_getschedparam(pthread_self(), &policy, &param);
+            realtime = policy == SCHED_FIFO;
+
+            auto caller_id = std::this_thread::get_id();
+            auto start = std::chrono::steady_clock::now();
+            pool.parallel_for(0, 2, [&](size_t)
+            {
+                if (std::this_thread::get_id() == caller_id)
+                {
+                    // keeps the second chunk for the worker
+                    auto wait_start = std::chrono::steady_clock::now();
+                    while (!worker_started && std::chrono::steady_clock::now() - wait_start < 1s)
+                    {
+                        std::this_thread::sleep_for(1ms);
+                    }
+                    return;
+                }
+
+                int worker_policy;
+                sched_param worker_param{};
+                pthread_getschedparam(pthread_self(), &worker_policy, &worker_param);
+                worker_priority = worker_policy == SCHED_FIFO ? worker_param.sched_priority : 0;
+                worker_started = true;
+
+                // 100 ms of CPU time, which the worker only gets if it is not below the competitor
+                timespec cpu_start, cpu_now;
+                clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+                do
+                {
+                    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_now);
+                }
+                while ((cpu_now.tv_sec - cpu_start.tv_sec) * 1000000000L + (cpu_now.tv_nsec - cpu_start.tv_nsec) < 100000000L);
+            });
+            loop_time = std::chrono::steady_clock::now() - start;
+            done = true;
+        });
+        caller_settings.apply(caller);
+        configured = true;
+
+        caller.join();
+        done = true;
+        competitor.join();
+
+        if (!realtime)
+        {
+            WARN("SCHED_FIFO is not permitted, the priority inheritance is not tested");
+        }
+        else
+        {
+            REQUIRE(worker_priority == 20);
+            REQUIRE(loop_time < 1s);
+        }
+    }
+
+    SECTION("An exception stops the loop and is rethrown")
+    {
+        pool.configure(3);
+
+        std::atomic<size_t> processed{0};
+        REQUIRE_THROWS_AS(pool.parallel_for(0, 100000, [&](size_t i)
+        {
+            processed++;
+            if (i == 500)
+            {
+                throw std::runtime_error("test");
+            }
+        }), std::runtime_error);
+        REQUIRE(processed.load() < 100000);
+
+        // the pool is still usable
+        std::vector<std::atomic<int>> counts(1000);
+        pool.parallel_for(0, counts.size(), [&](size_t i)
+        {
+            counts[i]++;
+        });
+        REQUIRE(all_once(counts));
+    }
+
+    pool.configure(0);
+}
@@ -0,0 +1,62 @@
+/**
+ * @file thread_settings.cpp
+ */
+
+#include "catch2_config.h"
+#include <util/thread_settings.h>
+
+#include <atomic>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+
+using namespace fastsense::util;
+
+TEST_CASE("ThreadSettings", "[thread_settings]")
+{
+    std::cout << "Testing 'ThreadSettings'" << std::endl;
+
+    SECTION("Parse CPU lists")
+    {
+        REQUIRE(ThreadSettings::parse("test", "", 0).cpus.empty());
+        REQUIRE(ThreadSettings::parse("test", "1", 0).cpus == std::vector<int>{1});
+        REQUIRE(ThreadSettings::parse("test", "0,2-3", 0).cpus == std::vector<int>{0, 2, 3});
+        REQUIRE(ThreadSettings::parse("a_very_long_thread_name", "", 0).name == "a_very_long_thr");
+
+        REQUIRE_THROWS(ThreadSettings::parse("test", "a", 0));
+        REQUIRE_THROWS(ThreadSettings::parse("test", "1-", 0));
+        REQUIRE_THROWS(ThreadSettings::parse("test", "3-1", 0));
+        REQUIRE_THROWS(ThreadSettings::parse("test", "-1", 0));
+        REQUIRE_THROWS(ThreadSettings::parse("test", "0", -1));
+        REQUIRE_THROWS(ThreadSettings::parse("test", "0", 100));
+    }
+
+    SECTION("Apply to a thread")
+    {
+        std::atomic<bool> running{true};
+        std::thread thread([&]()
+        {
+            while (running)
+            {
+                std::this_thread::yield();
+            }
+        });
+
+        // a real-time priority needs privileges, without them it is only logged
+        REQUIRE_NOTHROW(ThreadSettings::parse("settings_test", "0", 10).apply(thread));
+
+        char name[16] = "";
+        REQUIRE(pthread_getname_np(thread.native_handle(), name, sizeof(name)) == 0);
+        REQUIRE(std::string(name) == "settings_test");
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        REQUIRE(pthread_getaffinity_np(thread.native_handle(), sizeof(set), &set) == 0);
+        REQUIRE(CPU_COUNT(&set) == 1);
+        REQUIRE(CPU_ISSET(0, &set));
+
+        running = false;
+        thread.join();
+    }
+}
@@ -0,0 +1,208 @@
+/**
+ * @file velodyne_pcap.cpp
+ */
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <driver/lidar/velodyne_pcap.h>
+
+#include "catch2_config.h"
+
+using namespace fastsense;
+using namespace fastsense::driver;
+using namespace fastsense::msg;
+
+/// Packets per second of the sensor at 10 Hz
+constexpr int PACKETS_PER_SECOND = 754;
+
+/**
+ * @brief Writes Velodyne packets as Ethernet frames to a pcap file with microsecond timestamps.
+ */
+class PcapWriter
+{
+public:
+    explicit PcapWriter(const std::string& path) : file_{path, std::ios::binary}
+    {
+        write_u32(0xa1b2c3d4);
+        write_u16(2);
+        write_u16(4);
+        write_u32(0);
+        write_u32(0);
+        write_u32(65535);
+        write_u32(1);
+    }
+
+    void write(const VelodynePacket& packet, uint16_t port, uint64_t time_us, bool vlan = false)
+    {
+        std::vector<uint8_t> frame(12, 0);
+        if (vlan)
+        {
+            push_be16(frame, 0x8100);
+            push_be16(frame, 1);
+        }
+        push_be16(frame, 0x0800);
+
+        // IPv4 header without options
+        size_t ip_start = frame.size();
+        frame.insert(frame.end(), {0x45, 0, 0, 0, 0, 0, 0x40, 0, 64, 17, 0, 0, 192, 168, 1, 201, 255, 255, 255, 255});
+        uint16_t ip_length = 20 + 8 + sizeof(VelodynePacket);
+        frame[ip_start + 2] = ip_length >> 8;
+        frame[ip_start + 3] = ip_length & 0xFF;
+
+        // UDP header
+        push_be16(frame, 2368);
+        push_be16(frame, port);
+        push_be16(frame, 8 + sizeof(VelodynePacket));
+        push_be16(frame, 0);
+
+        const auto* data = reinterpret_cast<const uint8_t*>(&packet);
+        frame.insert(frame.end(), data, data + sizeof(VelodynePacket));
+
+        write_u32(time_us / 1000000);
+        write_u32(time_us % 1000000);
+        write_u32(frame.size());
+        write_u32(frame.size());
+        file_.write(reinterpret_cast<const char*>(frame.data()), frame.size());
+    }
+
+private:
+    static void push_be16(std::vector<uint8_t>& data, uint16_t value)
+    {
+        data.push_back(value >> 8);
+        data.push_back(value & 0xFF);
+    }
+
+    void write_u16(uint16_t value)
+    {
+        file_.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void write_u32(uint32_t value)
+    {
+        file_.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    std::ofstream file_;
+};
+
+/**
+ * @brief Packet of a spinning sensor at 10 Hz, continuing at the given azimuth
+ */
+static VelodynePacket next_packet(uint16_t& azimuth)
+{
+    VelodynePacket packet{};
+    packet.mode = 0x37;
+    packet.produkt_id = 0x22;
+    for (auto& block : packet.blocks)
+    {
+        block.flag = 0xEEFF;
+        block.azimuth = azimuth;
+        azimuth = (azimuth + 40) % 36000;
+        for (auto& point : block.points)
+        {
+            point.distance = 1000;
+        }
+    }
+    return packet;
+}
+
+TEST_CASE("Velodyne_Pcap", "[velodyne_pcap]")
+{
+    std::cout << "Testing 'Velodyne Pcap'" << std::endl;
+
+    auto path = (std::filesystem::temp_directory_path() / "velodyne_pcap_test.pcap").string();
+
+    // 2 s of packets, with a packet to another port, a VLAN tagged packet and a gap of 1 s after the first scan
+    constexpr int NUM_PACKETS = 2 * PACKETS_PER_SECOND;
+    constexpr uint64_t START_US = 1600000000ull * 1000000;
+    constexpr uint64_t PACKET_US = 1000000 / PACKETS_PER_SECOND;
+    std::vector<uint64_t> scan_times;
+    {
+        PcapWriter writer{path};
+        uint16_t azimuth = 0;
+        uint16_t last_azimuth = 0;
+        uint64_t time = START_US;
+        for (int i = 0; i < NUM_PACKETS; i++)
+        {
+            auto packet = next_packet(azimuth);
+            for (const auto& block : packet.blocks)
+            {
+                if (block.azimuth < last_azimuth)
+                {
+                    // the packet that overflows the azimuth completes the scan
+                    scan_times.push_back(time);
+                }
+                last_azimuth = block.azimuth;
+            }
+            writer.write(packet, 2368, time, i == 10);
+            if (i == 20)
+            {
+                writer.write(packet, 8308, time + 1);
+            }
+            time += i == PACKETS_PER_SECOND / 10 ? 1000000 : PACKET_US;
+        }
+    }
+
+    auto buffer = std::make_shared<PointCloudPtrStampedBuffer>(1);
+
+    SECTION("Replay as fast as possible")
+    {
+        VelodynePcapDriver driver{path, 2368, 0.f, buffer};
+        driver.start();
+
+        std::vector<util::HighResTimePoint> stamps;
+        PointCloudPtrStamped scan;
+        auto start = std::chrono::steady_clock::now();
+        while (!driver.finished() || !buffer->empty())
+        {
+            if (buffer->pop_nb(&scan, 10))
+            {
+                stamps.push_back(scan.timestamp_);
+                REQUIRE(scan.data_->points_.size() > 0);
+            }
+            REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+        }
+        driver.stop();
+
+        // no scan is dropped and the gaps between the scans are the ones of the recording
+        REQUIRE(driver.packets_replayed() == NUM_PACKETS);
+        REQUIRE(stamps.size() == scan_times.size());
+        for (size_t i = 1; i < stamps.size(); i++)
+        {
+            auto recorded = std::chrono::microseconds(scan_times[i] - scan_times[i - 1]);
+            REQUIRE(std::chrono::duration_cast<std::chrono::microseconds>(stamps[i] - stamps[i - 1]) == recorded);
+        }
+    }
+
+    SECTION("Replay with scaled timing")
+    {
+        // the first 1.1 s of the recording at 4 times the speed
+        VelodynePcapDriver driver{path, 2368, 4.f, buffer};
+        auto start = std::chrono::steady_clock::now();
+        driver.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        driver.stop();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        REQUIRE(driver.packets_replayed() > PACKETS_PER_SECOND / 10);
+        REQUIRE(driver.packets_replayed() < PACKETS_PER_SECOND / 2);
+        REQUIRE_FALSE(driver.finished());
+        REQUIRE(elapsed < std::chrono::milliseconds(500));
+    }
+
+    SECTION("Invalid files are rejected")
+    {
+        REQUIRE_THROWS(VelodynePcapDriver{path + ".missing", 2368, 1.f, buffer});
+        {
+            std::ofstream file{path, std::ios::binary};
+            file << "not a pcap file, but long enough";
+        }
+        REQUIRE_THROWS(VelodynePcapDriver{path, 2368, 1.f, buffer});
+    }
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,120 @@
+/**
+ * @file voxel_size_controller.cpp
+ */
+
+#include "catch2_config.h"
+#include <preprocessing/voxel_size_controller.h>
+#include <preprocessing/voxel_grid.h>
+
+#include <cmath>
+
+using namespace fastsense;
+using namespace fastsense::preprocessing;
+
+/**
+ * @brief Number of reduced points of a surface scan that has num_points at the map resolution
+ */
+static int surface_points(int num_points, int voxel_size)
+{
+    float ratio = static_cast<float>(MAP_RESOLUTION) / voxel_size;
+    return num_points * ratio * ratio;
+}
+
+TEST_CASE("VoxelSizeController", "[VoxelSizeController]")
+{
+    std::cout << "Testing 'VoxelSizeController'" << std::endl;
+
+    SECTION("Disabled")
+    {
+        VoxelSizeController controller(0, 0.1f, MAP_RESOLUTION, 4 * MAP_RESOLUTION);
+        REQUIRE(!controller.active());
+        REQUIRE(controller.update(100000) == MAP_RESOLUTION);
+    }
+
+    SECTION("Converges to the budget and holds")
+    {
+        VoxelSizeController controller(10000, 0.1f, MAP_RESOLUTION, 8 * MAP_RESOLUTION);
+
+        int voxel_size = controller.voxel_size();
+        for (int i = 0; i < 10; i++)
+        {
+            voxel_size = controller.update(surface_points(40000, voxel_size));
+        }
+        REQUIRE(std::abs(surface_points(40000, voxel_size) - 10000) <= 1000);
+
+        // small changes within the band do not change the voxel size
+        int settled = voxel_size;
+        REQUIRE(controller.update(10900) == settled);
+        REQUIRE(controller.update(9200) == settled);
+    }
+
+    SECTION("Hysteresis")
+    {
+        VoxelSizeController controller(10000, 0.2f, MAP_RESOLUTION, 8 * MAP_RESOLUTION);
+
+        // outside of the band: correction starts
+        int voxel_size = controller.update(40000);
+        REQUIRE(voxel_size == 2 * MAP_RESOLUTION);
+
+        // within the band, but not within half of it: correction goes on
+        voxel_size = controller.update(11500);
+        REQUIRE(voxel_size > 2 * MAP_RESOLUTION);
+
+        // within half of the band: correction stops
+        int settled = controller.update(10500);
+        REQUIRE(controller.update(11500) == settled);
+    }
+
+    SECTION("Reset")
+    {
+        VoxelSizeController controller(10000, 0.2f, MAP_RESOLUTION, 8 * MAP_RESOLUTION);
+
+        REQUIRE(controller.update(40000) == 2 * MAP_RESOLUTION);
+
+        // starts again with the smallest voxel size and without a running correction
+        controller.reset();
+        REQUIRE(controller.voxel_size() == MAP_RESOLUTION);
+        REQUIRE(controller.update(11500) == MAP_RESOLUTION);
+    }
+
+    SECTION("Limits")
+    {
+        VoxelSizeController controller(100, 0.1f, MAP_RESOLUTION, 2 * MAP_RESOLUTION);
+
+        // at most a factor of two per scan, within the limits
+        REQUIRE(controller.update(1000000) == 2 * MAP_RESOLUTION);
+        REQUIRE(controller.update(1000000) == 2 * MAP_RESOLUTION);
+        REQUIRE(controller.update(1) == MAP_RESOLUTION);
+        REQUIRE(controller.update(0) == MAP_RESOLUTION);
+    }
+}
+
+TEST_CASE("VoxelGrid_Size", "[VoxelGrid]")
+{
+    std::cout << "Testing 'VoxelGrid Size'" << std::endl;
+
+    VoxelGrid grid;
+
+    SECTION("Default")
+    {
+        REQUIRE(grid.voxel_size() == MAP_RESOLUTION);
+        REQUIRE(grid.voxel(ScanPoint(-1, 63, 64)) == ScanPoint(-1, 0, 1));
+    }
+
+    SECTION("Not a power of two")
+    {
+        grid.set_voxel_size(96);
+        REQUIRE(grid.voxel(ScanPoint(-1, 95, 96)) == ScanPoint(-1, 0, 1));
+        REQUIRE(grid.voxel(ScanPoint(-96, -97, -192)) == ScanPoint(-1, -2, -2));
+        REQUIRE(grid.voxel_center(ScanPoint(100, -1, 0)) == ScanPoint(144, -48, 48));
+
+        std::vector<ScanPoint> points{{10, 10, 10}, {90, 90, 90}, {100, 10, 10}, {-10, 10, 10}, {0, 0, 0}};
+        grid.build(points);
+        REQUIRE(grid.num_voxels() == 3);
+    }
+
+    SECTION("Invalid")
+    {
+        REQUIRE_THROWS(grid.set_voxel_size(0));
+    }
+}